@@ -154,160 +154,305 @@
 
  ***/
 
+#define _POSIX_C_SOURCE 199309L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <math.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/stat.h>
 #include "graph.h"
 #include "queue.h"
 #include "list.h"
+#include "dijkstra.h"
+#include "turns.h"
+#include "multirobot.h"
+#include "stplan.h"
+#include "coverage.h"
+#include "mapfile.h"
+#include "search.h"
+#include "cache.h"
+#include "runs.h"
+#include "landmarks.h"
+#include "jobs.h"
+#include "perfcount.h"
+#include "memstat.h"
+#include "rle.h"
+#include "results.h"
+#include "snapshot.h"
+#include "dobfs.h"
+#include "distmap.h"
 #include <malloc.h>
 
- /* Si può usare il simbolo NODE_UNDEF per indicare che il predecessore
-    della lista dei padri non esiste. */
-const int NODE_UNDEF = -1;
-
-/* Visita il grafo g usando l'algoritmo di visita in ampiezza (BFS)
-   partendo dal nodo sorgente s. Restituisce il numero di nodi
-   visitati (incluso s). */
-int bfs(const Graph* g,
-    int s,  /* Nodo sorgente */
-    int* d, /* d[i] e' la distanza del nodo `i` dalla sorgente
-               `s`, dove la distanza e' intesa come minimo numero
-               di archi che collegano la sorgente al nodo
-               `i`. Questo array deve essere allocato dal
-               chiamante e contenere `n` elementi (uno per ogni
-               nodo del grafo) */
-    int* p  /* array di predecessori; `p[i]` è il predecessore
-               del nodo `i` lungo il cammino minimo da `s` a
-               `i`. Nel caso in cui `i` non sia raggiungibile
-               dalla sorgente, `p[i] = -1`. Anche questo array
-               deve essere allocato dal chiamante e avere
-               lunghezza `n` */
-)
+/*
+* Legge dal file `f` (di nome `name`) le richieste, una per riga,
+* nella forma "nodo_sorgente nodo_destinazione"; le righe vuote
+* vengono ignorate. Restituisce il numero di richieste e in `*srcs` e
+* `*dsts` due array allocati con mem_alloc(MEM_SEARCH, ...), oppure -1
+* se il file non e'
+* valido.
+*/
+int queries_from_file(FILE* f, const char* name, int** srcs, int** dsts)
 {
-    /* È possibile fare a meno dell'array `color`.  Per capire se un
-       nodo è stato visitato, basta controllare se la sua distanza è
-       maggiore o uguale a zero oppure no. I nodi non visitati hanno
-       distanza negativa. */
-    const int n = graph_n_nodes(g);
-    List* l;
-    int nvisited = 0;
-    int i;
-
-    assert((s >= 0) && (s < n));
-
-    for (i = 0; i < n; i++) {
-        d[i] = -1;
-        p[i] = NODE_UNDEF;
-    }
-
-    d[s] = 0;
-    l = list_create();
-    list_add_first(l, s);
-
-    while (!list_is_empty(l)) {
-        const int u = list_remove_first(l);
-        const Edge* edge;
-        nvisited++;
-        for (edge = graph_adj(g, u); edge != NULL; edge = edge->next) {
-            const int v = edge->d;
-            assert(u == edge->s); 
-            if (d[v] < 0 && edge->weight > -1) {
-                d[v] = d[u] + 1;
-                p[v] = u;
-                list_add_last(l, v);
+    char line[256];
+    char extra;
+    int k = 0, cap = 64, lineno = 0, s, d;
+
+    *srcs = (int*)mem_alloc(MEM_SEARCH, cap * sizeof(**srcs));
+    *dsts = (int*)mem_alloc(MEM_SEARCH, cap * sizeof(**dsts));
+    assert(*srcs != NULL && *dsts != NULL);
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        if (1 == sscanf(line, " %c", &extra) ) {
+            if (2 != sscanf(line, "%d %d %c", &s, &d, &extra)) {
+                fprintf(stderr, "%s:%d: richiesta non valida, attesi nodo_sorgente e nodo_destinazione\n", name, lineno);
+                mem_free(MEM_SEARCH, *srcs);
+                mem_free(MEM_SEARCH, *dsts);
+                return -1;
+            }
+            if (k == cap) {
+                cap *= 2;
+                *srcs = (int*)mem_realloc(MEM_SEARCH, *srcs, cap * sizeof(**srcs));
+                *dsts = (int*)mem_realloc(MEM_SEARCH, *dsts, cap * sizeof(**dsts));
+                assert(*srcs != NULL && *dsts != NULL);
             }
+            (*srcs)[k] = s;
+            (*dsts)[k] = d;
+            k++;
         }
-        printf("\n");
     }
-    list_destroy(l);
-    return nvisited;
+    return k;
 }
 
-/* Stampa il cammino che va da `s` a `d` prodotto dalla visita in
-   ampiezza; se `d` non è raggiungibile da `s`, stampa "Non
-   raggiungibile". La stampa del cammino deve avere la forma:
-
-   s->n1->n2->...->d
-
-   dove n1, n2... sono gli interi che individuano i nodi
-   attraversati. */
-void print_path(int s, int d, const int* p)
+/*
+* Apre il file di output `name` in scrittura ("-" indica lo standard
+* output); in caso di errore restituisce NULL
+*/
+FILE* open_output(const char* name)
 {
-    if (s == d)
-        printf("%d", s);
-    else if (p[d] < 0)
-        printf("Non raggiungibile");
-    else {
-        print_path(s, p[d], p);
-        printf("->%d", d);
-    }
+    FILE* f;
+
+    if (strcmp(name, "-") == 0)
+        return stdout;
+    f = fopen(name, "w");
+    if (f == NULL)
+        fprintf(stderr, "Can not open %s\n", name);
+    return f;
 }
 
-/* Stampa le distanze di tutti i nodi dal nodo `src`, e i cammini per
-   raggiungere tutti i nodi del grafo da `src`. I cammini sono quelli
-   prodotti dalla visita in ampiezza. L'array `p[]` indica l'array dei
-   predecessori, cioè `p[i]` è il predecessore del nodo `i`
-   nell'albero corrispondente alla visita BFS. */
-void print_bfs(const Graph* g, int src, const int* d, const int* p)
+/*
+* Restituisce, in una stringa allocata con mem_alloc(MEM_MAP, ...), il
+* nome `name`
+* con l'estensione `ext` al posto dell'estensione .in (oppure in
+* aggiunta, se `name` non termina con .in)
+*/
+char* replace_extension(const char* name, const char* ext)
 {
-    const int n = graph_n_nodes(g);
-    int v;
+    size_t len = strlen(name);
+    char* s;
+
+    if (len >= 3 && strcmp(name + len - 3, ".in") == 0)
+        len -= 3;
+    s = (char*)mem_alloc(MEM_MAP, len + strlen(ext) + 1);
+    assert(s != NULL);
+    memcpy(s, name, len);
+    strcpy(s + len, ext);
+    return s;
+}
+
+/*
+* Pesi dell'impronta calcolati durante la lettura della mappa (-P)
+*/
+typedef struct {
+    signed char* w;     /* pesi delle posizioni, n * m                  */
+    int done;           /* righe di cui sono gia' stati calcolati i pesi */
+} Clearance;
 
-    assert(p != NULL);
-    assert(d != NULL);
+/*
+* Chiamata da map_stream() quando sono pronte le righe da 0 a
+* `nready` - 1: calcola i pesi delle righe che hanno gia' anche la
+* riga successiva, coperta dall'impronta
+*/
+void clearance_rows(char** matrix, int n, int m, int nready, void* arg)
+{
+    Clearance* c = (Clearance*)arg;
+    const int upto = (nready == n) ? n : nready - 1;
 
-    printf("  src | dest | distanza | path\n");
-    printf("------+------+----------+-------------------------\n");
-    for (v = 0; v < n; v++) {
-        printf(" %4d | %4d | %8d | ", src, v, d[v]);
-        print_path(src, v, p);
-        printf("\n");
+    if (c->w == NULL) {
+        c->w = (signed char*)mem_alloc(MEM_GRAPH, (size_t)n * m);
+        assert(c->w != NULL);
+    }
+    if (upto > c->done) {
+        graph_footprint_weights(matrix, n, m, c->done, upto, c->w);
+        c->done = upto;
     }
 }
 
 /*
-* Crea le colonne di una matrice (rows x cols)
+* Scrive sul file `f` un cammino trovato sugli intervalli, nello stesso
+* formato di `path_write_to_file()`, con le mosse compresse se `rle`
+* e' diverso da zero
 */
-void set_cols(int** arr, size_t rows, size_t cols) {
-    int i;
-    for (i = 0; i < rows; i++)
-        arr[i] = malloc(sizeof * arr[i] * cols);
+void run_path_write(FILE* f, const RunPath* rp, int rle)
+{
+    fprintf(f, "%d\n", rp->length);
+    if (rp->length >= 0 && rle)
+        rle_write_moves(f, rp->moves);
+    else if (rp->length >= 0)
+        fprintf(f, "%s", rp->moves);
 }
 
 /*
-* Inizializza la matrice con i valori letti da un file
+* Scrive sul file `f` il percorso `path` a partire da `src`, con
+* `header` nella prima riga, nel formato di `path_cost_write_to_file()`
+* oppure, se `rle` e' diverso da zero, con le mosse compresse
 */
-int** matrix_from_file(FILE* f)
+void output_path(FILE* f, Graph* g, const List* path, int src, int header, int rle)
 {
-    int **matrix, retValue, i, j, n, m;
-    char c;
-
-    assert(f != NULL);
+    if (rle)
+        rle_write_path(f, g, path, src, header);
+    else
+        path_cost_write_to_file(f, g, path, src, header);
+}
 
-    if (2 != fscanf(f, "%d %d ", &n, &m)) {
-        fprintf(stderr, "ERRORE durante la lettura dell'intestazione del file\n");
-        abort();
+/*
+* Espande le mosse del file `name`, scritto con l'opzione -z oppure
+* con -b, e scrive il risultato nel file `outputFile` (per default lo
+* standard output). Il file viene aperto una sola volta e il formato
+* si riconosce dai primi byte, quindi `name` puo' essere anche una
+* pipe; un file binario deve pero' essere un file regolare, perche'
+* viene mappato in memoria.
+* Restituisce lo stato di uscita del programma.
+*/
+int run_decode(const char* name, const char* outputFile)
+{
+    FILE* in = stdin;
+    FILE* out;
+    ResultFile rf;
+    char head[RESULTS_MAGIC_SIZE];
+    struct stat st;
+    size_t nhead;
+    long k;
+
+    if (strcmp(name, "-") != 0) {
+        in = fopen(name, "r");
+        if (in == NULL) {
+            fprintf(stderr, "Can not open %s\n", name);
+            return EXIT_FAILURE;
+        }
+    }
+    nhead = fread(head, 1, sizeof(head), in);
+    if (results_is_binary(head, nhead)) {
+        if (in == stdin || fstat(fileno(in), &st) != 0 || !S_ISREG(st.st_mode)) {
+            fprintf(stderr, "%s: un file binario deve essere un file regolare\n", name);
+            if (in != stdin) fclose(in);
+            return EXIT_FAILURE;
+        }
+        fclose(in);
+        if (results_open(name, &rf) != 0) {
+            fprintf(stderr, "%s: file binario non valido\n", name);
+            return EXIT_FAILURE;
+        }
+        out = open_output(outputFile != NULL ? outputFile : "-");
+        if (out == NULL) {
+            results_close(&rf);
+            return EXIT_FAILURE;
+        }
+        k = results_write_text(&rf, out);
+        results_close(&rf);
+        if (out != stdout) fclose(out);
+        else fflush(out);
+        fprintf(stderr, "# %ld mosse decodificate\n", k);
+        return EXIT_SUCCESS;
+    }
+    out = open_output(outputFile != NULL ? outputFile : "-");
+    if (out == NULL) {
+        if (in != stdin) fclose(in);
+        return EXIT_FAILURE;
+    }
+    /* i byte letti per riconoscere il formato sono l'inizio del testo */
+    k = rle_decode(head, nhead, in, out);
+    if (in != stdin) fclose(in);
+    if (out != stdout) fclose(out);
+    else fflush(out);
+    if (k < 0) {
+        fprintf(stderr, "%s: formato compresso non valido\n", name);
+        return EXIT_FAILURE;
     }
+    fprintf(stderr, "# %ld mosse decodificate\n", k);
+    return EXIT_SUCCESS;
+}
 
-    assert(n >= 10);
-    assert(m <= 1000);
+/*
+* Restituisce i millisecondi trascorsi dall'istante `*t` e aggiorna
+* `*t` all'istante attuale
+*/
+double elapsed_ms(struct timespec* t)
+{
+    struct timespec now;
+    double ms;
 
-    matrix = malloc(sizeof * matrix * n);
-    set_cols(matrix, n, m);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ms = (now.tv_sec - t->tv_sec) * 1e3 + (now.tv_nsec - t->tv_nsec) / 1e6;
+    *t = now;
+    return ms;
+}
 
-    for (i = 0; i < n; i++) {
-        for (j = 0; j < m; j++) {
-            retValue = fscanf(f, "%c ", &c);
-            if (matrix && retValue == 1 && c != '\n') {
-                matrix[i][j] = c;   /* inizializzo la matrice con ciascun valore letto dal file */
-            }
-        }
+/*
+* Esegue le richieste del manifesto `manifest` con `nthreads` thread
+* (vedi `jobs_run()`) e scrive i risultati nel file `outputFile`, per
+* default il nome del manifesto con l'estensione .out. Restituisce lo
+* stato di uscita del programma.
+*/
+int run_manifest(const char* manifest, const char* outputFile, int nthreads, int stats, int memStats)
+{
+    FILE* f = fopen(manifest, "r");
+    FILE* fileout;
+    FILE* info = stdout;
+    char* derivedName = NULL;
+    struct timespec clock;
+    Job* jobs;
+    int njobs, nfailed;
+
+    if (f == NULL) {
+        fprintf(stderr, "Can not open %s\n", manifest);
+        return EXIT_FAILURE;
+    }
+    njobs = jobs_from_manifest(f, manifest, &jobs);
+    fclose(f);
+    if (njobs < 0)
+        return EXIT_FAILURE;
+    if (outputFile == NULL) {
+        derivedName = replace_extension(manifest, ".out");
+        outputFile = derivedName;
+    }
+    if (strcmp(outputFile, "-") == 0)
+        info = stderr;
+    fileout = open_output(outputFile);
+    if (fileout == NULL) {
+        jobs_free(jobs, njobs);
+        mem_free(MEM_MAP, derivedName);
+        return EXIT_FAILURE;
     }
 
-    return matrix;
+    clock_gettime(CLOCK_MONOTONIC, &clock);
+    nfailed = jobs_run(jobs, njobs, nthreads, fileout, info);
+    if (stats)
+        fprintf(info, "# tempo (ms): %.1f\n", elapsed_ms(&clock));
+    if (memStats)
+        mem_report(info);
+    if (fileout != stdout) {
+        fprintf(info, "File %s creato.\n", outputFile);
+        fclose(fileout);
+    }
+    jobs_free(jobs, njobs);
+    mem_free(MEM_MAP, derivedName);
+    if (memStats)
+        mem_check_released(info);
+    return nfailed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 /*
@@ -317,7 +462,7 @@ int** matrix_from_file(FILE* f)
 void get_path(int s, int d, const int* p, List* path)
 {
     if (s == d)
-        list_add_first(path, 0);
+        list_add_first(path, s);
     else if (p[d] < 0)
         return;
     else {
@@ -330,98 +475,956 @@ void get_path(int s, int d, const int* p, List* path)
 }
 
 /* 
-* il programma prende in input: nodo_sorgente nodo_destinazione nome_file
+* il programma prende in input: [opzioni] nodo_sorgente nodo_destinazione nome_file
 * Esempio: ./bfs 0 49 test1.in
+*
+* Opzioni:
+*   -w   modalita' pesata: il costo di ogni mossa dipende dal terreno
+*        coperto dal robot (vedi `terrain_cost()`), il cammino viene
+*        calcolato con Dijkstra (coda a bucket) e nel file di output
+*        viene riportato il costo totale anziche' il numero di mosse
+*   -t T modalita' con rotazioni: ogni rotazione di 90 gradi del robot
+*        costa T; il cammino minimizza mosse (o costo, con -w) piu'
+*        rotazioni e nel file di output viene riportato il costo totale
+*   -r s1,s2,...
+*        modalita' multi-robot: oltre al robot in nodo_sorgente ci sono
+*        altri robot nei nodi s1, s2, ... (al massimo MAX_ROBOTS in
+*        tutto) diretti alla stessa stazione; tutti i cammini vengono
+*        calcolati con una sola visita a partire dalla stazione e il
+*        file di output contiene un percorso per ogni robot
+*   -c s1:d1,s2:d2,...
+*        modalita' senza collisioni: oltre al robot che va da
+*        nodo_sorgente a nodo_destinazione ci sono altri robot che
+*        vanno da s1 a d1, da s2 a d2, ... (in ordine di priorita');
+*        i robot vengono pianificati nello spazio-tempo in modo che le
+*        impronte non si sovrappongano mai. Nel file di output, per
+*        ogni robot, l'istante di arrivo e le mosse (F = fermo)
+*   -j N legge la mappa e costruisce il grafo con N thread, ognuno su
+*        una fascia di righe della mappa (1 per default)
+*   -o F scrive il risultato nel file F anziche' in quello ottenuto
+*        sostituendo l'estensione .in del file della mappa con .out;
+*        con "-o -" il risultato viene scritto sullo standard output
+*   -l L ordine di numerazione interna dei nodi: "righe" (default),
+*        "quadrati" oppure "morton". I nodi indicati sulla riga di
+*        comando sono comunque numerati per righe
+*   -s   riporta i tempi di lettura, costruzione del grafo, ricerca e
+*        scrittura del risultato
+*   -z   scrive le mosse in formato compresso: ogni sequenza di mosse
+*        uguali diventa la mossa seguita dal numero di ripetizioni,
+*        per esempio S120E45N3 (vedi rle.c). Non si applica a -m
+*   -b   con -q scrive i risultati in formato binario: un record di
+*        dimensione fissa per richiesta (numero, raggiungibilita',
+*        lunghezza, posizione del percorso) e le mosse a 2 bit
+*        ciascuna (vedi results.h). Il file puo' essere mappato in
+*        memoria e il risultato i-esimo letto in tempo costante
+*   -u F espande le mosse del file F scritto con -z o con -b e scrive
+*        il risultato, in formato testuale, sullo standard output (o
+*        nel file indicato con -o)
+*   -M   riporta la memoria attuale e massima allocata da lettura
+*        della mappa, grafo, contesti di ricerca, liste, code e cache
+*        dei risultati (vedi memstat.c) e, al termine, quella non
+*        ancora liberata, anche se l'esecuzione si interrompe per un
+*        errore
+*   -e   riporta per le stesse fasi i contatori hardware (cicli,
+*        istruzioni, miss della cache di ultimo livello, salti mal
+*        previsti, miss del TLB dei dati; vedi perfcount.c), se il
+*        sistema li fornisce. Non si applica a -m e -u
+*   -q F modalita' a richieste multiple: il programma viene invocato
+*        con il solo nome del file della mappa e risponde alle
+*        richieste "nodo_sorgente nodo_destinazione" contenute nel
+*        file F, una per riga, sullo stesso grafo; il file di output
+*        contiene un percorso per ogni richiesta, nello stesso ordine
+*   -m F modalita' a manifesto: il programma viene invocato senza
+*        argomenti posizionali ed esegue le richieste "file_mappa
+*        nodo_sorgente nodo_destinazione" del file F, su piu' mappe,
+*        con un pool di -j thread (vedi jobs.c); ogni mappa viene
+*        letta una sola volta e il file di output contiene i percorsi
+*        nell'ordine del manifesto
+*   -k D usa come cache dei risultati la cartella D: se la stessa
+*        richiesta (nodi, opzioni -w, -t e -f) e' gia' stata fatta su una
+*        mappa con lo stesso contenuto, il risultato viene copiato dalla
+*        cache senza decodificare la mappa. Non si applica a -r, -c, -p
+*        e -q
+*   -K MB dimensione massima della cache in MB (64 per default); oltre
+*        questo limite vengono eliminati i risultati usati meno di
+*        recente, fino a tornare a circa tre quarti del limite
+*   -i   la ricerca lavora sugli intervalli di posizioni libere di
+*        ogni riga (vedi runs.c) invece che sul grafo delle posizioni:
+*        adatta alle mappe grandi con pochi ostacoli. La lunghezza del
+*        cammino e' la stessa della visita in ampiezza; non si applica
+*        a -w, -t, -r, -c e -p
+*   -g   il grafo viene salvato in un'istantanea binaria accanto al
+*        file della mappa, con estensione .grf, e le esecuzioni
+*        successive sulla stessa mappa (stesso contenuto, stessa
+*        numerazione) lo caricano con una sola mmap() senza
+*        decodificare la mappa (vedi snapshot.c). Non si applica a
+*        -i, -P, -c e -p
+*   -D M visita in ampiezza completa a partire da nodo_sorgente, per
+*        livelli, con i passi nella direzione M: "ibrida" (sceglie ad
+*        ogni livello), "alto" (dai nodi della frontiera ai vicini)
+*        oppure "basso" (dai nodi non raggiunti alla frontiera); vedi
+*        dobfs.c. Il cammino ha la stessa lunghezza di quello della
+*        visita normale. Non si applica a -q, -m, -w, -t, -r, -c, -p,
+*        -i e -a
+*   -f K il robot ha un'impronta quadrata di lato K (dispari, da 3 a
+*        DISTMAP_MAX_SIDE) invece di 3x3: le posizioni ammesse si
+*        ricavano dalla distanza di ogni posizione dal primo ostacolo
+*        (vedi distmap.c), salvata accanto al file della mappa con
+*        estensione .dst e riutilizzata per qualunque impronta dalle
+*        esecuzioni successive sulla stessa mappa. Non si applica a
+*        -w, -r, -c, -p, -i, -P e -m
+*   -a K la ricerca usa A* con K landmark (al massimo LANDMARKS_MAX,
+*        vedi landmarks.c): le distanze dai landmark vengono salvate
+*        nel file della mappa con estensione .alt e riutilizzate dalle
+*        esecuzioni successive sulla stessa mappa. Non si applica a
+*        -i, -w, -t, -r, -c e -p
+*   -P   la mappa viene letta da un thread separato a blocchi, e i pesi
+*        delle posizioni vengono calcolati man mano che arrivano le
+*        righe, mentre la lettura prosegue (vedi `map_stream()`). Non
+*        si applica a -i, -a e -k
+*   -p   modalita' pulizia: il robot parte da nodo_sorgente, passa con
+*        l'impronta su tutto il pavimento raggiungibile e termina sulla
+*        stazione nodo_destinazione; a video vengono riportate la
+*        percentuale di pavimento coperta e la lunghezza del percorso
 */
 int main(int argc, char* argv[])
 {
-    Graph* G;
-    int** matrix;
+    Graph* G = NULL;
+    char** matrix = NULL;
     int nvisited; /* n. di nodi raggiungibili dalla sorgente */
-    int* p, * d;
-    List* path;
+    int* p = NULL, * d = NULL;
+    List* path = NULL;
     FILE* filein = stdin;
     FILE* fileout = stdout;
-    int src = 0, dst = 0, n, directed = 1;
-    char* outputFile;
+    int src = 0, dst = 0, n, i, directed = 1;
+    int weighted = 0;
+    int turnPenalty = -1; /* < 0: rotazioni non considerate */
+    int nturns = 0, cost = -1;
+    int starts[MAX_ROBOTS], nrobots = 1;
+    int argStarts[MAX_ROBOTS], argGoals[MAX_ROBOTS]; /* numerati per righe */
+    int goals[MAX_ROBOTS], multiRobot = 0, collisionFree = 0;
+    RobotPlan plans[MAX_ROBOTS];
+    int fullCoverage = 0;
+    int intervals = 0;
+    int pipeline = 0;
+    Clearance clearance = { NULL, 0 };
+    int nlandmarks = 0;
+    Landmarks* lm = NULL;
+    long expanded = 0; /* espansioni delle ricerche A* con -a */
+    uint64_t mapHash = 0;
+    RunMap* runs = NULL;
+    RunPath runPath = { -1, NULL, 0 };
+    int nthreads = 1;
+    Graph_layout layout = GRAPH_LAYOUT_ROWS;
+    int stats = 0;
+    double ms[4]; /* tempi di lettura, grafo, ricerca e scrittura */
+    int hwCounters = 0;
+    int memStats = 0;
+    int rle = 0;
+    int binary = 0;
+    int snapshot = 0;
+    int fullBfs = 0; /* -D: visita completa con `dobfs()` */
+    Dobfs_mode dobfsMode = DOBFS_HYBRID;
+    char* snapName = NULL;
+    double snapMs = 0.0; /* tempo di caricamento dell'istantanea */
+    int footprint = 0; /* -f: lato dell'impronta, 0 per quella 3x3 */
+    DistMap distances = { 0, 0, NULL };
+    int haveDistances = 0;
+    char* distName = NULL;
+    uint64_t distHash = 0; /* hash della sola mappa, per il file .dst */
+    ResultWriter* results = NULL;
+    char* decodeFile = NULL;
+    Search* search = NULL; /* tenuto fino alla scrittura con -z */
+    PerfCounters counters;
+    PerfSample samples[5]; /* contatori all'inizio e alla fine di ogni fase */
+    struct timespec clock;
+    CoveragePlan coverage;
+    int rows, cols;
+    int argi = 1;
+    char* inputFile;
+    char* queryFile = NULL;
+    char* manifest = NULL;
+    char* cacheDir = NULL;
+    long cacheMax = CACHE_DEFAULT_MAX_BYTES;
+    int useCache = 0;
+    CacheEntry cacheEntry;
+    MapText text;
+    int nqueries = 0, * qsrc = NULL, * qdst = NULL;
+    char* outputFile = NULL;
+    char* derivedName = NULL;
+    FILE* info = stdout; /* destinazione dei messaggi informativi */
+    int status = EXIT_SUCCESS; /* dopo la lettura delle richieste si
+                                  esce sempre dalla liberazione finale */
+
+    /* lettura delle opzioni che precedono gli argomenti posizionali */
+    while (argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0') {
+        if (strcmp(argv[argi], "-w") == 0) {
+            weighted = 1;
+        }
+        else if (strcmp(argv[argi], "-p") == 0) {
+            fullCoverage = 1;
+        }
+        else if (strcmp(argv[argi], "-a") == 0 && argi + 1 < argc) {
+            nlandmarks = atoi(argv[++argi]);
+            if (nlandmarks < 1 || nlandmarks > LANDMARKS_MAX) {
+                fprintf(stderr, "Il numero di landmark deve essere compreso tra 1 e %d\n", LANDMARKS_MAX);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[argi], "-f") == 0 && argi + 1 < argc) {
+            footprint = atoi(argv[++argi]);
+            if (footprint < 3 || footprint > DISTMAP_MAX_SIDE || footprint % 2 == 0) {
+                fprintf(stderr, "Il lato dell'impronta deve essere dispari e compreso tra 3 e %d\n", DISTMAP_MAX_SIDE);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[argi], "-P") == 0) {
+            pipeline = 1;
+        }
+        else if (strcmp(argv[argi], "-i") == 0) {
+            intervals = 1;
+        }
+        else if (strcmp(argv[argi], "-s") == 0) {
+            stats = 1;
+        }
+        else if (strcmp(argv[argi], "-e") == 0) {
+            hwCounters = 1;
+        }
+        else if (strcmp(argv[argi], "-z") == 0) {
+            rle = 1;
+        }
+        else if (strcmp(argv[argi], "-b") == 0) {
+            binary = 1;
+        }
+        else if (strcmp(argv[argi], "-g") == 0) {
+            snapshot = 1;
+        }
+        else if (strcmp(argv[argi], "-D") == 0 && argi + 1 < argc) {
+            argi++;
+            fullBfs = 1;
+            if (strcmp(argv[argi], "ibrida") == 0)
+                dobfsMode = DOBFS_HYBRID;
+            else if (strcmp(argv[argi], "alto") == 0)
+                dobfsMode = DOBFS_TOP_DOWN;
+            else if (strcmp(argv[argi], "basso") == 0)
+                dobfsMode = DOBFS_BOTTOM_UP;
+            else {
+                fprintf(stderr, "Direzione della visita non riconosciuta: %s (ibrida, alto, basso)\n", argv[argi]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[argi], "-u") == 0 && argi + 1 < argc) {
+            decodeFile = argv[++argi];
+        }
+        else if (strcmp(argv[argi], "-M") == 0) {
+            memStats = 1;
+            mem_enable();
+        }
+        else if (strcmp(argv[argi], "-l") == 0 && argi + 1 < argc) {
+            argi++;
+            if (strcmp(argv[argi], "righe") == 0)
+                layout = GRAPH_LAYOUT_ROWS;
+            else if (strcmp(argv[argi], "quadrati") == 0)
+                layout = GRAPH_LAYOUT_TILES;
+            else if (strcmp(argv[argi], "morton") == 0)
+                layout = GRAPH_LAYOUT_MORTON;
+            else {
+                fprintf(stderr, "Ordine dei nodi non riconosciuto: %s\n", argv[argi]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[argi], "-k") == 0 && argi + 1 < argc) {
+            cacheDir = argv[++argi];
+        }
+        else if (strcmp(argv[argi], "-K") == 0 && argi + 1 < argc) {
+            char* end;
+            const long mb = strtol(argv[++argi], &end, 10);
+            if (*argv[argi] == '\0' || *end != '\0' || mb <= 0 || mb > (LONG_MAX >> 20)) {
+                fprintf(stderr, "La dimensione della cache deve essere un numero di MB tra 1 e %ld\n", LONG_MAX >> 20);
+                return EXIT_FAILURE;
+            }
+            cacheMax = mb << 20;
+        }
+        else if (strcmp(argv[argi], "-q") == 0 && argi + 1 < argc) {
+            queryFile = argv[++argi];
+        }
+        else if (strcmp(argv[argi], "-m") == 0 && argi + 1 < argc) {
+            manifest = argv[++argi];
+        }
+        else if (strcmp(argv[argi], "-o") == 0 && argi + 1 < argc) {
+            outputFile = argv[++argi];
+        }
+        else if (strcmp(argv[argi], "-j") == 0 && argi + 1 < argc) {
+            nthreads = atoi(argv[++argi]);
+            if (nthreads < 1) {
+                fprintf(stderr, "Il numero di thread deve essere positivo\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[argi], "-t") == 0 && argi + 1 < argc) {
+            turnPenalty = atoi(argv[++argi]);
+            if (turnPenalty < 0) {
+                fprintf(stderr, "La penalita' di rotazione deve essere non negativa\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[argi], "-r") == 0 && argi + 1 < argc) {
+            char* tok = strtok(argv[++argi], ",");
+            multiRobot = 1;
+            while (tok != NULL) {
+                if (nrobots >= MAX_ROBOTS) {
+                    fprintf(stderr, "Al massimo %d robot\n", MAX_ROBOTS);
+                    return EXIT_FAILURE;
+                }
+                starts[nrobots++] = atoi(tok);
+                tok = strtok(NULL, ",");
+            }
+        }
+        else if (strcmp(argv[argi], "-c") == 0 && argi + 1 < argc) {
+            char* tok = strtok(argv[++argi], ",");
+            collisionFree = 1;
+            while (tok != NULL) {
+                if (nrobots >= MAX_ROBOTS) {
+                    fprintf(stderr, "Al massimo %d robot\n", MAX_ROBOTS);
+                    return EXIT_FAILURE;
+                }
+                if (2 != sscanf(tok, "%d:%d", &starts[nrobots], &goals[nrobots])) {
+                    fprintf(stderr, "Coppia sorgente:destinazione non valida: %s\n", tok);
+                    return EXIT_FAILURE;
+                }
+                nrobots++;
+                tok = strtok(NULL, ",");
+            }
+        }
+        else {
+            fprintf(stderr, "Opzione non riconosciuta: %s\n", argv[argi]);
+            return EXIT_FAILURE;
+        }
+        argi++;
+    }
 
-    if (argc != 4) {
-        fprintf(stderr, "Invocare il programma con: %s nodo_sorgente nodo_destinazione file_grafo\n", argv[0]);
+    if (argc - argi != (manifest != NULL || decodeFile != NULL ? 0 : queryFile != NULL ? 1 : 3)) {
+        fprintf(stderr, "Invocare il programma con: %s [-w] [-t penalita'] [-r s1,s2,...] [-c s1:d1,s2:d2,...] [-p] [-i] [-a landmark] [-D ibrida|alto|basso] [-f lato] [-g] [-P] [-j thread] [-l righe|quadrati|morton] [-s] [-e] [-M] [-z] [-o file_output] [-k cartella_cache] [-K MB] nodo_sorgente nodo_destinazione file_grafo\n", argv[0]);
+        fprintf(stderr, "oppure con: %s -q file_richieste [-i] [-a landmark] [-f lato] [-g] [-P] [-j thread] [-l righe|quadrati|morton] [-s] [-e] [-M] [-z|-b] [-o file_output] file_grafo\n", argv[0]);
+        fprintf(stderr, "oppure con: %s -m manifesto [-j thread] [-s] [-M] [-o file_output]\n", argv[0]);
+        fprintf(stderr, "oppure con: %s -u file_compresso|file_binario [-o file_output]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (nrobots > 1 && (weighted || turnPenalty >= 0)) {
+        fprintf(stderr, "Le opzioni -r e -c non sono compatibili con -w e -t\n");
+        return EXIT_FAILURE;
+    }
+    if (multiRobot && collisionFree) {
+        fprintf(stderr, "Le opzioni -r e -c non sono compatibili tra loro\n");
+        return EXIT_FAILURE;
+    }
+    if (fullCoverage && (nrobots > 1 || weighted || turnPenalty >= 0)) {
+        fprintf(stderr, "L'opzione -p non e' compatibile con le altre opzioni\n");
+        return EXIT_FAILURE;
+    }
+    if (intervals && (nrobots > 1 || weighted || turnPenalty >= 0 || fullCoverage)) {
+        fprintf(stderr, "L'opzione -i non e' compatibile con -w, -t, -r, -c e -p\n");
+        return EXIT_FAILURE;
+    }
+    if (nlandmarks > 0 && (intervals || nrobots > 1 || weighted || turnPenalty >= 0 || fullCoverage)) {
+        fprintf(stderr, "L'opzione -a non e' compatibile con -i, -w, -t, -r, -c e -p\n");
+        return EXIT_FAILURE;
+    }
+    if (pipeline && (intervals || nlandmarks > 0 || cacheDir != NULL)) {
+        fprintf(stderr, "L'opzione -P non e' compatibile con -i, -a e -k\n");
         return EXIT_FAILURE;
     }
-    
-    /* inizializzo una variabile con il nodo sorgente specificato */ 
-    src = atoi(argv[1]); 
-    /* inizializzo una variabile con il nodo destinazione specificato */
-    dst = atoi(argv[2]); 
+    if (queryFile != NULL && (nrobots > 1 || weighted || turnPenalty >= 0 || fullCoverage)) {
+        fprintf(stderr, "L'opzione -q non e' compatibile con -w, -t, -r, -c e -p\n");
+        return EXIT_FAILURE;
+    }
+    if (fullBfs && (queryFile != NULL || manifest != NULL || nrobots > 1 || weighted || turnPenalty >= 0
+                    || fullCoverage || intervals || nlandmarks > 0)) {
+        fprintf(stderr, "L'opzione -D non e' compatibile con -q, -m, -w, -t, -r, -c, -p, -i e -a\n");
+        return EXIT_FAILURE;
+    }
+    if (footprint && (weighted || nrobots > 1 || fullCoverage || intervals || pipeline || manifest != NULL)) {
+        fprintf(stderr, "L'opzione -f non e' compatibile con -w, -r, -c, -p, -i, -P e -m\n");
+        return EXIT_FAILURE;
+    }
+    if (snapshot && (intervals || pipeline || collisionFree || fullCoverage)) {
+        fprintf(stderr, "L'opzione -g non e' compatibile con -i, -P, -c e -p\n");
+        return EXIT_FAILURE;
+    }
+    if (binary && (queryFile == NULL || rle)) {
+        fprintf(stderr, "L'opzione -b richiede -q e non e' compatibile con -z\n");
+        return EXIT_FAILURE;
+    }
+    if (decodeFile != NULL && (manifest != NULL || queryFile != NULL || hwCounters)) {
+        fprintf(stderr, "L'opzione -u non e' compatibile con -m, -q ed -e\n");
+        return EXIT_FAILURE;
+    }
+    if (decodeFile != NULL)
+        return run_decode(decodeFile, outputFile);
+    if (manifest != NULL && (rle || queryFile != NULL || nrobots > 1 || weighted || turnPenalty >= 0 || fullCoverage
+                             || intervals || nlandmarks > 0 || pipeline || snapshot || cacheDir != NULL || layout != GRAPH_LAYOUT_ROWS
+                             || hwCounters)) {
+        fprintf(stderr, "L'opzione -m e' compatibile solo con -j, -s, -M e -o\n");
+        return EXIT_FAILURE;
+    }
+    if (manifest != NULL)
+        return run_manifest(manifest, outputFile, nthreads, stats, memStats);
+
+    if (queryFile != NULL) {
+        FILE* fq = fopen(queryFile, "r");
+        if (fq == NULL) {
+            fprintf(stderr, "Can not open %s\n", queryFile);
+            return EXIT_FAILURE;
+        }
+        nqueries = queries_from_file(fq, queryFile, &qsrc, &qdst);
+        fclose(fq);
+        if (nqueries < 0)
+            return EXIT_FAILURE;
+        inputFile = argv[argi];
+    }
+    else {
+        /* inizializzo una variabile con il nodo sorgente specificato */ 
+        src = atoi(argv[argi]); 
+        /* inizializzo una variabile con il nodo destinazione specificato */
+        dst = atoi(argv[argi + 1]); 
+        inputFile = argv[argi + 2];
+    }
+    starts[0] = src;
+    goals[0] = dst;
+
+    /* i contatori contano dall'apertura, ma le fasi si misurano come
+       differenze tra le letture: aprirli qui non cambia i risultati e
+       li rende validi per la liberazione finale */
+    if (hwCounters)
+        perf_open(&counters);
 
     /* controllo sul nome del file passato in input */ 
-    if (strcmp(argv[3], "-") != 0) {
-        filein = fopen(argv[3], "r");
+    if (strcmp(inputFile, "-") != 0) {
+        filein = fopen(inputFile, "r");
         if (filein == NULL) {
-            fprintf(stderr, "Can not open %s\n", argv[3]);
-            return EXIT_FAILURE;
+            fprintf(stderr, "Can not open %s\n", inputFile);
+            status = EXIT_FAILURE;
+            goto fine;
         }
     }
 
-    /* inizializzo una variabile con la matrice avente i valori letti dal file */
-    matrix = matrix_from_file(filein);
+    /* se la mappa arriva dallo standard input e non e' indicato un
+       file di output, il risultato va sullo standard output */
+    if (outputFile == NULL && strcmp(inputFile, "-") == 0)
+        outputFile = "-";
+    if (outputFile != NULL && strcmp(outputFile, "-") == 0)
+        info = stderr;
+
+    /* il file di output, se non e' stato indicato, ha il nome della
+       mappa con l'estensione .out al posto di .in */
+    if (outputFile == NULL) {
+        derivedName = replace_extension(inputFile, ".out");
+        outputFile = derivedName;
+    }
+
+    if (hwCounters)
+        perf_read(&counters, &samples[0]);
+    clock_gettime(CLOCK_MONOTONIC, &clock);
+    if (!pipeline) {
+        map_text_load(filein, &text);
+        if (filein != stdin) fclose(filein);
+    }
 
-    /* creo il grafo che servirà per l'algoritmo a partire dalla matrice */
-    G = graph_create_from_matrix(argv[3], matrix, directed);
-    n = graph_n_nodes(G);
+    /* il risultato dipende dal contenuto della mappa, dall'impronta del
+       robot, dalla modalita' e dai nodi: se e' in cache, la mappa non
+       viene nemmeno decodificata */
+    useCache = (cacheDir != NULL && queryFile == NULL && nrobots == 1 && !fullCoverage);
+    if (useCache || nlandmarks > 0 || snapshot || footprint)
+        mapHash = cache_hash(text.data, text.size, 0);
+    /* le distanze dagli ostacoli dipendono dalla sola mappa, il grafo
+       (e quindi landmark, istantanea e cache) anche dall'impronta */
+    if (footprint) {
+        distHash = mapHash;
+        mapHash = cache_hash(&distHash, sizeof(distHash), (uint64_t)footprint);
+    }
+    if (useCache) {
+        char query[128];
+        char* cached;
+        size_t size;
+        sprintf(query, "impronta=%dx%d pesi=%d rotazioni=%d%s %d %d",
+                footprint ? footprint : 3, footprint ? footprint : 3, weighted, turnPenalty, intervals ? " intervalli" : "", src, dst);
+        if (nlandmarks > 0)
+            sprintf(query + strlen(query), " landmark=%d", nlandmarks);
+        if (fullBfs)
+            sprintf(query + strlen(query), " direzione=%d", (int)dobfsMode);
+        if (rle)
+            strcat(query, " rle");
+        cache_entry_init(&cacheEntry, cacheDir, mapHash, query);
+        cached = cache_get(&cacheEntry, &size);
+        if (cached != NULL) {
+            fileout = open_output(outputFile);
+            if (fileout == NULL)
+                status = EXIT_FAILURE;
+            else {
+                fwrite(cached, 1, size, fileout);
+                fprintf(info, "# risultato letto dalla cache %s\n", cacheDir);
+                if (fileout != stdout)
+                    fprintf(info, "File %s creato.\n", outputFile);
+            }
+            mem_free(MEM_CACHE, cached);
+            map_text_free(&text);
+            goto fine;
+        }
+    }
+
+    /* con -g il grafo viene caricato dall'istantanea salvata accanto
+       al file della mappa, con estensione .grf, se corrisponde al
+       contenuto della mappa: in tal caso la mappa non viene decodificata */
+    if (snapshot && strcmp(inputFile, "-") != 0) {
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        snapName = replace_extension(inputFile, ".grf");
+        G = snapshot_load(snapName, mapHash, directed, layout);
+        snapMs = elapsed_ms(&t);
+    }
+
+    /* con -f le distanze dagli ostacoli vengono lette dal file della
+       mappa con estensione .dst, se corrisponde al contenuto della
+       mappa: anche in questo caso la mappa non viene decodificata */
+    if (footprint && G == NULL && strcmp(inputFile, "-") != 0) {
+        distName = replace_extension(inputFile, ".dst");
+        haveDistances = (distmap_load(&distances, distName, distHash) == 0);
+    }
+
+    /* inizializzo una variabile con la matrice avente i valori letti dal file */
+    if (G != NULL || haveDistances) {
+        matrix = NULL;
+        rows = G != NULL ? G->rows : distances.rows;
+        cols = G != NULL ? G->cols : distances.cols;
+        map_text_free(&text);
+    }
+    else if (pipeline) {
+        /* i pesi dell'impronta vengono calcolati man mano che le righe
+           arrivano dal thread di lettura */
+        matrix = map_stream(filein, inputFile, &rows, &cols, clearance_rows, &clearance);
+        if (filein != stdin) fclose(filein);
+    }
+    else {
+        matrix = map_parse(&text, inputFile, &rows, &cols, nthreads);
+        map_text_free(&text);
+    }
+    if (matrix == NULL && G == NULL && !haveDistances) {
+        mem_free(MEM_GRAPH, clearance.w);
+        status = EXIT_FAILURE;
+        goto fine;
+    }
+    ms[0] = elapsed_ms(&clock) - snapMs;
+    if (hwCounters)
+        perf_read(&counters, &samples[1]);
+
+    /* creo il grafo che servirà per l'algoritmo a partire dalla
+       matrice, oppure i soli intervalli di posizioni libere */
+    if (intervals) {
+        G = NULL;
+        runs = runs_create(matrix, rows, cols);
+        n = runs_n_positions(runs);
+    }
+    else if (G != NULL) {
+        n = graph_n_nodes(G);
+        fprintf(info, "# grafo letto da %s\n", snapName);
+    }
+    else if (pipeline) {
+        G = graph_create_from_weights(clearance.w, rows, cols, directed, nthreads, layout);
+        n = graph_n_nodes(G);
+        mem_free(MEM_GRAPH, clearance.w);
+    }
+    else if (footprint) {
+        signed char* w = (signed char*)mem_alloc(MEM_GRAPH, (size_t)rows * cols);
+        assert(w != NULL);
+        if (haveDistances)
+            fprintf(info, "# distanze dagli ostacoli lette da %s\n", distName);
+        else {
+            distmap_compute(matrix, rows, cols, &distances);
+            if (distName != NULL && distmap_save(&distances, distName, distHash) == 0)
+                fprintf(info, "# distanze dagli ostacoli salvate in %s\n", distName);
+        }
+        distmap_weights(&distances, footprint, w);
+        distmap_free(&distances);
+        G = graph_create_from_weights(w, rows, cols, directed, nthreads, layout);
+        n = graph_n_nodes(G);
+        mem_free(MEM_GRAPH, w);
+        if (snapName != NULL && snapshot_save(G, snapName, mapHash) == 0)
+            fprintf(info, "# grafo salvato in %s\n", snapName);
+    }
+    else {
+        G = graph_create_from_matrix(matrix, rows, cols, directed, nthreads, layout);
+        n = graph_n_nodes(G);
+        if (snapName != NULL && snapshot_save(G, snapName, mapHash) == 0)
+            fprintf(info, "# grafo salvato in %s\n", snapName);
+    }
+    ms[1] = elapsed_ms(&clock) + snapMs;
+    if (hwCounters)
+        perf_read(&counters, &samples[2]);
 
     /* controllo dei valori indicati come sorgente e destinazione */
-    if (src < 0 || src > n) {
+    if (queryFile == NULL && (src < 0 || src >= n)) {
         fprintf(stderr, "Invocare il programma correttamente: il nodo_sorgente %d inserito non e' valido \n", src);
-        fprintf(stderr, "Nota: in questo caso i nodi vanno da min 0 a max %d. \n", n);
-        return EXIT_FAILURE;
+        fprintf(stderr, "Nota: in questo caso i nodi vanno da min 0 a max %d. \n", n - 1);
+        status = EXIT_FAILURE;
+        goto fine;
     }
-    if (dst < 0 || dst > n) {
+    if (queryFile == NULL && (dst < 0 || dst >= n)) {
         fprintf(stderr, "Invocare il programma correttamente: il nodo_destinazione %d inserito non e' valido \n", dst);
-        fprintf(stderr, "Nota: in questo caso i nodi vanno da min 0 a max %d \n", n);
-        return EXIT_FAILURE;
+        fprintf(stderr, "Nota: in questo caso i nodi vanno da min 0 a max %d \n", n - 1);
+        status = EXIT_FAILURE;
+        goto fine;
+    }
+    for (i = 1; i < nrobots; i++) {
+        if (starts[i] < 0 || starts[i] >= n) {
+            fprintf(stderr, "Invocare il programma correttamente: il nodo di partenza %d del robot %d non e' valido \n", starts[i], i);
+            status = EXIT_FAILURE;
+            goto fine;
+        }
+        if (collisionFree && (goals[i] < 0 || goals[i] >= n)) {
+            fprintf(stderr, "Invocare il programma correttamente: il nodo di destinazione %d del robot %d non e' valido \n", goals[i], i);
+            status = EXIT_FAILURE;
+            goto fine;
+        }
     }
 
-    p = (int*)malloc(n * sizeof(*p)); assert(p != NULL);
-    d = (int*)malloc(n * sizeof(*d)); assert(d != NULL);
-    nvisited = bfs(G, src, d, p);
-    /* Stampa di debug */
-    /* print_bfs(G, src, d, p); */
+    /* i nodi indicati sulla riga di comando sono numerati per righe;
+       i messaggi riportano questa numerazione. Gli intervalli usano
+       direttamente la numerazione per righe. */
+    for (i = 0; i < nrobots; i++) {
+        argStarts[i] = starts[i];
+        argGoals[i] = goals[i] = (i == 0 || collisionFree) ? goals[i] : dst;
+    }
+    if (G != NULL) {
+        graph_nodes_from_ranks(G, starts, nrobots);
+        graph_nodes_from_ranks(G, goals, nrobots);
+    }
+    src = starts[0];
+    dst = goals[0];
+    for (i = 0; i < nqueries; i++) {
+        if (qsrc[i] < 0 || qsrc[i] >= n || qdst[i] < 0 || qdst[i] >= n) {
+            fprintf(stderr, "Invocare il programma correttamente: la richiesta %d (%d %d) non e' valida \n", i + 1, qsrc[i], qdst[i]);
+            fprintf(stderr, "Nota: in questo caso i nodi vanno da min 0 a max %d \n", n - 1);
+            status = EXIT_FAILURE;
+            goto fine;
+        }
+    }
+    if (queryFile != NULL && G != NULL) {
+        graph_nodes_from_ranks(G, qsrc, nqueries);
+        graph_nodes_from_ranks(G, qdst, nqueries);
+    }
 
-    printf("# %d nodi su %d raggiungibili dalla sorgente %d\n", nvisited, n, src);
-    
-    /* Stampa di debug */
-    /* graph_print(G); */
-    
-    /* inserisco in una variabile il percorso più breve trovato */
-    path = list_create();
-    get_path(src, dst, p, path);
+    /* le distanze dai landmark si calcolano una volta per mappa e si
+       salvano accanto al file della mappa, con estensione .alt; senza
+       posizioni ammesse non ci sono richieste valide (-q vuoto) */
+    if (nlandmarks > 0 && n > 0) {
+        char* altName = (strcmp(inputFile, "-") != 0) ? replace_extension(inputFile, ".alt") : NULL;
+        if (altName != NULL)
+            lm = landmarks_load(G, altName, mapHash, nlandmarks);
+        if (lm != NULL)
+            fprintf(info, "# %d landmark letti da %s\n", lm->k, altName);
+        else {
+            lm = landmarks_create(G, nlandmarks);
+            if (altName != NULL && landmarks_save(lm, G, altName, mapHash) == 0)
+                fprintf(info, "# %d landmark calcolati e salvati in %s\n", lm->k, altName);
+            else
+                fprintf(info, "# %d landmark calcolati\n", lm->k);
+        }
+        mem_free(MEM_MAP, altName);
+    }
+    ms[1] += elapsed_ms(&clock);
 
     /* creo il file di output in cui andrò a scrivere il percorso trovato */
-    outputFile = (char*)malloc(strlen(argv[3]) + 1);
-    assert(outputFile != NULL);
-    memset(outputFile, '\0', strlen(argv[3]));
-    outputFile = strncpy(outputFile, argv[3], sizeof(char) * strlen(argv[3]) - 3);
-    outputFile = strcat(outputFile, ".out");
-
-    /* scrivo nel file di output il percorso trovato */
-    fileout = fopen(outputFile, "w");
+    fileout = open_output(outputFile);
     if (fileout == NULL) {
-        fprintf(stderr, "Can not open %s\n", outputFile);
-        return EXIT_FAILURE;
+        status = EXIT_FAILURE;
+        goto fine;
     }
-    path_write_to_file(fileout, G, path, src);
-    printf("File %s creato.\n", outputFile);
- 
-    /* libero dalla memoria tutte le variabili utilizzate dal programma */
-    graph_destroy(G);
-    free(matrix);
-    free(p);
-    free(d);
-    free(path);
-    if (filein != stdin) fclose(filein);
-    if (fileout != stdout) fclose(fileout);
 
-    return EXIT_SUCCESS;
+    path = list_create();
+    if (collisionFree) {
+        /* il pianificatore lavora sulle coordinate della mappa */
+        for (i = 0; i < nrobots; i++) {
+            plans[i].sr = graph_node_row(G, starts[i]);
+            plans[i].sc = graph_node_col(G, starts[i]);
+            plans[i].gr = graph_node_row(G, goals[i]);
+            plans[i].gc = graph_node_col(G, goals[i]);
+        }
+        nvisited = stplan_prioritized(matrix, rows, cols, plans, nrobots);
+        fprintf(info, "# %d robot su %d pianificati senza collisioni\n", nvisited, nrobots);
+        for (i = 0; i < nrobots; i++)
+            fprintf(info, "# robot %d (nodo %d -> %d): arrivo all'istante %d\n", i, argStarts[i], argGoals[i], plans[i].arrival);
+    }
+    else if (fullCoverage) {
+        cost = coverage_plan(matrix, rows, cols,
+                             graph_node_row(G, src), graph_node_col(G, src),
+                             graph_node_row(G, dst), graph_node_col(G, dst),
+                             &coverage);
+        fprintf(info, "# copertura: %d celle di pavimento su %d (%.1f%%), %d celle boustrophedon\n",
+                coverage.covered, coverage.floor,
+                coverage.floor > 0 ? 100.0 * coverage.covered / coverage.floor : 0.0,
+                coverage.ncells);
+        fprintf(info, "# lunghezza del percorso: %d mosse\n", cost);
+    }
+    else if (multiRobot) {
+        p = (int*)mem_alloc(MEM_SEARCH, n * sizeof(*p));
+        d = (int*)mem_alloc(MEM_SEARCH, n * sizeof(*d));
+        nvisited = multi_bfs(G, dst, starts, nrobots, d, p);
+        fprintf(info, "# %d robot su %d possono raggiungere la stazione %d\n", nvisited, nrobots, argGoals[0]);
+        for (i = 0; i < nrobots; i++)
+            fprintf(info, "# robot %d (nodo %d): %d mosse\n", i, argStarts[i], d[starts[i]]);
+    }
+    else if (turnPenalty >= 0) {
+        /* gli array sono indicizzati per stato (nodo, direzione) */
+        int best;
+        p = (int*)mem_alloc(MEM_SEARCH, N_HEADINGS * n * sizeof(*p));
+        d = (int*)mem_alloc(MEM_SEARCH, N_HEADINGS * n * sizeof(*d));
+        nvisited = turn_search(G, src, turnPenalty, weighted, d, p);
+        fprintf(info, "# %d stati su %d raggiungibili dalla sorgente %d\n", nvisited, N_HEADINGS * n, argStarts[0]);
+        best = turn_best_state(dst, d);
+        if (best >= 0) {
+            cost = d[best];
+            nturns = turn_get_path(best, p, path);
+            fprintf(info, "# mosse: %d, rotazioni: %d, costo totale: %d\n", list_length(path) - 1, nturns, cost);
+        }
+    }
+    else if (runs != NULL && queryFile != NULL) {
+        int nreached = 0;
+        if (binary)
+            results = results_begin(fileout, nqueries);
+        for (i = 0; i < nqueries; i++) {
+            runs_search(runs, qsrc[i], qdst[i], &runPath);
+            nreached += (runPath.length >= 0);
+            if (results != NULL)
+                results_add_moves(results, runPath.moves, runPath.length);
+            else {
+                run_path_write(fileout, &runPath, rle);
+                fprintf(fileout, "\n");
+            }
+            runs_path_free(&runPath);
+        }
+        fprintf(info, "# %d richieste, %d destinazioni raggiungibili (%d intervalli)\n", nqueries, nreached, runs->nruns);
+    }
+    else if (runs != NULL) {
+        runs_search(runs, src, dst, &runPath);
+        cost = runPath.length;
+        if (cost >= 0)
+            fprintf(info, "# destinazione raggiunta dopo %d espansioni di intervalli (%d intervalli, %d posizioni)\n", runPath.nexpanded, runs->nruns, n);
+        else
+            fprintf(info, "# destinazione non raggiungibile dalla sorgente %d dopo %d espansioni di intervalli (%d intervalli)\n", argStarts[0], runPath.nexpanded, runs->nruns);
+    }
+    else if (queryFile != NULL) {
+        /* un solo contesto per tutte le richieste: ogni ricerca costa
+           quanto la parte di grafo che esplora. I percorsi vengono
+           scritti man mano nel file di output. */
+        int nreached = 0, nexpanded;
+        search = search_create(G);
+        if (binary)
+            results = results_begin(fileout, nqueries);
+        for (i = 0; i < nqueries; i++) {
+            if (lm != NULL) {
+                nreached += (landmarks_search(lm, search, G, qsrc[i], qdst[i], &nexpanded) >= 0);
+                expanded += nexpanded;
+            }
+            else {
+                nreached += (search_bfs_to(search, G, qsrc[i], qdst[i]) >= 0);
+                expanded += search->ntouched;
+            }
+            if (results != NULL) {
+                results_add_pred(results, G, search->p, qsrc[i], qdst[i], search_dist(search, qdst[i]));
+                continue;
+            }
+            if (rle)
+                rle_write_pred(fileout, G, search->p, qsrc[i], qdst[i], search_dist(search, qdst[i]));
+            else {
+                list_clear(path);
+                search_get_path(search, qdst[i], path);
+                path_write_to_file(fileout, G, path, qsrc[i]);
+            }
+            fprintf(fileout, "\n");
+        }
+        fprintf(info, "# %d richieste, %d destinazioni raggiungibili\n", nqueries, nreached);
+        fprintf(info, "# nodi %s: %ld (%.1f per richiesta)\n", lm != NULL ? "espansi" : "raggiunti",
+                expanded, nqueries > 0 ? (double)expanded / nqueries : 0.0);
+        search_destroy(search);
+        search = NULL;
+    }
+    else if (weighted) {
+        p = (int*)mem_alloc(MEM_SEARCH, n * sizeof(*p));
+        d = (int*)mem_alloc(MEM_SEARCH, n * sizeof(*d));
+        nvisited = dijkstra_dial(G, src, d, p);
+        fprintf(info, "# %d nodi su %d raggiungibili dalla sorgente %d\n", nvisited, n, argStarts[0]);
+        cost = d[dst];
+        if (cost >= 0)
+            fprintf(info, "# costo totale del percorso: %d\n", cost);
+
+        /* inserisco in una variabile il percorso più breve trovato */
+        get_path(src, dst, p, path);
+    }
+    else if (fullBfs) {
+        /* visita completa, livello per livello, nella direzione
+           scelta con -D */
+        DobfsStats st;
+        int v;
+        p = (int*)mem_alloc(MEM_SEARCH, n * sizeof(*p));
+        d = (int*)mem_alloc(MEM_SEARCH, n * sizeof(*d));
+        nvisited = dobfs(G, src, d, p, dobfsMode, &st);
+        fprintf(info, "# %d nodi su %d raggiungibili dalla sorgente %d\n", nvisited, n, argStarts[0]);
+        fprintf(info, "# livelli: %d dall'alto in basso, %d dal basso in alto; archi esaminati: %ld + %ld\n",
+                st.topDown, st.bottomUp, st.edgesTopDown, st.edgesBottomUp);
+        cost = d[dst];
+        if (cost >= 0) {
+            for (v = dst; v >= 0; v = p[v])
+                list_add_first(path, v);
+        }
+    }
+    else {
+        /* la visita si ferma appena raggiunge la destinazione: se non
+           la raggiunge, ha esplorato tutti i nodi raggiungibili */
+        search = search_create(G);
+        if (lm != NULL) {
+            int nexpanded;
+            cost = landmarks_search(lm, search, G, src, dst, &nexpanded);
+            if (cost >= 0)
+                fprintf(info, "# destinazione raggiunta dopo %d nodi espansi (%d raggiunti) su %d\n", nexpanded, search->ntouched, n);
+            else
+                fprintf(info, "# destinazione non raggiungibile dalla sorgente %d (%d nodi espansi)\n", argStarts[0], nexpanded);
+        }
+        else {
+            cost = search_bfs_to(search, G, src, dst);
+            if (cost >= 0)
+                fprintf(info, "# destinazione raggiunta dopo %d nodi su %d\n", search->ntouched, n);
+            else if (G->comp != NULL && G->comp[src] != G->comp[dst])
+                /* le etichette dell'istantanea hanno evitato la visita:
+                   i nodi raggiungibili non sono stati contati */
+                fprintf(info, "# destinazione non raggiungibile dalla sorgente %d (componenti connesse diverse)\n", argStarts[0]);
+            else
+                fprintf(info, "# %d nodi su %d raggiungibili dalla sorgente %d\n", search->ntouched, n, argStarts[0]);
+        }
+
+        /* inserisco in una variabile il percorso più breve trovato;
+           con -z le mosse vengono ricavate in fase di scrittura
+           direttamente dai predecessori */
+        if (!rle) {
+            search_get_path(search, dst, path);
+            search_destroy(search);
+            search = NULL;
+        }
+    }
+
+    ms[2] = elapsed_ms(&clock);
+    if (hwCounters)
+        perf_read(&counters, &samples[3]);
+
+    if (collisionFree) {
+        for (i = 0; i < nrobots; i++) {
+            fprintf(fileout, "%d\n", plans[i].arrival);
+            if (plans[i].arrival >= 0 && rle) {
+                rle_write_moves(fileout, plans[i].moves);
+                fprintf(fileout, "\n");
+            }
+            else if (plans[i].arrival >= 0)
+                fprintf(fileout, "%s\n", plans[i].moves);
+        }
+        stplan_free(plans, nrobots);
+    }
+    else if (fullCoverage) {
+        fprintf(fileout, "%d\n", cost);
+        if (cost >= 0 && rle)
+            rle_write_moves(fileout, coverage.moves);
+        else if (cost >= 0)
+            fprintf(fileout, "%s", coverage.moves);
+        coverage_free(&coverage);
+    }
+    else if (queryFile != NULL) {
+        /* i percorsi sono gia' stati scritti durante le ricerche */
+    }
+    else if (runs != NULL)
+        run_path_write(fileout, &runPath, rle);
+    else if (multiRobot) {
+        /* un percorso per ogni robot, nell'ordine in cui sono stati
+           specificati */
+        for (i = 0; i < nrobots; i++) {
+            list_clear(path);
+            multi_get_path(starts[i], d, p, path);
+            output_path(fileout, G, path, starts[i], list_length(path) - 1, rle);
+            fprintf(fileout, "\n");
+        }
+    }
+    else if (search != NULL)
+        rle_write_pred(fileout, G, search->p, src, dst, cost);
+    else if (weighted || turnPenalty >= 0)
+        output_path(fileout, G, path, src, cost, rle);
+    else
+        output_path(fileout, G, path, src, list_length(path) - 1, rle);
+    fflush(fileout);
+    if (useCache) {
+        FILE* fc = cache_put_begin(&cacheEntry);
+        if (fc != NULL) {
+            if (runs != NULL)
+                run_path_write(fc, &runPath, rle);
+            else if (search != NULL)
+                rle_write_pred(fc, G, search->p, src, dst, cost);
+            else if (weighted || turnPenalty >= 0)
+                output_path(fc, G, path, src, cost, rle);
+            else
+                output_path(fc, G, path, src, list_length(path) - 1, rle);
+            cache_put_end(&cacheEntry, cacheMax);
+        }
+    }
+    if (results != NULL && results_end(results) != 0) {
+        fprintf(stderr, "Errore nella scrittura dei risultati binari\n");
+        status = EXIT_FAILURE;
+        goto fine;
+    }
+    ms[3] = elapsed_ms(&clock);
+    if (hwCounters)
+        perf_read(&counters, &samples[4]);
+    if (fileout != stdout)
+        fprintf(info, "File %s creato.\n", outputFile);
+    if (stats)
+        fprintf(info, "# tempi (ms): lettura %.1f, grafo %.1f, ricerca %.1f, scrittura %.1f\n",
+                ms[0], ms[1], ms[2], ms[3]);
+    if (hwCounters) {
+        static const char* const stages[4] = { "lettura", "grafo", "ricerca", "scrittura" };
+        if (counters.navailable == 0)
+            fprintf(info, "# contatori hardware non disponibili (%s)\n", strerror(counters.err));
+        for (i = 0; i < 4 && counters.navailable > 0; i++)
+            perf_print(info, stages[i], &samples[i], &samples[i + 1]);
+    }
+    if (memStats)
+        mem_report(info);
+ 
+    /* libero dalla memoria tutte le variabili utilizzate dal programma,
+       anche quando l'esecuzione si interrompe per un errore */
+fine:
+    if (hwCounters)
+        perf_close(&counters);
+    if (runs != NULL) {
+        if (queryFile == NULL)
+            runs_path_free(&runPath);
+        runs_destroy(runs);
+    }
+    else if (G != NULL)
+        graph_destroy(G);
+    if (lm != NULL)
+        landmarks_destroy(lm);
+    if (useCache)
+        cache_entry_free(&cacheEntry);
+    if (search != NULL)
+        search_destroy(search);
+    map_free(matrix);
+    mem_free(MEM_SEARCH, p);
+    mem_free(MEM_SEARCH, d);
+    mem_free(MEM_SEARCH, qsrc);
+    mem_free(MEM_SEARCH, qdst);
+    if (path != NULL)
+        list_destroy(path);
+    mem_free(MEM_MAP, derivedName);
+    mem_free(MEM_MAP, snapName);
+    mem_free(MEM_MAP, distName);
+    if (fileout != NULL && fileout != stdout) fclose(fileout);
+    if (memStats)
+        mem_check_released(info);
+
+    return status;
 }
@@ -0,0 +1,112 @@
+/****************************************************************************
+ *
+ * bucketq.c -- Coda di priorità monotona a bucket (Dial)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+La coda a bucket di Dial sostituisce lo heap binario nell'algoritmo
+di Dijkstra quando i pesi degli archi sono interi piccoli. Se il peso
+massimo è $C$, in ogni istante le priorità presenti in coda cadono
+nell'intervallo $[cur, cur + C]$, dove $cur$ è l'ultima priorità
+estratta; bastano quindi $C + 1$ bucket, indicizzati con la priorità
+modulo $C + 1$. Ogni bucket è una coda FIFO ([queue.c](queue.c)).
+
+L'algoritmo di Dijkstra con questa struttura costa $O(m + n C)$, cioè
+lineare nella dimensione del grafo quando $C$ è una piccola costante.
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "bucketq.h"
+#include "memstat.h"
+
+BucketQueue *bucketq_create(int max_delta)
+{
+    int i;
+    BucketQueue *q = (BucketQueue*)mem_alloc(MEM_QUEUE, sizeof(*q));
+    assert(q != NULL);
+    assert(max_delta >= 0);
+
+    q->nbuckets = max_delta + 1;
+    q->cur = 0;
+    q->size = 0;
+    q->buckets = (Queue**)mem_alloc(MEM_QUEUE, q->nbuckets * sizeof(Queue*));
+    assert(q->buckets != NULL);
+    for (i = 0; i < q->nbuckets; i++) {
+        q->buckets[i] = queue_create();
+    }
+    return q;
+}
+
+void bucketq_destroy(BucketQueue *q)
+{
+    int i;
+
+    assert(q != NULL);
+
+    for (i = 0; i < q->nbuckets; i++) {
+        queue_destroy(q->buckets[i]);
+    }
+    mem_free(MEM_QUEUE, q->buckets);
+    q->buckets = NULL;
+    q->nbuckets = q->size = 0;
+    mem_free(MEM_QUEUE, q);
+}
+
+void bucketq_insert(BucketQueue *q, int val, int prio)
+{
+    assert(q != NULL);
+    assert((prio >= q->cur) && (prio - q->cur < q->nbuckets));
+
+    queue_enqueue(q->buckets[prio % q->nbuckets], val);
+    q->size++;
+}
+
+int bucketq_delete_min(BucketQueue *q, int *prio)
+{
+    Queue *bucket;
+
+    assert(q != NULL);
+    assert(!bucketq_is_empty(q));
+
+    /* avanziamo fino al primo bucket non vuoto; il numero di bucket
+       vuoti consecutivi è al massimo nbuckets - 1 */
+    bucket = q->buckets[q->cur % q->nbuckets];
+    while (queue_is_empty(bucket)) {
+        q->cur++;
+        bucket = q->buckets[q->cur % q->nbuckets];
+    }
+    q->size--;
+    if (prio != NULL)
+        *prio = q->cur;
+    return queue_dequeue(bucket);
+}
+
+int bucketq_is_empty(const BucketQueue *q)
+{
+    assert(q != NULL);
+
+    return q->size == 0;
+}
+
+int bucketq_size(const BucketQueue *q)
+{
+    assert(q != NULL);
+
+    return q->size;
+}
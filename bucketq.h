@@ -0,0 +1,60 @@
+/****************************************************************************
+ *
+ * bucketq.h -- Interfaccia coda di priorità monotona a bucket (Dial)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef BUCKETQ_H
+#define BUCKETQ_H
+
+#include "queue.h"
+
+/* Coda di priorità "monotona": le priorità inserite non sono mai
+   minori dell'ultima priorità estratta, e non la superano di più di
+   `max_delta`. Con queste ipotesi bastano `max_delta + 1` bucket
+   gestiti in modo circolare, e sia l'inserimento che l'estrazione
+   del minimo costano O(1) ammortizzato (più la scansione dei bucket
+   vuoti, limitata da `max_delta`). */
+typedef struct {
+    int nbuckets;       /* numero di bucket (max_delta + 1)       */
+    int cur;            /* priorità minima corrente               */
+    int size;           /* numero di elementi presenti            */
+    Queue **buckets;    /* bucket[prio % nbuckets]                */
+} BucketQueue;
+
+/* Crea una coda vuota; `max_delta` è la massima differenza tra la
+   priorità di un elemento inserito e la priorità minima corrente
+   (tipicamente, il peso massimo di un arco). */
+BucketQueue *bucketq_create(int max_delta);
+
+/* Distrugge la coda, liberando tutta la memoria */
+void bucketq_destroy(BucketQueue *q);
+
+/* Inserisce `val` con priorità `prio`; deve valere
+   cur <= prio <= cur + max_delta */
+void bucketq_insert(BucketQueue *q, int val, int prio);
+
+/* Rimuove e restituisce un elemento di priorità minima; se `prio` non
+   è NULL vi scrive la priorità dell'elemento estratto */
+int bucketq_delete_min(BucketQueue *q, int *prio);
+
+/* Ritorna 1 se e solo se la coda e' vuota */
+int bucketq_is_empty(const BucketQueue *q);
+
+/* Ritorna il numero di elementi nella coda */
+int bucketq_size(const BucketQueue *q);
+
+#endif
@@ -0,0 +1,325 @@
+/****************************************************************************
+ *
+ * cache.c -- Cache su disco dei risultati delle ricerche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+Ogni elemento della cache è un file della cartella, il cui nome è
+l'hash della richiesta combinato con l'hash del contenuto della mappa.
+La prima riga del file riporta per esteso l'hash della mappa e la
+richiesta, e viene confrontata durante la ricerca per escludere le
+collisioni sul nome; il resto del file è il risultato, nello stesso
+formato del file di output.
+
+Un elemento viene scritto in un file temporaneo e poi rinominato,
+quindi più processi possono usare la stessa cartella senza leggere
+elementi incompleti. La data di ultima modifica di un file indica
+l'ultimo uso dell'elemento, al nanosecondo: viene aggiornata ad ogni
+lettura, e quando la cartella supera la dimensione massima vengono
+eliminati gli elementi con la data più vecchia (politica LRU).
+
+Per sapere quando la cartella supera la dimensione massima non
+occorre esaminarla: il file CACHE_TOTAL contiene il totale dei byte
+degli elementi, aggiornato da ogni scrittura sotto un lock di
+`fcntl()`, così i processi che usano la stessa cartella non perdono
+aggiornamenti. Solo quando il totale supera il limite la cartella
+viene letta per intero, e gli elementi vengono eliminati finché ne
+resta al più CACHE_EVICT_KEEP del limite: la lettura successiva
+avviene dopo molte scritture, non alla prima. La lettura ricalcola il
+totale, quindi corregge anche gli elementi eliminati a mano; se il
+file manca (cartella nuova o scritta da una versione precedente) la
+cartella viene letta subito.
+***/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cache.h"
+#include "memstat.h"
+
+/* estensione dei file degli elementi */
+#define CACHE_EXT ".res"
+
+/* file con il totale dei byte degli elementi */
+#define CACHE_TOTAL "totale"
+
+/* frazione del limite (in sedicesimi) che resta dopo un'eliminazione */
+#define CACHE_EVICT_KEEP 12
+
+static const uint64_t K1 = 0x87c37b91114253d5ULL;
+static const uint64_t K2 = 0x4cf5ad432745937fULL;
+
+static uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/* Il testo viene letto a parole di 64 bit su quattro accumulatori
+   indipendenti, in modo che le moltiplicazioni di parole consecutive
+   possano essere eseguite in parallelo dal processore. */
+uint64_t cache_hash(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t h[4], w;
+    size_t i = 0;
+    int j;
+
+    for (j = 0; j < 4; j++)
+        h[j] = seed + (uint64_t)j * K2;
+    for (; i + 32 <= size; i += 32) {
+        for (j = 0; j < 4; j++) {
+            memcpy(&w, p + i + 8 * j, 8);
+            h[j] = rotl(h[j] ^ (w * K1), 31) * K2;
+        }
+    }
+    for (; i + 8 <= size; i += 8) {
+        memcpy(&w, p + i, 8);
+        h[0] = rotl(h[0] ^ (w * K1), 31) * K2;
+    }
+    w = 0;
+    memcpy(&w, p + i, size - i);
+    h[1] ^= w * K1;
+    return mix(mix(h[0] ^ rotl(h[1], 17)) ^ mix(h[2] ^ rotl(h[3], 41)) ^ size);
+}
+
+static char* concat(const char* a, const char* b)
+{
+    char* s = (char*)mem_alloc(MEM_CACHE, strlen(a) + strlen(b) + 1);
+    strcpy(s, a);
+    strcat(s, b);
+    return s;
+}
+
+void cache_entry_init(CacheEntry* e, const char* dir, uint64_t mapHash, const char* query)
+{
+    char name[64];
+
+    assert(e != NULL);
+    assert(dir != NULL);
+    assert(query != NULL);
+
+    mkdir(dir, 0777); /* se esiste già, mkdir() fallisce senza danni */
+    e->dir = concat(dir, "");
+    e->key = (char*)mem_alloc(MEM_CACHE, strlen(query) + 64);
+    sprintf(e->key, "robot-cache 1 %016" PRIx64 " %s\n", mapHash, query);
+    sprintf(name, "/%016" PRIx64 CACHE_EXT, cache_hash(query, strlen(query), mapHash));
+    e->path = concat(dir, name);
+    sprintf(name, ".tmp.%ld", (long)getpid());
+    e->tmp = concat(e->path, name);
+    e->f = NULL;
+}
+
+void cache_entry_free(CacheEntry* e)
+{
+    assert(e != NULL);
+
+    if (e->f != NULL) {
+        fclose(e->f);
+        remove(e->tmp);
+    }
+    mem_free(MEM_CACHE, e->dir);
+    mem_free(MEM_CACHE, e->path);
+    mem_free(MEM_CACHE, e->tmp);
+    mem_free(MEM_CACHE, e->key);
+}
+
+char* cache_get(CacheEntry* e, size_t* size)
+{
+    const size_t keyLen = strlen(e->key);
+    char* buf;
+    size_t len = 0, cap = keyLen + 4096, got;
+    FILE* f;
+
+    assert(size != NULL);
+
+    f = fopen(e->path, "rb");
+    if (f == NULL)
+        return NULL;
+    buf = (char*)mem_alloc(MEM_CACHE, cap);
+    if (fread(buf, 1, keyLen, f) != keyLen || memcmp(buf, e->key, keyLen) != 0) {
+        mem_free(MEM_CACHE, buf);
+        fclose(f);
+        return NULL;
+    }
+    while ((got = fread(buf + len, 1, cap - len, f)) > 0) {
+        len += got;
+        if (len == cap) {
+            cap *= 2;
+            buf = (char*)mem_realloc(MEM_CACHE, buf, cap);
+        }
+    }
+    fclose(f);
+    utimensat(AT_FDCWD, e->path, NULL, 0); /* usato ora */
+    *size = len;
+    return buf;
+}
+
+FILE* cache_put_begin(CacheEntry* e)
+{
+    assert(e->f == NULL);
+
+    e->f = fopen(e->tmp, "wb");
+    if (e->f != NULL)
+        fputs(e->key, e->f);
+    return e->f;
+}
+
+/* elemento della cartella considerato durante l'eliminazione */
+typedef struct {
+    char* path;
+    long size;
+    struct timespec used;
+} CacheFile;
+
+static int compare_used(const void* a, const void* b)
+{
+    const struct timespec* ua = &((const CacheFile*)a)->used;
+    const struct timespec* ub = &((const CacheFile*)b)->used;
+    if (ua->tv_sec != ub->tv_sec)
+        return (ua->tv_sec > ub->tv_sec) - (ua->tv_sec < ub->tv_sec);
+    return (ua->tv_nsec > ub->tv_nsec) - (ua->tv_nsec < ub->tv_nsec);
+}
+
+/* elimina gli elementi usati meno di recente finché la cartella
+   occupa al più `keepBytes` byte; restituisce i byte che restano */
+static long cache_evict(const char* dir, long keepBytes)
+{
+    const size_t extLen = strlen(CACHE_EXT);
+    CacheFile* files = NULL;
+    int nfiles = 0, cap = 0, i;
+    long total = 0;
+    struct dirent* de;
+    DIR* d = opendir(dir);
+
+    if (d == NULL)
+        return 0;
+    while ((de = readdir(d)) != NULL) {
+        const size_t len = strlen(de->d_name);
+        struct stat st;
+        char* path;
+        if (len <= extLen || strcmp(de->d_name + len - extLen, CACHE_EXT) != 0)
+            continue;
+        path = (char*)mem_alloc(MEM_CACHE, strlen(dir) + len + 2);
+        sprintf(path, "%s/%s", dir, de->d_name);
+        if (stat(path, &st) != 0) {
+            mem_free(MEM_CACHE, path);
+            continue;
+        }
+        if (nfiles == cap) {
+            cap = (cap == 0) ? 64 : 2 * cap;
+            files = (CacheFile*)mem_realloc(MEM_CACHE, files, cap * sizeof(*files));
+        }
+        files[nfiles].path = path;
+        files[nfiles].size = (long)st.st_size;
+        files[nfiles].used = st.st_mtim;
+        total += files[nfiles].size;
+        nfiles++;
+    }
+    closedir(d);
+
+    if (total > keepBytes) {
+        qsort(files, nfiles, sizeof(*files), compare_used);
+        for (i = 0; i < nfiles && total > keepBytes; i++) {
+            if (remove(files[i].path) == 0)
+                total -= files[i].size;
+        }
+    }
+    for (i = 0; i < nfiles; i++)
+        mem_free(MEM_CACHE, files[i].path);
+    mem_free(MEM_CACHE, files);
+    return total;
+}
+
+/* aggiunge `delta` byte al totale della cartella `dir` e, se il
+   totale supera `maxBytes` o non è noto, elimina gli elementi usati
+   meno di recente */
+static void cache_account(const char* dir, long delta, long maxBytes)
+{
+    char* path = (char*)mem_alloc(MEM_CACHE, strlen(dir) + strlen(CACHE_TOTAL) + 2);
+    char buf[32];
+    struct flock lk;
+    long total = -1;
+    ssize_t len;
+    int fd;
+
+    sprintf(path, "%s/%s", dir, CACHE_TOTAL);
+    fd = open(path, O_RDWR | O_CREAT, 0666);
+    mem_free(MEM_CACHE, path);
+    if (fd < 0)
+        return;
+    memset(&lk, 0, sizeof(lk));
+    lk.l_type = F_WRLCK;
+    lk.l_whence = SEEK_SET;
+    if (fcntl(fd, F_SETLKW, &lk) != 0) {
+        close(fd);
+        return;
+    }
+    len = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (len > 0) {
+        buf[len] = '\0';
+        if (sscanf(buf, "%ld", &total) != 1)
+            total = -1;
+    }
+    if (total >= 0)
+        total += delta;
+    if (total < 0 || total > maxBytes)
+        total = cache_evict(dir, maxBytes / 16 * CACHE_EVICT_KEEP);
+    len = sprintf(buf, "%ld\n", total);
+    if (pwrite(fd, buf, len, 0) == len)
+        ftruncate(fd, len);
+    close(fd); /* rilascia il lock */
+}
+
+void cache_put_end(CacheEntry* e, long maxBytes)
+{
+    struct stat st;
+    long size, old = 0;
+
+    assert(e->f != NULL);
+
+    if (fclose(e->f) == 0 && stat(e->tmp, &st) == 0) {
+        size = (long)st.st_size;
+        if (stat(e->path, &st) == 0)
+            old = (long)st.st_size; /* l'elemento viene sostituito */
+        if (rename(e->tmp, e->path) == 0)
+            cache_account(e->dir, size - old, maxBytes);
+        else
+            remove(e->tmp);
+    }
+    else
+        remove(e->tmp);
+    e->f = NULL;
+}
@@ -0,0 +1,69 @@
+/****************************************************************************
+ *
+ * cache.h -- Cache su disco dei risultati delle ricerche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* dimensione massima predefinita della cache, in byte */
+#define CACHE_DEFAULT_MAX_BYTES (64L << 20)
+
+/* elemento della cache: il risultato di una richiesta su una mappa */
+typedef struct {
+    char* dir;      /* cartella della cache                           */
+    char* path;     /* file dell'elemento nella cartella della cache  */
+    char* tmp;      /* file temporaneo usato durante la scrittura     */
+    char* key;      /* prima riga del file: identifica la richiesta   */
+    FILE* f;        /* file temporaneo aperto in scrittura, o NULL    */
+} CacheEntry;
+
+/* Restituisce una funzione hash a 64 bit dei `size` byte in `data`,
+   calcolata a partire dal valore `seed` */
+uint64_t cache_hash(const void* data, size_t size, uint64_t seed);
+
+/* Prepara l'elemento della cartella `dir` associato alla mappa con
+   hash `mapHash` ed alla richiesta descritta dalla stringa `query`
+   (che deve comprendere tutti i parametri da cui dipende il
+   risultato). La cartella viene creata se non esiste. */
+void cache_entry_init(CacheEntry* e, const char* dir, uint64_t mapHash, const char* query);
+
+/* Libera la memoria associata all'elemento */
+void cache_entry_free(CacheEntry* e);
+
+/* Se l'elemento è presente nella cache lo segna come usato di
+   recente e restituisce il risultato memorizzato, in un array di
+   `*size` caratteri da liberare con `mem_free(MEM_CACHE, ...)`;
+   altrimenti restituisce NULL. */
+char* cache_get(CacheEntry* e, size_t* size);
+
+/* Inizia la scrittura dell'elemento: restituisce il file su cui
+   scrivere il risultato, oppure NULL se la cartella non è
+   scrivibile. */
+FILE* cache_put_begin(CacheEntry* e);
+
+/* Completa la scrittura dell'elemento e poi, se la cartella supera
+   `maxBytes` byte, elimina gli elementi usati meno di recente finché
+   ne resta circa tre quarti. La cartella viene esaminata solo in
+   questo caso: il totale dei byte è tenuto in un file della cartella. */
+void cache_put_end(CacheEntry* e, long maxBytes);
+
+#endif
@@ -0,0 +1,669 @@
+/****************************************************************************
+ *
+ * coverage.c -- Percorso di pulizia completa (boustrophedon)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+La pianificazione lavora sulle posizioni ammesse per il centro del
+robot, cioè quelle per cui `setWeight()` non trova ostacoli sotto
+l'impronta 3x3, limitate a quelle raggiungibili dalla posizione
+iniziale. Il robot pulisce tutte le celle della mappa coperte
+dall'impronta in almeno una posizione del percorso.
+
+Lo spazio libero viene scomposto in _celle boustrophedon_ scorrendo la
+mappa per righe. Ogni riga è divisa in segmenti di posizioni libere
+consecutive; un segmento prosegue la cella del segmento della riga
+precedente se i due si sovrappongono e nessuno dei due si sovrappone
+ad altri segmenti. In caso contrario (un ostacolo divide lo spazio
+libero, oppure due zone si riuniscono) inizia una nuova cella. Ogni
+cella ha quindi un solo intervallo di colonne per riga, e righe
+consecutive hanno colonne in comune: tra due punti della stessa cella
+ci si può sempre spostare riga per riga senza uscire dalla cella.
+
+All'interno di una cella il robot percorre a serpentina una riga ogni
+tre (le _corsie_), perché l'impronta copre anche la riga superiore e
+quella inferiore. Le celle di pavimento che nessuna corsia copre (ai
+bordi degli ostacoli, dove le righe vicine sono più lunghe della
+corsia) vengono assegnate con una scelta golosa ad una posizione di
+una riga adiacente ad una corsia, che il robot visita con una breve
+deviazione durante il passaggio lungo la corsia. Le celle vengono
+visitate in profondità sul grafo delle adiacenze, spostandosi sempre
+attraverso celle già pulite; infine il robot raggiunge la stazione
+seguendo le distanze calcolate con una visita in ampiezza.
+
+Ogni fase esamina un numero costante di volte ogni posizione della
+mappa, quindi il tempo di calcolo è lineare nella dimensione della
+mappa (più la lunghezza del percorso prodotto).
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "graph.h"
+#include "coverage.h"
+#include "memstat.h"
+
+/* passaggio da una cella della decomposizione ad una cella adiacente:
+   dalla posizione (row, col) si passa in (next, col), che appartiene
+   alla cella `cell` */
+typedef struct {
+    int cell;
+    int row, next, col;
+} CellLink;
+
+/* segmento di posizioni libere consecutive su una riga */
+typedef struct {
+    int row, a, b;  /* riga e colonne estreme (incluse)             */
+    int cell;       /* cella della decomposizione                   */
+} Segment;
+
+/* decomposizione dello spazio libero e percorso in costruzione */
+typedef struct {
+    int m;
+    int ncells;
+    int* top;       /* top[c]: prima riga della cella c             */
+    int* height;    /* height[c]: numero di righe della cella c     */
+    int* seg;       /* seg[c]: posizione in lo[], hi[] della prima riga */
+    int* lo, * hi;  /* intervallo di colonne di ogni riga delle celle */
+    int* linkOff;   /* passaggi dalla cella c: link[linkOff[c]], ...,
+                       link[linkOff[c + 1] - 1]                     */
+    CellLink* link;
+    int* laneRow, * bandLo, * bandHi; /* corsie della cella corrente */
+    int* route;     /* posizioni visitate (riga * m + colonna)      */
+    int nroute, capacity;
+} Coverage;
+
+/* spostamenti di riga e colonna per le mosse N, S, E, O */
+static const int DR[4] = { -1, 1, 0, 0 };
+static const int DC[4] = { 0, 0, 1, -1 };
+static const char MOVES[4] = { 'N', 'S', 'E', 'O' };
+
+/* visita in ampiezza sulle posizioni valide a partire da `src`;
+   dist[v] = -1 per le posizioni non raggiungibili */
+static void grid_bfs(const char* valid, int n, int m, int src, int* dist, int* queue)
+{
+    int head = 0, tail = 0, i, k;
+
+    for (i = 0; i < n * m; i++)
+        dist[i] = -1;
+    dist[src] = 0;
+    queue[tail++] = src;
+    while (head < tail) {
+        const int u = queue[head++];
+        for (k = 0; k < 4; k++) {
+            /* le posizioni valide non toccano mai il bordo della
+               mappa, quindi i vicini sono sempre all'interno */
+            const int v = u + DR[k] * m + DC[k];
+            if (valid[v] && dist[v] < 0) {
+                dist[v] = dist[u] + 1;
+                queue[tail++] = v;
+            }
+        }
+    }
+}
+
+static int row_lo(const Coverage* cv, int c, int r)
+{
+    return cv->lo[cv->seg[c] + r - cv->top[c]];
+}
+
+static int row_hi(const Coverage* cv, int c, int r)
+{
+    return cv->hi[cv->seg[c] + r - cv->top[c]];
+}
+
+/* scompone le posizioni raggiungibili (reach[v] != 0) in celle
+   boustrophedon; restituisce la cella che contiene la posizione `start` */
+static int decompose(Coverage* cv, const char* reach, int n, int start)
+{
+    const int m = cv->m;
+    Segment* segs = NULL;
+    int nsegs = 0, capacity = 0;
+    int* edges = NULL; /* terne (cella superiore, cella inferiore, posizione) */
+    int nedges = 0, ecapacity = 0;
+    int* degUp = (int*)mem_alloc(MEM_SEARCH, m * sizeof(*degUp));
+    int* degDown = (int*)mem_alloc(MEM_SEARCH, m * sizeof(*degDown));
+    int* pairs = (int*)mem_alloc(MEM_SEARCH, 2 * m * sizeof(*pairs));
+    int prevFirst = 0, startCell = -1;
+    int r, c, i, j, k;
+
+    assert(degUp != NULL);
+    assert(degDown != NULL);
+    assert(pairs != NULL);
+
+    cv->ncells = 0;
+    for (r = 0; r < n; r++) {
+        const int curFirst = nsegs;
+        int np, nc, npairs = 0;
+
+        for (c = 0; c < m; c++) {
+            if (!reach[r * m + c])
+                continue;
+            if (nsegs == capacity) {
+                capacity = capacity == 0 ? 1024 : 2 * capacity;
+                segs = (Segment*)mem_realloc(MEM_SEARCH, segs, capacity * sizeof(*segs));
+                assert(segs != NULL);
+            }
+            segs[nsegs].row = r;
+            segs[nsegs].a = c;
+            while (c + 1 < m && reach[r * m + c + 1])
+                c++;
+            segs[nsegs].b = c;
+            segs[nsegs].cell = -1;
+            nsegs++;
+        }
+
+        /* coppie di segmenti sovrapposti tra la riga precedente e la
+           riga corrente: gli intervalli sono ordinati e disgiunti,
+           quindi basta una fusione */
+        np = curFirst - prevFirst;
+        nc = nsegs - curFirst;
+        for (i = 0; i < np; i++)
+            degDown[i] = 0;
+        for (j = 0; j < nc; j++)
+            degUp[j] = 0;
+        i = j = 0;
+        while (i < np && j < nc) {
+            const Segment* p = &segs[prevFirst + i];
+            const Segment* s = &segs[curFirst + j];
+            if (p->a <= s->b && s->a <= p->b) {
+                pairs[2 * npairs] = i;
+                pairs[2 * npairs + 1] = j;
+                npairs++;
+                degDown[i]++;
+                degUp[j]++;
+            }
+            if (p->b < s->b)
+                i++;
+            else
+                j++;
+        }
+
+        for (k = 0; k < npairs; k++) {
+            i = pairs[2 * k];
+            j = pairs[2 * k + 1];
+            if (degDown[i] == 1 && degUp[j] == 1)
+                segs[curFirst + j].cell = segs[prevFirst + i].cell;
+        }
+        for (j = 0; j < nc; j++) {
+            if (segs[curFirst + j].cell < 0)
+                segs[curFirst + j].cell = cv->ncells++;
+        }
+        for (k = 0; k < npairs; k++) {
+            const Segment* p = &segs[prevFirst + pairs[2 * k]];
+            const Segment* s = &segs[curFirst + pairs[2 * k + 1]];
+            if (p->cell != s->cell) {
+                if (nedges == ecapacity) {
+                    ecapacity = ecapacity == 0 ? 256 : 2 * ecapacity;
+                    edges = (int*)mem_realloc(MEM_SEARCH, edges, 3 * ecapacity * sizeof(*edges));
+                    assert(edges != NULL);
+                }
+                /* il passaggio avviene in una colonna comune */
+                edges[3 * nedges] = p->cell;
+                edges[3 * nedges + 1] = s->cell;
+                edges[3 * nedges + 2] = (r - 1) * m + (p->a > s->a ? p->a : s->a);
+                nedges++;
+            }
+        }
+        for (j = curFirst; j < nsegs; j++) {
+            if (start / m == r && segs[j].a <= start % m && start % m <= segs[j].b)
+                startCell = segs[j].cell;
+        }
+        prevFirst = curFirst;
+    }
+
+    /* ogni cella ha un segmento per riga, su righe consecutive: i
+       segmenti sono già ordinati per riga */
+    cv->top = (int*)mem_alloc(MEM_SEARCH, cv->ncells * sizeof(int));
+    cv->height = (int*)mem_calloc(MEM_SEARCH, cv->ncells, sizeof(int));
+    cv->seg = (int*)mem_alloc(MEM_SEARCH, (cv->ncells + 1) * sizeof(int));
+    cv->lo = (int*)mem_alloc(MEM_SEARCH, (nsegs + 1) * sizeof(int));
+    cv->hi = (int*)mem_alloc(MEM_SEARCH, (nsegs + 1) * sizeof(int));
+    assert(cv->top != NULL && cv->height != NULL && cv->seg != NULL);
+    assert(cv->lo != NULL && cv->hi != NULL);
+    for (i = nsegs - 1; i >= 0; i--) {
+        cv->top[segs[i].cell] = segs[i].row;
+        cv->height[segs[i].cell]++;
+    }
+    cv->seg[0] = 0;
+    for (c = 0; c < cv->ncells; c++)
+        cv->seg[c + 1] = cv->seg[c] + cv->height[c];
+    for (i = 0; i < nsegs; i++) {
+        const int pos = cv->seg[segs[i].cell] + segs[i].row - cv->top[segs[i].cell];
+        cv->lo[pos] = segs[i].a;
+        cv->hi[pos] = segs[i].b;
+    }
+
+    /* passaggi tra celle adiacenti, in entrambe le direzioni */
+    cv->linkOff = (int*)mem_calloc(MEM_SEARCH, cv->ncells + 1, sizeof(int));
+    cv->link = (CellLink*)mem_alloc(MEM_SEARCH, (2 * nedges + 1) * sizeof(CellLink));
+    assert(cv->linkOff != NULL && cv->link != NULL);
+    for (k = 0; k < nedges; k++) {
+        cv->linkOff[edges[3 * k] + 1]++;
+        cv->linkOff[edges[3 * k + 1] + 1]++;
+    }
+    for (c = 0; c < cv->ncells; c++)
+        cv->linkOff[c + 1] += cv->linkOff[c];
+    for (k = 0; k < nedges; k++) {
+        const int up = edges[3 * k], down = edges[3 * k + 1];
+        const int row = edges[3 * k + 2] / m, col = edges[3 * k + 2] % m;
+        CellLink* lu = &cv->link[cv->linkOff[up]++];
+        CellLink* ld = &cv->link[cv->linkOff[down]++];
+        lu->cell = down;
+        lu->row = row;
+        lu->next = row + 1;
+        lu->col = col;
+        ld->cell = up;
+        ld->row = row + 1;
+        ld->next = row;
+        ld->col = col;
+    }
+    /* il riempimento ha spostato ogni offset all'inizio della cella
+       successiva */
+    for (c = cv->ncells; c > 0; c--)
+        cv->linkOff[c] = cv->linkOff[c - 1];
+    cv->linkOff[0] = 0;
+
+    mem_free(MEM_SEARCH, segs);
+    mem_free(MEM_SEARCH, edges);
+    mem_free(MEM_SEARCH, degUp);
+    mem_free(MEM_SEARCH, degDown);
+    mem_free(MEM_SEARCH, pairs);
+    return startCell;
+}
+
+/* calcola le corsie della cella c: una riga ogni tre, in modo che
+   ogni riga della cella appartenga alla fascia (bandLo..bandHi) di
+   una corsia e disti al più 1 dalla corsia stessa. Restituisce il
+   numero di corsie. */
+static int cell_lanes(Coverage* cv, int c)
+{
+    const int top = cv->top[c], last = top + cv->height[c] - 1;
+    int nl = 0, l;
+
+    for (l = top + 1; l <= last; l += 3)
+        cv->laneRow[nl++] = l;
+    if (nl == 0 || cv->laneRow[nl - 1] + 1 < last)
+        cv->laneRow[nl++] = last;
+    for (l = 0; l < nl; l++) {
+        cv->bandLo[l] = (l == 0) ? top : cv->bandHi[l - 1] + 1;
+        cv->bandHi[l] = cv->laneRow[l] + 1 < last ? cv->laneRow[l] + 1 : last;
+    }
+    return nl;
+}
+
+/* segna come coperte le celle della mappa sotto l'impronta centrata
+   in (r, c); restituisce il numero di celle di pavimento coperte per
+   la prima volta */
+static int mark_footprint(char* covered, char** matrix, int m, int r, int c)
+{
+    int i, j, count = 0;
+
+    for (i = r - 1; i <= r + 1; i++) {
+        for (j = c - 1; j <= c + 1; j++) {
+            if (!covered[i * m + j] && terrain_cost(matrix[i][j]) >= 0) {
+                covered[i * m + j] = 1;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+static void route_push(Coverage* cv, int r, int c)
+{
+    const int v = r * cv->m + c;
+
+    if (cv->nroute > 0 && cv->route[cv->nroute - 1] == v)
+        return;
+    if (cv->nroute == cv->capacity) {
+        cv->capacity = cv->capacity == 0 ? 1024 : 2 * cv->capacity;
+        cv->route = (int*)mem_realloc(MEM_SEARCH, cv->route, cv->capacity * sizeof(*(cv->route)));
+        assert(cv->route != NULL);
+    }
+    cv->route[cv->nroute++] = v;
+}
+
+/* sposta il robot lungo la riga r dalla colonna c0 alla colonna c1 */
+static void route_row(Coverage* cv, int r, int c0, int c1)
+{
+    const int step = c1 > c0 ? 1 : -1;
+
+    while (c0 != c1) {
+        c0 += step;
+        route_push(cv, r, c0);
+    }
+}
+
+/* sposta il robot, restando nella cella c, dalla posizione corrente a
+   (r2, c2): si cambia riga in una colonna comune alle due righe,
+   scelta il più vicino possibile alla colonna corrente */
+static void cell_path(Coverage* cv, int c, int r2, int c2)
+{
+    int r = cv->route[cv->nroute - 1] / cv->m;
+    int col = cv->route[cv->nroute - 1] % cv->m;
+
+    while (r != r2) {
+        const int rn = r2 > r ? r + 1 : r - 1;
+        const int olo = row_lo(cv, c, r) > row_lo(cv, c, rn) ? row_lo(cv, c, r) : row_lo(cv, c, rn);
+        const int ohi = row_hi(cv, c, r) < row_hi(cv, c, rn) ? row_hi(cv, c, r) : row_hi(cv, c, rn);
+        const int x = col < olo ? olo : (col > ohi ? ohi : col);
+        route_row(cv, r, col, x);
+        col = x;
+        r = rn;
+        route_push(cv, r, col);
+    }
+    route_row(cv, r, col, c2);
+}
+
+/* deviazione dalla corsia l della cella c, con il robot in (l, x0):
+   passa sulla riga br e la percorre fino alla colonna x1, poi torna */
+static void detour(Coverage* cv, int l, int br, int x0, int x1)
+{
+    route_push(cv, br, x0);
+    route_row(cv, br, x0, x1);
+    route_row(cv, br, x1, x0);
+    route_push(cv, l, x0);
+}
+
+/* restituisce la colonna più lontana da x0, nella direzione `dir`,
+   tra le posizioni da visitare della riga br fino alla colonna xend
+   (esclusa x0); -1 se non ce ne sono */
+static int farthest_need(const char* need, int m, int br, int x0, int xend, int dir)
+{
+    int x;
+
+    if ((xend - x0) * dir <= 0)
+        return -1;
+    for (x = xend; x != x0; x -= dir) {
+        if (need[br * m + x])
+            return x;
+    }
+    return -1;
+}
+
+/* percorre la corsia l della cella c nella direzione `dir` (+1 verso
+   Est, -1 verso Ovest), con il robot già all'estremo di partenza;
+   visita anche le posizioni da visitare delle righe della fascia
+   lo..hi, che distano al più 1 dalla corsia */
+static void sweep_lane(Coverage* cv, const char* need, int c, int l, int lo, int hi, int dir)
+{
+    const int m = cv->m;
+    const int s = dir > 0 ? row_lo(cv, c, l) : row_hi(cv, c, l);
+    const int e = dir > 0 ? row_hi(cv, c, l) : row_lo(cv, c, l);
+    int br, x;
+
+    /* parti delle righe adiacenti che sporgono prima dell'inizio
+       della corsia */
+    for (br = l - 1; br <= l + 1; br += 2) {
+        if (br < lo || br > hi)
+            continue;
+        x = farthest_need(need, m, br, s, dir > 0 ? row_lo(cv, c, br) : row_hi(cv, c, br), -dir);
+        if (x >= 0)
+            detour(cv, l, br, s, x);
+    }
+    for (x = s; ; x += dir) {
+        route_push(cv, l, x);
+        for (br = l - 1; br <= l + 1; br += 2) {
+            if (br >= lo && br <= hi && need[br * m + x]) {
+                route_push(cv, br, x);
+                route_push(cv, l, x);
+            }
+        }
+        if (x == e)
+            break;
+    }
+    /* parti che sporgono oltre la fine della corsia */
+    for (br = l - 1; br <= l + 1; br += 2) {
+        if (br < lo || br > hi)
+            continue;
+        x = farthest_need(need, m, br, e, dir > 0 ? row_hi(cv, c, br) : row_lo(cv, c, br), dir);
+        if (x >= 0)
+            detour(cv, l, br, e, x);
+    }
+}
+
+/* pulisce la cella c partendo dalla posizione corrente del robot: le
+   corsie vengono percorse a partire dal lato della cella più vicino,
+   ognuna dall'estremo più vicino */
+static void cover_cell(Coverage* cv, const char* need, int c)
+{
+    const int nl = cell_lanes(cv, c);
+    const int top = cv->top[c], last = top + cv->height[c] - 1;
+    const int r = cv->route[cv->nroute - 1] / cv->m;
+    int k;
+
+    for (k = 0; k < nl; k++) {
+        const int j = (r - top <= last - r) ? k : nl - 1 - k;
+        const int l = cv->laneRow[j];
+        const int col = cv->route[cv->nroute - 1] % cv->m;
+        const int a = row_lo(cv, c, l), b = row_hi(cv, c, l);
+        const int dir = abs(col - a) <= abs(col - b) ? 1 : -1;
+        cell_path(cv, c, l, dir > 0 ? a : b);
+        sweep_lane(cv, need, c, l, cv->bandLo[j], cv->bandHi[j], dir);
+    }
+}
+
+/* sceglie, tra i passaggi dalla cella c verso celle non ancora
+   visitate, quello più vicino alla posizione corrente del robot. I
+   passaggi ancora da esaminare sono link[linkOff[c]], ...,
+   link[*end - 1]: quelli che portano a celle già visitate vengono
+   scartati spostandoli in fondo. Restituisce NULL se non ce ne sono. */
+static const CellLink* next_link(Coverage* cv, int c, int* end, const char* visited)
+{
+    const int r = cv->route[cv->nroute - 1] / cv->m;
+    const int col = cv->route[cv->nroute - 1] % cv->m;
+    int best = -1, bestDist = 0, i;
+    CellLink tmp;
+
+    for (i = cv->linkOff[c]; i < *end; ) {
+        const CellLink* e = &cv->link[i];
+        if (visited[e->cell]) {
+            (*end)--;
+            tmp = cv->link[i];
+            cv->link[i] = cv->link[*end];
+            cv->link[*end] = tmp;
+            continue;
+        }
+        if (best < 0 || abs(e->row - r) + abs(e->col - col) < bestDist) {
+            best = i;
+            bestDist = abs(e->row - r) + abs(e->col - col);
+        }
+        i++;
+    }
+    return best < 0 ? NULL : &cv->link[best];
+}
+
+int coverage_plan(char** matrix, int n, int m, int sr, int sc, int gr, int gc, CoveragePlan* plan)
+{
+    Coverage cv;
+    char* reach, * covered, * need;
+    int* dist, * queue, * linkEnd, * stack;
+    CellLink* parent;
+    char* visited;
+    int start, goal, startCell, done, sp, r, c, i, k;
+
+    assert(matrix != NULL);
+    assert(plan != NULL);
+
+    plan->length = -1;
+    plan->moves = NULL;
+    plan->covered = plan->floor = plan->ncells = 0;
+    for (r = 0; r < n; r++) {
+        for (c = 0; c < m; c++)
+            plan->floor += (terrain_cost(matrix[r][c]) >= 0);
+    }
+    if (sr < 1 || sr > n - 2 || sc < 1 || sc > m - 2 || setWeight(matrix, sr, sc) <= 0)
+        return -1;
+
+    /* posizioni ammesse per il centro, come in create_nodes(), e
+       raggiungibili dalla posizione iniziale */
+    start = sr * m + sc;
+    reach = (char*)mem_calloc(MEM_SEARCH, n * m, 1);
+    covered = (char*)mem_calloc(MEM_SEARCH, n * m, 1);
+    need = (char*)mem_calloc(MEM_SEARCH, n * m, 1);
+    dist = (int*)mem_alloc(MEM_SEARCH, n * m * sizeof(*dist));
+    queue = (int*)mem_alloc(MEM_QUEUE, n * m * sizeof(*queue));
+    assert(reach != NULL && covered != NULL && need != NULL);
+    assert(dist != NULL && queue != NULL);
+    for (r = 1; r < n - 1; r++) {
+        for (c = 1; c < m - 1; c++)
+            reach[r * m + c] = (setWeight(matrix, r, c) > 0);
+    }
+    grid_bfs(reach, n, m, start, dist, queue);
+    for (i = 0; i < n * m; i++)
+        reach[i] = (dist[i] >= 0);
+
+    memset(&cv, 0, sizeof(cv));
+    cv.m = m;
+    startCell = decompose(&cv, reach, n, start);
+    plan->ncells = cv.ncells;
+    cv.laneRow = (int*)mem_alloc(MEM_SEARCH, n * sizeof(int));
+    cv.bandLo = (int*)mem_alloc(MEM_SEARCH, n * sizeof(int));
+    cv.bandHi = (int*)mem_alloc(MEM_SEARCH, n * sizeof(int));
+    assert(cv.laneRow != NULL && cv.bandLo != NULL && cv.bandHi != NULL);
+
+    /* celle di pavimento coperte dalle corsie */
+    for (c = 0; c < cv.ncells; c++) {
+        const int nl = cell_lanes(&cv, c);
+        for (k = 0; k < nl; k++) {
+            const int l = cv.laneRow[k];
+            for (i = row_lo(&cv, c, l); i <= row_hi(&cv, c, l); i++)
+                plan->covered += mark_footprint(covered, matrix, m, l, i);
+        }
+    }
+    /* per ogni cella di pavimento ancora scoperta si sceglie una
+       posizione raggiungibile che la copra, preferendo quelle più in
+       basso a destra, che coprono più celle non ancora esaminate */
+    for (r = 0; r < n; r++) {
+        for (c = 0; c < m; c++) {
+            int q = -1, dr, dc;
+            if (covered[r * m + c] || terrain_cost(matrix[r][c]) < 0)
+                continue;
+            for (dr = 1; dr >= -1 && q < 0; dr--) {
+                for (dc = 1; dc >= -1 && q < 0; dc--) {
+                    const int rr = r + dr, cc = c + dc;
+                    if (rr >= 0 && rr < n && cc >= 0 && cc < m && reach[rr * m + cc])
+                        q = rr * m + cc;
+                }
+            }
+            if (q >= 0) {
+                need[q] = 1;
+                plan->covered += mark_footprint(covered, matrix, m, q / m, q % m);
+            }
+        }
+    }
+
+    goal = gr * m + gc;
+    if (gr >= 0 && gr < n && gc >= 0 && gc < m && reach[goal]) {
+        /* visita in profondità delle celle, con una pila esplicita */
+        linkEnd = (int*)mem_alloc(MEM_SEARCH, cv.ncells * sizeof(int));
+        parent = (CellLink*)mem_alloc(MEM_SEARCH, cv.ncells * sizeof(CellLink));
+        stack = (int*)mem_alloc(MEM_QUEUE, cv.ncells * sizeof(int));
+        visited = (char*)mem_calloc(MEM_SEARCH, cv.ncells, 1);
+        assert(linkEnd != NULL && parent != NULL && stack != NULL && visited != NULL);
+        for (c = 0; c < cv.ncells; c++)
+            linkEnd[c] = cv.linkOff[c + 1];
+
+        route_push(&cv, sr, sc);
+        visited[startCell] = 1;
+        stack[0] = startCell;
+        sp = 1;
+        cover_cell(&cv, need, startCell);
+        done = 1;
+        while (done < cv.ncells) {
+            const CellLink* e;
+            assert(sp > 0);
+            c = stack[sp - 1];
+            e = next_link(&cv, c, &linkEnd[c], visited);
+            if (e != NULL) {
+                cell_path(&cv, c, e->row, e->col);
+                route_push(&cv, e->next, e->col);
+                visited[e->cell] = 1;
+                parent[e->cell] = *e;
+                stack[sp++] = e->cell;
+                cover_cell(&cv, need, e->cell);
+                done++;
+            }
+            else {
+                /* si torna nella cella da cui si era entrati */
+                sp--;
+                assert(sp > 0);
+                e = &parent[c];
+                cell_path(&cv, c, e->next, e->col);
+                route_push(&cv, e->row, e->col);
+            }
+        }
+
+        /* ritorno alla stazione lungo un cammino minimo */
+        grid_bfs(reach, n, m, goal, dist, queue);
+        for (i = cv.route[cv.nroute - 1]; dist[i] > 0; ) {
+            for (k = 0; k < 4; k++) {
+                const int v = i + DR[k] * m + DC[k];
+                if (reach[v] && dist[v] == dist[i] - 1)
+                    break;
+            }
+            assert(k < 4);
+            i += DR[k] * m + DC[k];
+            route_push(&cv, i / m, i % m);
+        }
+
+        plan->length = cv.nroute - 1;
+        plan->moves = (char*)mem_alloc(MEM_SEARCH, cv.nroute);
+        assert(plan->moves != NULL);
+        for (i = 0; i < plan->length; i++) {
+            const int diff = cv.route[i + 1] - cv.route[i];
+            for (k = 0; k < 4 && diff != DR[k] * m + DC[k]; k++)
+                ;
+            assert(k < 4);
+            plan->moves[i] = MOVES[k];
+        }
+        plan->moves[plan->length] = '\0';
+
+        mem_free(MEM_SEARCH, linkEnd);
+        mem_free(MEM_SEARCH, parent);
+        mem_free(MEM_QUEUE, stack);
+        mem_free(MEM_SEARCH, visited);
+    }
+
+    mem_free(MEM_SEARCH, cv.top);
+    mem_free(MEM_SEARCH, cv.height);
+    mem_free(MEM_SEARCH, cv.seg);
+    mem_free(MEM_SEARCH, cv.lo);
+    mem_free(MEM_SEARCH, cv.hi);
+    mem_free(MEM_SEARCH, cv.linkOff);
+    mem_free(MEM_SEARCH, cv.link);
+    mem_free(MEM_SEARCH, cv.laneRow);
+    mem_free(MEM_SEARCH, cv.bandLo);
+    mem_free(MEM_SEARCH, cv.bandHi);
+    mem_free(MEM_SEARCH, cv.route);
+    mem_free(MEM_SEARCH, reach);
+    mem_free(MEM_SEARCH, covered);
+    mem_free(MEM_SEARCH, need);
+    mem_free(MEM_SEARCH, dist);
+    mem_free(MEM_QUEUE, queue);
+    return plan->length;
+}
+
+void coverage_free(CoveragePlan* plan)
+{
+    assert(plan != NULL);
+
+    mem_free(MEM_SEARCH, plan->moves);
+    plan->moves = NULL;
+}
@@ -0,0 +1,44 @@
+/****************************************************************************
+ *
+ * coverage.h -- Percorso di pulizia completa (boustrophedon)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+/* risultato della pianificazione della copertura */
+typedef struct {
+    int length;     /* numero di mosse del percorso, -1 se la stazione
+                       non e' raggiungibile dalla posizione iniziale   */
+    char* moves;    /* `length` mosse N/S/E/O terminate da '\0'        */
+    int covered;    /* celle di pavimento coperte dall'impronta        */
+    int floor;      /* celle di pavimento (non ostacolo) della mappa   */
+    int ncells;     /* celle della decomposizione boustrophedon        */
+} CoveragePlan;
+
+/* Calcola un percorso che parte dal centro (sr, sc), passa con
+   l'impronta 3x3 del robot su tutte le celle di pavimento che il robot
+   può raggiungere e termina sulla stazione (gr, gc). La mappa
+   `matrix` ha `n` righe e `m` colonne. Restituisce la lunghezza del
+   percorso (-1 se la stazione non è raggiungibile); `plan->covered`
+   e `plan->floor` vengono calcolati in ogni caso. */
+int coverage_plan(char** matrix, int n, int m, int sr, int sc, int gr, int gc, CoveragePlan* plan);
+
+/* Libera la memoria associata al percorso */
+void coverage_free(CoveragePlan* plan);
+
+#endif
@@ -0,0 +1,88 @@
+/****************************************************************************
+ *
+ * dijkstra.c -- Cammini minimi pesati con coda a bucket
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "graph.h"
+#include "bucketq.h"
+#include "dijkstra.h"
+
+/* restituisce il peso massimo tra gli archi percorribili del grafo */
+static int max_edge_weight(const Graph* g)
+{
+    const int n = graph_n_nodes(g);
+    int v, maxW = 0;
+
+    for (v = 0; v < n; v++) {
+        const Edge* e;
+        for (e = graph_adj(g, v); e != NULL; e = e->next) {
+            if (e->weight > maxW)
+                maxW = e->weight;
+        }
+    }
+    return maxW;
+}
+
+int dijkstra_dial(const Graph* g, int s, int* d, int* p)
+{
+    const int n = graph_n_nodes(g);
+    BucketQueue* q;
+    int nreached = 0;
+    int i;
+
+    assert((s >= 0) && (s < n));
+    assert(d != NULL);
+    assert(p != NULL);
+
+    for (i = 0; i < n; i++) {
+        d[i] = -1;
+        p[i] = -1;
+    }
+
+    q = bucketq_create(max_edge_weight(g));
+    d[s] = 0;
+    bucketq_insert(q, s, 0);
+
+    while (!bucketq_is_empty(q)) {
+        int du;
+        const int u = bucketq_delete_min(q, &du);
+        const Edge* edge;
+
+        /* un nodo può comparire più volte nella coda, se la sua
+           distanza è stata migliorata dopo l'inserimento: ignoriamo
+           le copie obsolete */
+        if (du > d[u])
+            continue;
+        nreached++;
+        for (edge = graph_adj(g, u); edge != NULL; edge = edge->next) {
+            const int v = edge->d;
+            const int w = edge->weight;
+            if (w < 0)
+                continue;
+            if (d[v] < 0 || du + w < d[v]) {
+                d[v] = du + w;
+                p[v] = u;
+                bucketq_insert(q, v, d[v]);
+            }
+        }
+    }
+    bucketq_destroy(q);
+    return nreached;
+}
@@ -0,0 +1,37 @@
+/****************************************************************************
+ *
+ * dijkstra.h -- Cammini minimi pesati con coda a bucket
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef DIJKSTRA_H
+#define DIJKSTRA_H
+
+#include "graph.h"
+
+/* Calcola i cammini di costo minimo dal nodo sorgente `s` a tutti gli
+   altri nodi con l'algoritmo di Dijkstra, usando la coda a bucket di
+   Dial. I pesi degli archi devono essere interi non negativi; gli
+   archi con peso negativo sono considerati non percorribili (come in
+   `search_bfs_to()`). Al termine `d[v]` contiene il costo minimo per
+   raggiungere `v` (-1 se non raggiungibile) e `p[v]` il predecessore
+   di `v` sul cammino minimo (-1 per la sorgente e per i nodi non
+   raggiungibili). Entrambi gli array devono essere allocati dal
+   chiamante con `n` elementi. Restituisce il numero di nodi
+   raggiungibili (inclusa la sorgente). */
+int dijkstra_dial(const Graph* g, int s, int* d, int* p);
+
+#endif
@@ -0,0 +1,248 @@
+/****************************************************************************
+ *
+ * distmap.c -- Distanza di ogni posizione della mappa dal primo ostacolo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+Un robot con impronta quadrata di lato $k = 2h + 1$ può avere il
+centro in $(r, c)$ se e solo se il quadrato $[r - h, r + h] \times
+[c - h, c + h]$ è dentro la mappa e non contiene ostacoli, cioè se la
+distanza di Chebyshev $D(r, c) = \max(|\Delta r|, |\Delta c|)$ dal
+più vicino ostacolo o dalla più vicina posizione esterna alla mappa è
+almeno $h + 1$. Con le distanze calcolate una volta, quindi, la
+verifica per qualunque impronta è un solo confronto.
+
+Le distanze si calcolano con la trasformata a maschera di Rosenfeld e
+Pfaltz (1966), esatta per la distanza di Chebyshev: una scansione
+dall'alto in basso e da sinistra a destra propaga $D(v) = \min(D(u) +
+1)$ dai vicini N, NO, NE e O, una scansione in senso opposto dai
+vicini S, SO, SE ed E. Le posizioni esterne valgono 0. Le due
+scansioni leggono la mappa e le distanze una riga alla volta, in
+ordine, e ogni riga è elaborata in due passi. Il passo verticale, il
+minimo sui tre vicini della riga precedente, non ha dipendenze tra le
+colonne e il compilatore lo traduce in istruzioni vettoriali. Il passo
+orizzontale, dal vicino della stessa riga, è una catena di dipendenze
+da una colonna alla successiva, ma dopo il passo verticale cambia solo
+le posizioni vicine agli ostacoli: viene eseguito solo sui blocchi di
+CHUNK posizioni in cui un controllo, anch'esso senza dipendenze, trova
+una distanza che supera di più di 1 quella della posizione vicina.
+
+Le distanze occupano un byte per posizione e sono saturate a
+DISTMAP_MAX: bastano per impronte fino a DISTMAP_MAX_SIDE. Il file
+delle distanze contiene l'hash della mappa e le sue dimensioni,
+seguite dalle distanze per righe.
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "distmap.h"
+#include "graph.h"
+#include "memstat.h"
+
+static const char DISTMAP_MAGIC[8] = { 'R', 'O', 'B', 'O', 'D', 'S', 'T', '1' };
+
+/* x + 1 saturato a DISTMAP_MAX */
+#define SAT_INC(x) ((x) + ((x) < DISTMAP_MAX))
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/* simbolo degli ostacoli nella mappa, l'unico con `terrain_cost()` < 0 */
+#define OBSTACLE '*'
+
+/* posizioni controllate insieme dalle scansioni orizzontali */
+#define CHUNK 64
+
+/* passo verticale della prima scansione: la riga `cur` riceve il
+   minimo dei vicini N, NO e NE, nella riga `up`, più 1 */
+static void from_above(uint8_t* restrict cur, const uint8_t* restrict up, const char* restrict row, int m)
+{
+    int j;
+
+    for (j = 1; j < m - 1; j++) {
+        const int a = MIN(up[j - 1], up[j]);
+        const int b = MIN(a, up[j + 1]);
+        cur[j] = (uint8_t)(SAT_INC(b) & -(row[j] != OBSTACLE));
+    }
+}
+
+/* passo verticale della seconda scansione, dai vicini S, SO e SE */
+static void from_below(uint8_t* restrict cur, const uint8_t* restrict down, int m)
+{
+    int j;
+
+    for (j = 1; j < m - 1; j++) {
+        const int a = MIN(down[j - 1], down[j]);
+        const int b = MIN(a, down[j + 1]);
+        const int v = SAT_INC(b);
+        cur[j] = (uint8_t)MIN(cur[j], v);
+    }
+}
+
+/* passo orizzontale della prima scansione: x[j] = min(x[j], x[j - 1]
+   + 1) da sinistra a destra, solo nei blocchi di CHUNK posizioni in
+   cui modifica qualcosa */
+static void from_left(uint8_t* x, int m)
+{
+    int a, j;
+
+    for (a = 1; a < m; a += CHUNK) {
+        const int b = MIN(a + CHUNK, m);
+        int bad = 0;
+        for (j = a; j < b; j++)
+            bad |= (x[j] > x[j - 1] + 1);
+        if (!bad)
+            continue;
+        for (j = a; j < b; j++) {
+            if (x[j] > x[j - 1] + 1)
+                x[j] = (uint8_t)(x[j - 1] + 1);
+        }
+    }
+}
+
+/* passo orizzontale della seconda scansione, da destra a sinistra */
+static void from_right(uint8_t* x, int m)
+{
+    int b, j;
+
+    for (b = m - 1; b > 0; b -= CHUNK) {
+        const int a = b > CHUNK ? b - CHUNK : 0;
+        int bad = 0;
+        for (j = a; j < b; j++)
+            bad |= (x[j] > x[j + 1] + 1);
+        if (!bad)
+            continue;
+        for (j = b - 1; j >= a; j--) {
+            if (x[j] > x[j + 1] + 1)
+                x[j] = (uint8_t)(x[j + 1] + 1);
+        }
+    }
+}
+
+void distmap_compute(char** matrix, int n, int m, DistMap* dm)
+{
+    uint8_t* d;
+    int i, j;
+
+    assert(n > 0 && m > 0);
+    assert(terrain_cost(OBSTACLE) < 0);
+    d = (uint8_t*)mem_alloc(MEM_MAP, (size_t)n * m);
+
+    /* prima scansione: vicini N, NO, NE e O */
+    for (i = 0; i < n; i++) {
+        const char* row = matrix[i];
+        uint8_t* cur = d + (size_t)i * m;
+
+        if (i == 0) {
+            for (j = 0; j < m; j++)
+                cur[j] = (row[j] != OBSTACLE);
+            continue;
+        }
+        from_above(cur, cur - m, row, m);
+        cur[0] = (row[0] != OBSTACLE);
+        cur[m - 1] = (row[m - 1] != OBSTACLE);
+        from_left(cur, m);
+    }
+
+    /* seconda scansione: vicini S, SO, SE ed E */
+    for (i = n - 1; i >= 0; i--) {
+        uint8_t* cur = d + (size_t)i * m;
+
+        if (i == n - 1) {
+            for (j = 0; j < m; j++)
+                cur[j] = MIN(cur[j], 1);
+            continue;
+        }
+        from_below(cur, cur + m, m);
+        from_right(cur, m);
+    }
+    dm->rows = n;
+    dm->cols = m;
+    dm->d = d;
+}
+
+void distmap_free(DistMap* dm)
+{
+    mem_free(MEM_MAP, dm->d);
+    dm->d = NULL;
+    dm->rows = dm->cols = 0;
+}
+
+void distmap_weights(const DistMap* dm, int k, signed char* w)
+{
+    const size_t size = (size_t)dm->rows * dm->cols;
+    const int h = k / 2;
+    size_t i;
+
+    assert(k > 0 && k % 2 == 1 && k <= DISTMAP_MAX_SIDE);
+    for (i = 0; i < size; i++)
+        w[i] = dm->d[i] > h ? 1 : -1;
+}
+
+int distmap_save(const DistMap* dm, const char* path, uint64_t mapHash)
+{
+    const size_t size = (size_t)dm->rows * dm->cols;
+    FILE* f = fopen(path, "wb");
+    int ok;
+
+    if (f == NULL)
+        return -1;
+    ok = (fwrite(DISTMAP_MAGIC, sizeof(DISTMAP_MAGIC), 1, f) == 1 &&
+          fwrite(&mapHash, sizeof(mapHash), 1, f) == 1 &&
+          fwrite(&dm->rows, sizeof(dm->rows), 1, f) == 1 &&
+          fwrite(&dm->cols, sizeof(dm->cols), 1, f) == 1 &&
+          fwrite(dm->d, 1, size, f) == size);
+    if (fclose(f) != 0 || !ok) {
+        remove(path);
+        return -1;
+    }
+    return 0;
+}
+
+int distmap_load(DistMap* dm, const char* path, uint64_t mapHash)
+{
+    char magic[sizeof(DISTMAP_MAGIC)];
+    uint64_t hash;
+    int rows, cols;
+    size_t size;
+    uint8_t* d;
+    FILE* f = fopen(path, "rb");
+
+    if (f == NULL)
+        return -1;
+    if (fread(magic, sizeof(magic), 1, f) != 1 ||
+        memcmp(magic, DISTMAP_MAGIC, sizeof(magic)) != 0 ||
+        fread(&hash, sizeof(hash), 1, f) != 1 || hash != mapHash ||
+        fread(&rows, sizeof(rows), 1, f) != 1 || rows <= 0 ||
+        fread(&cols, sizeof(cols), 1, f) != 1 || cols <= 0) {
+        fclose(f);
+        return -1;
+    }
+    size = (size_t)rows * cols;
+    d = (uint8_t*)mem_alloc(MEM_MAP, size);
+    if (fread(d, 1, size, f) != size) {
+        fclose(f);
+        mem_free(MEM_MAP, d);
+        return -1;
+    }
+    fclose(f);
+    dm->rows = rows;
+    dm->cols = cols;
+    dm->d = d;
+    return 0;
+}
@@ -0,0 +1,65 @@
+/****************************************************************************
+ *
+ * distmap.h -- Distanza di ogni posizione della mappa dal primo ostacolo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef DISTMAP_H
+#define DISTMAP_H
+
+#include <stdint.h>
+
+/* distanza massima memorizzata: le distanze maggiori vengono
+   saturate a questo valore */
+#define DISTMAP_MAX 255
+
+/* lato massimo dell'impronta per cui `distmap_weights()` è esatta */
+#define DISTMAP_MAX_SIDE (2 * DISTMAP_MAX - 1)
+
+/* distanze di una mappa di `rows` righe e `cols` colonne */
+typedef struct {
+    int rows;
+    int cols;
+    uint8_t* d;         /* d[r * cols + c]: distanza di Chebyshev della
+                           posizione (r, c) dall'ostacolo più vicino o
+                           dall'esterno della mappa (0 sugli ostacoli,
+                           1 sul bordo), al più DISTMAP_MAX             */
+} DistMap;
+
+/* Calcola le distanze della mappa `matrix` di `n` righe ed `m`
+   colonne con due scansioni, in tempo lineare nel numero di
+   posizioni. Sono ostacoli le posizioni con `terrain_cost()` < 0. */
+void distmap_compute(char** matrix, int n, int m, DistMap* dm);
+
+/* Libera la memoria associata alle distanze */
+void distmap_free(DistMap* dm);
+
+/* Scrive in `w` i pesi di tutte le posizioni per un robot con
+   impronta di lato `k`, nel formato di `graph_footprint_weights()`:
+   1 per le posizioni ammesse, -1 per le altre */
+void distmap_weights(const DistMap* dm, int k, signed char* w);
+
+/* Salva le distanze nel file `path`, insieme all'hash `mapHash` del
+   contenuto della mappa. Restituisce 0 se il salvataggio è riuscito,
+   -1 altrimenti. */
+int distmap_save(const DistMap* dm, const char* path, uint64_t mapHash);
+
+/* Legge in `dm` le distanze dal file `path`. Restituisce -1 se il
+   file non esiste oppure non corrisponde alla mappa con hash
+   `mapHash`, 0 altrimenti. */
+int distmap_load(DistMap* dm, const char* path, uint64_t mapHash);
+
+#endif
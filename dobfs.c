@@ -0,0 +1,156 @@
+/****************************************************************************
+ *
+ * dobfs.c -- Visita in ampiezza che sceglie la direzione ad ogni livello
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+La visita procede per livelli. Il passo _dall'alto in basso_ è quello
+della visita classica: ogni nodo della frontiera esamina tutti i suoi
+archi, e quasi tutti portano a nodi già raggiunti quando la frontiera
+è grande. Il passo _dal basso in alto_ (Beamer, Asanović, Patterson,
+2012) fa il contrario: ogni nodo non ancora raggiunto cerca tra i
+suoi vicini un nodo della frontiera, e si ferma al primo che trova. Un
+nodo è nella frontiera del livello `l` se e solo se d[v] == l, quindi
+non serve alcuna struttura in più per la frontiera.
+
+La scelta dipende da due quantità aggiornate ad ogni livello: gli
+archi uscenti dalla frontiera `mf`, cioè il lavoro del passo dall'alto
+in basso, e gli archi dei nodi non raggiunti `mu`, un limite superiore
+al lavoro del passo dal basso in alto. Si passa al basso in alto
+quando `mf > mu / DOBFS_ALPHA`, e si torna all'alto in basso quando la
+frontiera, in diminuzione, ha meno di `n / DOBFS_BETA` nodi.
+
+Il passo dal basso in alto non scandisce tutti i nodi: al primo passo
+viene costruito l'elenco dei nodi non raggiunti, che ad ogni passo
+successivo viene compattato togliendo quelli raggiunti. Entrambi i
+passi producono l'elenco dei nodi del livello successivo, che è la
+frontiera di partenza se il passo seguente è dall'alto in basso.
+***/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "dobfs.h"
+#include "memstat.h"
+
+int dobfs(const Graph* g, int s, int* d, int* p, Dobfs_mode mode, DobfsStats* stats)
+{
+    const int n = graph_n_nodes(g);
+    int* frontier = (int*)mem_alloc(MEM_QUEUE, n * sizeof(*frontier));
+    int* next = (int*)mem_alloc(MEM_QUEUE, n * sizeof(*next));
+    int* unvisited = NULL;
+    int nf, nn, prevNf = 0, nunvisited = 0, level = 0, nreached = 1, bottomUp = 0, v, i;
+    long mf, mu = 0;
+    DobfsStats st = { 0, 0, 0, 0 };
+
+    assert(frontier != NULL && next != NULL);
+    assert((s >= 0) && (s < n));
+    assert(d != NULL);
+
+    for (v = 0; v < n; v++) {
+        d[v] = -1;
+        if (p != NULL)
+            p[v] = -1;
+        mu += graph_out_degree(g, v);
+    }
+    d[s] = 0;
+    frontier[0] = s;
+    nf = 1;
+    mf = graph_out_degree(g, s);
+    mu -= mf;
+
+    while (nf > 0) {
+        const Edge* edge;
+        long mn = 0; /* archi uscenti dal livello successivo */
+
+        if (mode == DOBFS_HYBRID) {
+            if (!bottomUp && mf > mu / DOBFS_ALPHA)
+                bottomUp = 1;
+            else if (bottomUp && nf < prevNf && nf < n / DOBFS_BETA)
+                bottomUp = 0;
+        }
+        else
+            bottomUp = (mode == DOBFS_BOTTOM_UP);
+        nn = 0;
+        if (!bottomUp) {
+            st.topDown++;
+            for (i = 0; i < nf; i++) {
+                const int u = frontier[i];
+                for (edge = graph_adj(g, u); edge != NULL; edge = edge->next) {
+                    st.edgesTopDown++;
+                    v = edge->d;
+                    if (d[v] < 0 && edge->weight > -1) {
+                        d[v] = level + 1;
+                        if (p != NULL)
+                            p[v] = u;
+                        next[nn++] = v;
+                        mn += graph_out_degree(g, v);
+                    }
+                }
+            }
+        }
+        else {
+            int k = 0;
+            st.bottomUp++;
+            if (unvisited == NULL) {
+                unvisited = (int*)mem_alloc(MEM_QUEUE, n * sizeof(*unvisited));
+                assert(unvisited != NULL);
+                for (v = 0; v < n; v++) {
+                    if (d[v] < 0)
+                        unvisited[nunvisited++] = v;
+                }
+            }
+            for (i = 0; i < nunvisited; i++) {
+                v = unvisited[i];
+                if (d[v] >= 0)
+                    continue; /* raggiunto da un passo dall'alto in basso */
+                for (edge = graph_adj(g, v); edge != NULL; edge = edge->next) {
+                    st.edgesBottomUp++;
+                    if (d[edge->d] == level && edge->weight > -1)
+                        break;
+                }
+                if (edge == NULL) {
+                    unvisited[k++] = v;
+                    continue;
+                }
+                d[v] = level + 1;
+                if (p != NULL)
+                    p[v] = edge->d;
+                next[nn++] = v;
+                mn += graph_out_degree(g, v);
+            }
+            nunvisited = k;
+        }
+        /* il livello successivo diventa la frontiera */
+        {
+            int* tmp = frontier;
+            frontier = next;
+            next = tmp;
+        }
+        prevNf = nf;
+        nf = nn;
+        mf = mn;
+        mu -= mn;
+        nreached += nn;
+        level++;
+    }
+    mem_free(MEM_QUEUE, frontier);
+    mem_free(MEM_QUEUE, next);
+    mem_free(MEM_QUEUE, unvisited);
+    if (stats != NULL)
+        *stats = st;
+    return nreached;
+}
@@ -0,0 +1,58 @@
+/****************************************************************************
+ *
+ * dobfs.h -- Visita in ampiezza che sceglie la direzione ad ogni livello
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef DOBFS_H
+#define DOBFS_H
+
+#include "graph.h"
+
+/* Parametri di Beamer et al.: si passa dall'alto in basso al basso in
+   alto quando gli archi uscenti dalla frontiera superano 1/DOBFS_ALPHA
+   degli archi dei nodi non ancora raggiunti, e si torna indietro
+   quando la frontiera scende sotto 1/DOBFS_BETA dei nodi */
+#define DOBFS_ALPHA 14
+#define DOBFS_BETA 24
+
+/* direzione dei passi della visita */
+typedef enum {
+    DOBFS_HYBRID,       /* scelta ad ogni livello (default)             */
+    DOBFS_TOP_DOWN,     /* sempre dall'alto in basso                    */
+    DOBFS_BOTTOM_UP     /* sempre dal basso in alto                     */
+} Dobfs_mode;
+
+/* contatori di una visita */
+typedef struct {
+    int topDown;        /* livelli espansi dall'alto in basso           */
+    int bottomUp;       /* livelli espansi dal basso in alto            */
+    long edgesTopDown;  /* archi esaminati dall'alto in basso           */
+    long edgesBottomUp; /* archi esaminati dal basso in alto            */
+} DobfsStats;
+
+/* Visita in ampiezza completa del grafo `g` a partire da `s`: d[v] è la distanza di v da `s` e p[v] il suo
+   predecessore su un cammino minimo, -1 per `s` e per i nodi non
+   raggiungibili (`p` può essere NULL se i predecessori non servono).
+   Con `mode` diversi i predecessori possono differire, i cammini
+   hanno la stessa lunghezza. Il grafo deve essere simmetrico, come
+   quelli creati da una mappa: il passo dal basso in alto cerca il
+   predecessore di un nodo tra i suoi successori. Se `stats` non è
+   NULL vi vengono scritti i contatori della visita. Restituisce il
+   numero di nodi raggiunti (incluso `s`). */
+int dobfs(const Graph* g, int s, int* d, int* p, Dobfs_mode mode, DobfsStats* stats);
+
+#endif
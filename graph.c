@@ -32,9 +32,8 @@
 
  ```C
  typedef struct Edge {
-     int src;
-     int dst;
-     double weight;
+     int d;
+     int weight;
      struct Edge *next;
  } Edge;
 
@@ -50,12 +49,13 @@
  } Graph;
  ```
 
- `Edge` rappresenta un arco del grafo. Per grafi non orientati, ogni
- arco $(u,v)$ deve essere presente due volte: una come $(u,v)$ nella
- lista di adiacenza di $u$, e una come $(v,u)$ nella lista di adiacenza
- di $v$. Le liste sono concatenate semplici; il campo `next` indica
- l'arco successivo della lista di adiacenza, oppure `NULL` se è
- l'ultimo nodo.
+ `Edge` rappresenta un arco del grafo; il nodo sorgente non viene
+ memorizzato, perché è quello nella cui lista di adiacenza compare
+ l'arco. Per grafi non orientati, ogni arco $(u,v)$ deve essere
+ presente due volte: una come $(u,v)$ nella lista di adiacenza di $u$,
+ e una come $(v,u)$ nella lista di adiacenza di $v$. Le liste sono
+ concatenate semplici; il campo `next` indica l'arco successivo della
+ lista di adiacenza, oppure `NULL` se è l'ultimo nodo.
 
  La struttura `Graph` rappresenta l'intero grafo; la spiegazione dei
  vari campi è nel file [graph.h](graph.h).  Il campo `edges` è un array
@@ -134,27 +134,50 @@
 
  ***/
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <pthread.h>
+#include <sys/mman.h>
 #include "graph.h"
+#include "memstat.h"
 
-Graph* graph_create(int n, Graph_type t)
+/* alloca un grafo con `n` nodi senza inizializzare le liste di
+   adiacenza e i gradi */
+static Graph* graph_alloc(int n, Graph_type t)
 {
-    int i;
-    Graph* g = (Graph*)malloc(sizeof(*g));
+    Graph* g = (Graph*)mem_alloc(MEM_GRAPH, sizeof(*g));
     assert(g != NULL);
-    assert(n > 0);
+    assert(n >= 0);
 
     g->n = n;
     g->m = 0;
     g->t = t;
-    g->edges = (Edge**)malloc(n * sizeof(Edge*));
+    g->edges = (Edge**)mem_alloc(MEM_GRAPH, n * sizeof(Edge*));
     assert(g->edges != NULL);
-    g->in_deg = (int*)malloc(n * sizeof(*(g->in_deg)));
+    g->in_deg = (int*)mem_alloc(MEM_GRAPH, n * sizeof(*(g->in_deg)));
     assert(g->in_deg != NULL);
-    g->out_deg = (int*)malloc(n * sizeof(*(g->out_deg)));
+    g->out_deg = (int*)mem_alloc(MEM_GRAPH, n * sizeof(*(g->out_deg)));
     assert(g->out_deg != NULL);
+    g->rows = g->cols = 0;
+    g->pos = g->id = NULL;
+    g->layout = GRAPH_LAYOUT_ROWS;
+    g->pool = NULL;
+    g->comp = NULL;
+    g->mapping = NULL;
+    g->mappingSize = 0;
+    return g;
+}
+
+Graph* graph_create(int n, Graph_type t)
+{
+    int i;
+    Graph* g;
+
+    assert(n > 0);
+    g = graph_alloc(n, t);
     for (i = 0; i < n; i++) {
         g->edges[i] = NULL;
         g->in_deg[i] = g->out_deg[i] = 0;
@@ -168,21 +191,36 @@ void graph_destroy(Graph* g)
 
     assert(g != NULL);
 
-    for (i = 0; i < g->n; i++) {
-        Edge* edge = g->edges[i];
-        while (edge != NULL) {
-            Edge* next = edge->next;
-            free(edge);
-            edge = next;
+    if (g->mapping != NULL) {
+        /* tutti gli array sono nel file mappato in memoria */
+        munmap(g->mapping, g->mappingSize);
+        mem_free(MEM_GRAPH, g);
+        return;
+    }
+    if (g->pool != NULL) {
+        /* gli archi sono stati allocati in blocco */
+        mem_free(MEM_GRAPH, g->pool);
+        g->pool = NULL;
+    }
+    else {
+        for (i = 0; i < g->n; i++) {
+            Edge* edge = g->edges[i];
+            while (edge != NULL) {
+                Edge* next = edge->next;
+                mem_free(MEM_GRAPH, edge);
+                edge = next;
+            }
+            g->edges[i] = NULL; /* e' superfluo */
         }
-        g->edges[i] = NULL; /* e' superfluo */
     }
-    free(g->edges);
-    free(g->in_deg);
-    free(g->out_deg);
+    mem_free(MEM_GRAPH, g->edges);
+    mem_free(MEM_GRAPH, g->in_deg);
+    mem_free(MEM_GRAPH, g->out_deg);
+    mem_free(MEM_GRAPH, g->pos);
+    mem_free(MEM_GRAPH, g->id);
     g->n = 0;
     g->edges = NULL;
-    free(g);
+    mem_free(MEM_GRAPH, g);
 }
 
 Graph_type graph_type(const Graph* g)
@@ -190,21 +228,12 @@ Graph_type graph_type(const Graph* g)
     return g->t;
 }
 
-static Edge* new_edge(int src, int dst, int srcX, int srcY, int dstX, int dstY, double weight, Edge* next)
+static Edge* new_edge(int dst, int weight, Edge* next)
 {
-    Edge* edge = (Edge*)malloc(sizeof(Edge));
+    Edge* edge = (Edge*)mem_alloc(MEM_GRAPH, sizeof(Edge));
     assert(edge != NULL);
 
-    edge->s = src;
     edge->d = dst;
-    /* aggiungo la coordinata x della sorgente */
-    edge->src[0] = srcX; 
-    /* aggiungo la coordinata y della sorgente */
-    edge->src[1] = srcY;
-    /* aggiungo la coordinata x della destinazione */
-    edge->dst[0] = dstX;
-    /* aggiungo la coordinata y della destinazione */
-    edge->dst[1] = dstY;
     edge->weight = weight;
     edge->next = next;
     return edge;
@@ -217,7 +246,7 @@ static Edge* new_edge(int src, int dst, int srcX, int srcY, int dstX, int dstY,
    che aumenta il costo asintotico di questa operazione), la funzione
    restituisce true (nonzero) se e solo se l'arco (src, dst) esiste
    già e quindi non viene inserito. */
-static int graph_adj_insert(Graph* g, int src, int dst, int srcX, int srcY, int dstX, int dstY, double weight)
+static int graph_adj_insert(Graph* g, int src, int dst, int weight)
 {
 #if 0
     const Edge* e;
@@ -225,7 +254,7 @@ static int graph_adj_insert(Graph* g, int src, int dst, int srcX, int srcY, int
     /* Se si vuole rendere l'operazione più robusta, controlliamo che
        l'arco non esista già. */
     e = graph_adj(g, src);
-    while ((e != NULL) && (e->dst != dst)) {
+    while ((e != NULL) && (e->d != dst)) {
         e = e->next;
     }
     /* Arrivati qui abbiamo che e == NULL se e solo se l'arco
@@ -237,34 +266,30 @@ static int graph_adj_insert(Graph* g, int src, int dst, int srcX, int srcY, int
     /* Inseriamo l'arco all'inizio della lista di adiacenza.  Se non
        ci fosse il controllo precedente, l'inserimento di un arco
        richiederebbe tempo O(1) */
-    g->edges[src] = new_edge(src, dst, srcX, srcY, dstX, dstY, weight, g->edges[src]);
+    g->edges[src] = new_edge(dst, weight, g->edges[src]);
     g->in_deg[dst]++;
     g->out_deg[src]++;
     return 0;
 }
 
-void graph_add_edge(Graph* g, int src, int dst, int srcX, int srcY, int dstX, int dstY, double weight)
+void graph_add_edge(Graph* g, int src, int dst, int weight)
 {
     int status = 0;
 
     assert(g != NULL);
+    assert(g->pool == NULL);
 
     assert((src >= 0) && (src < graph_n_nodes(g)));
-    assert((srcX >= 0) && (srcX < graph_n_nodes(g)));
-    assert((srcY >= 0) && (srcY < graph_n_nodes(g)));
-
     assert((dst >= 0) && (dst < graph_n_nodes(g)));
-    assert((dstX >= 0) && (dstX < graph_n_nodes(g)));
-    assert((dstY >= 0) && (dstY < graph_n_nodes(g)));
 
-    status = graph_adj_insert(g, src, dst, srcX, srcY, dstX, dstY, weight);
+    status = graph_adj_insert(g, src, dst, weight);
     if (graph_type(g) == GRAPH_UNDIRECTED) {
-        status |= graph_adj_insert(g, src, dst, dstX, dstY, srcX, srcY, weight);
+        status |= graph_adj_insert(g, dst, src, weight);
     }
     if (status == 0)
         g->m++;
     else
-        fprintf(stderr, "Ho ignorato l'arco duplicato ((%d, %d), (%d, %d))\n", srcX, srcY, dstX, dstY);
+        fprintf(stderr, "Ho ignorato l'arco duplicato (%d, %d)\n", src, dst);
 }
 
 int graph_n_nodes(const Graph* g)
@@ -322,7 +347,10 @@ void graph_print(const Graph* g)
                             correttezza dei gradi uscenti */
         printf("[%2d] -> ", i);
         for (e = graph_adj(g, i); e != NULL; e = e->next) {
-            printf("src(%d, %d) dst(%d, %d) %f) -> ", e->src[0], e->src[1], e->dst[0], e->dst[1], e->weight);
+            if (g->pos != NULL)
+                printf("src(%d, %d) dst(%d, %d) %d) -> ", graph_node_row(g, i), graph_node_col(g, i), graph_node_row(g, e->d), graph_node_col(g, e->d), e->weight);
+            else
+                printf("(%d, %d, %d) -> ", i, e->d, e->weight);
             out_deg++;
         }
         assert(out_deg == graph_out_degree(g, i)); 
@@ -330,148 +358,566 @@ void graph_print(const Graph* g)
     }
 }
 
-/* funzione utilizzata per determinare i valori dei pesi di ogni nodo */
-double setWeight(int** matrix, int indX, int indY) {
-    int i, j;
+/* restituisce il costo di attraversamento di una cella della mappa in
+   base al carattere che la rappresenta, oppure -1 se la cella e' un
+   ostacolo. Oltre a '.' (pavimento) e '*' (ostacolo) sono ammessi:
+
+   - 'c' moquette (costo 2)
+   - 't' soglia/gradino (costo 3)
+   - 's' zona lenta (costo 4)
+   - '1'...'9' costo esplicito
+
+   Qualunque altro carattere viene trattato come pavimento. */
+int terrain_cost(int c) {
+    switch (c) {
+    case '*':
+        return -1;
+    case 'c':
+        return 2;
+    case 't':
+        return 3;
+    case 's':
+        return 4;
+    default:
+        if (c >= '1' && c <= '9')
+            return c - '0';
+        return 1;
+    }
+}
+
+/* funzione utilizzata per determinare i valori dei pesi di ogni nodo:
+   il peso e' il costo della cella piu' costosa coperta dal robot */
+double setWeight(char** matrix, int indX, int indY) {
+    int i, j, cost, maxCost = 1;
     for (i = indX - 1; i <= indX + 1; i++) {
         for (j = indY - 1; j <= indY + 1; j++) {
-            if (matrix[i][j] == 42) {
+            cost = terrain_cost(matrix[i][j]);
+            if (cost < 0) {
                 return -1; /* ritorno un valore non ammissibile di peso */ 
             }
+            if (cost > maxCost)
+                maxCost = cost;
         }
     }
-    return 1; /* ritorno il valore valido di peso */ 
+    return maxCost; /* ritorno il valore valido di peso */ 
 }
 
-/* inizializza una matrice con un valore uguale per ogni cella (-1) */
-void init_matrix(int** arr, size_t rows, size_t cols) {
-    int i, j;
-    for (i = 0; i < rows; i++)
-        arr[i] = malloc(sizeof * arr[i] * cols);
+/* valore che rappresenta un ostacolo nel calcolo dei pesi: maggiore
+   del costo di qualunque cella */
+#define OBSTACLE 127
 
-    for (i = 0; i < rows; i++)
-        for (j = 0; j < cols; j++)
-            arr[i][j] = -1;
+static signed char max3(signed char a, signed char b, signed char c)
+{
+    const signed char ab = a > b ? a : b;
+    return ab > c ? ab : c;
 }
 
-/* utilizzo la matrice ricavata dal file per creare ciascun nodo del grafo */
-void create_nodes(Graph* g, int n, int m, int** matrix, int** coordNodes, const int nNodes) {
-    int i = 1, j = 1, k = 0;
-    double weightSrc, weightDst;
+/* spostamenti verso SUD, NORD, EST e OVEST */
+static const int DR[4] = { 1, -1, 0, 0 };
+static const int DC[4] = { 0, 0, 1, -1 };
+
+/* fascia di righe della mappa assegnata ad un thread durante la
+   costruzione del grafo. Ogni thread scrive solo le righe, i nodi e
+   gli archi della propria fascia; le righe adiacenti delle altre
+   fasce vengono solo lette, dopo che la fase precedente è terminata
+   per tutti. */
+typedef struct {
+    Graph* g;
+    int n, m;           /* dimensioni della mappa                     */
+    char** matrix;
+    signed char* cost;  /* costo delle celle, poi peso delle posizioni */
+    signed char* hmax;  /* massimo sulle terne di celle di ogni riga  */
+    int r0, r1;         /* righe r0, ..., r1 - 1                      */
+    int firstNode;      /* primo nodo della fascia                    */
+    int nnodes;         /* numero di nodi della fascia                */
+    Edge* firstEdge;    /* primo arco della fascia nel blocco         */
+    int nedges;         /* numero di archi della fascia               */
+} Band;
+
+/* esegue `phase` su tutte le fasce, una per thread, e attende che
+   siano terminate tutte; la prima fascia viene elaborata dal thread
+   chiamante */
+static void run_bands(Band* bands, int k, void* (*phase)(void*))
+{
+    pthread_t* tid;
+    int t;
+
+    if (k == 1) {
+        phase(&bands[0]);
+        return;
+    }
+    tid = (pthread_t*)mem_alloc(MEM_GRAPH, k * sizeof(*tid));
+    assert(tid != NULL);
+    for (t = 1; t < k; t++) {
+        const int err = pthread_create(&tid[t], NULL, phase, &bands[t]);
+        assert(err == 0);
+        (void)err;
+    }
+    phase(&bands[0]);
+    for (t = 1; t < k; t++)
+        pthread_join(tid[t], NULL);
+    mem_free(MEM_GRAPH, tid);
+}
 
-    while (i < n - 1 && j < m && k < nNodes) {
-        /* reinizializzo il valore j per le colonne */
-        if (j == m - 1) {
-            j = 1;
-            i++;
+/* costo delle celle della riga `row` di `m` celle e massimo sulle
+   terne di celle consecutive. Gli ostacoli valgono OBSTACLE, che
+   supera qualunque costo. */
+static void row_costs(const char* row, int m, signed char* cost, signed char* hmax)
+{
+    int j;
+
+    for (j = 0; j < m; j++) {
+        const int c = terrain_cost(row[j]);
+        cost[j] = (c < 0) ? OBSTACLE : (signed char)c;
+    }
+    hmax[0] = hmax[m - 1] = -1;
+    for (j = 1; j < m - 1; j++)
+        hmax[j] = max3(cost[j - 1], cost[j], cost[j + 1]);
+}
+
+/* peso delle posizioni della riga i, come in setWeight(), come massimo
+   sulle terne di righe `up`, `mid` e `down` (-1 se sotto l'impronta
+   c'è un ostacolo o se il centro sta sul bordo). Restituisce il
+   numero di posizioni ammesse della riga. */
+static int row_weights(int i, int n, int m, const signed char* up, const signed char* mid,
+                       const signed char* down, signed char* w)
+{
+    int j, count = 0;
+
+    for (j = 0; j < m; j++) {
+        signed char mx = OBSTACLE;
+        if (i > 0 && i < n - 1 && j > 0 && j < m - 1)
+            mx = max3(up[j], mid[j], down[j]);
+        w[j] = (mx >= OBSTACLE) ? -1 : mx;
+        count += (w[j] > 0);
+    }
+    return count;
+}
+
+/* fase 1: costo delle celle e massimo sulle terne di celle di ogni
+   riga */
+static void* band_costs(void* arg)
+{
+    Band* b = (Band*)arg;
+    const int m = b->m;
+    int i;
+
+    for (i = b->r0; i < b->r1; i++)
+        row_costs(b->matrix[i], m, b->cost + i * m, b->hmax + i * m);
+    return NULL;
+}
+
+/* fase 2: peso di ogni posizione; i pesi sostituiscono i costi in
+   `cost`. Conta le posizioni ammesse della fascia. */
+static void* band_weights(void* arg)
+{
+    Band* b = (Band*)arg;
+    const int n = b->n, m = b->m;
+    int i;
+
+    b->nnodes = 0;
+    for (i = b->r0; i < b->r1; i++) {
+        const signed char* mid = b->hmax + i * m;
+        b->nnodes += row_weights(i, n, m, i > 0 ? mid - m : mid, mid,
+                                 i < n - 1 ? mid + m : mid, b->cost + i * m);
+    }
+    return NULL;
+}
+
+/* fase 2 per i pesi già calcolati: conta le posizioni ammesse della
+   fascia */
+static void* band_count(void* arg)
+{
+    Band* b = (Band*)arg;
+    int i;
+
+    b->nnodes = 0;
+    for (i = b->r0 * b->m; i < b->r1 * b->m; i++)
+        b->nnodes += (b->cost[i] > 0);
+    return NULL;
+}
+
+void graph_footprint_weights(char** matrix, int n, int m, int r0, int r1, signed char* w)
+{
+    /* righe da r0 - 1 a r1, quelle coperte dalle impronte */
+    const int lo = (r0 > 0) ? r0 - 1 : 0;
+    const int hi = (r1 < n) ? r1 : n - 1;
+    signed char* cost, * hmax;
+    int i;
+
+    assert(matrix != NULL);
+    assert(w != NULL);
+    assert((r0 >= 0) && (r0 <= r1) && (r1 <= n));
+
+    if (r0 == r1)
+        return;
+    cost = (signed char*)mem_alloc(MEM_GRAPH, m);
+    hmax = (signed char*)mem_alloc(MEM_GRAPH, (size_t)(hi - lo + 1) * m);
+    assert(cost != NULL && hmax != NULL);
+    for (i = lo; i <= hi; i++)
+        row_costs(matrix[i], m, cost, hmax + (size_t)(i - lo) * m);
+    for (i = r0; i < r1; i++) {
+        const signed char* mid = hmax + (size_t)(i - lo) * m;
+        row_weights(i, n, m, i > 0 ? mid - m : mid, mid, i < n - 1 ? mid + m : mid, w + (size_t)i * m);
+    }
+    mem_free(MEM_GRAPH, cost);
+    mem_free(MEM_GRAPH, hmax);
+}
+
+/* numero di posizioni ammesse adiacenti alla posizione ammessa `i`.
+   Un arco collega due posizioni ammesse adiacenti in entrambe le
+   direzioni, quindi il grado entrante coincide con quello uscente e
+   ogni fascia può calcolarlo senza toccare i nodi delle altre. Le
+   posizioni ammesse non stanno sul bordo della mappa, quindi i loro
+   vicini sono sempre all'interno. */
+static int node_degree(const signed char* w, int i, int m)
+{
+    int k, deg = 0;
+
+    for (k = 0; k < 4; k++)
+        deg += (w[i + DR[k] * m + DC[k]] > 0);
+    return deg;
+}
+
+/* fase 3: numerazione densa delle posizioni ammesse, riga per riga a
+   partire da `firstNode`, e gradi dei nodi */
+static void* band_nodes(void* arg)
+{
+    Band* b = (Band*)arg;
+    Graph* g = b->g;
+    const int m = b->m;
+    const signed char* w = b->cost;
+    int v = b->firstNode, i;
+
+    b->nedges = 0;
+    for (i = b->r0 * m; i < b->r1 * m; i++) {
+        if (w[i] <= 0) {
+            g->id[i] = -1;
+            continue;
         }
-        /* prendo il valore del peso della sorgente */
-        weightSrc = setWeight(matrix, i, j);
-        if (i + 2 <= n - 1) { /* guardo a SUD del nodo corrente */
-            /* prendo il valore del peso della destinazione (SUD) */
-            weightDst = setWeight(matrix, i + 1, j);
-            if (weightSrc > 0 && weightDst > 0) {
-                /* effettuo dei controlli sui pesi trovati */
-                if (coordNodes[i][j] == -1) {
-                    coordNodes[i][j] = k;
-                    k++;
-                }
-                if (coordNodes[i + 1][j] == -1) {
-                    coordNodes[i + 1][j] = k + 1;
-                    k += 2;
-                }
-                /* aggiungo il nodo con i valori aggiornati della matrice */
-                graph_add_edge(g, coordNodes[i][j], coordNodes[i + 1][j], i, j, i + 1, j, weightDst);
-            }
+        g->id[i] = v;
+        g->pos[v] = i;
+        g->out_deg[v] = g->in_deg[v] = node_degree(w, i, m);
+        b->nedges += g->out_deg[v];
+        v++;
+    }
+    return NULL;
+}
+
+/* fase 3 con un ordine diverso da quello per righe: i nodi sono già
+   stati numerati e ogni fascia calcola i gradi dei nodi firstNode,
+   ..., firstNode + nnodes - 1 */
+static void* band_degrees(void* arg)
+{
+    Band* b = (Band*)arg;
+    Graph* g = b->g;
+    int v;
+
+    b->nedges = 0;
+    for (v = b->firstNode; v < b->firstNode + b->nnodes; v++) {
+        g->out_deg[v] = g->in_deg[v] = node_degree(b->cost, g->pos[v], b->m);
+        b->nedges += g->out_deg[v];
+    }
+    return NULL;
+}
+
+/* assegna il nodo `v` alla posizione `i` se è ammessa; restituisce il
+   primo nodo ancora libero */
+static int number_position(Graph* g, const signed char* w, int i, int v)
+{
+    if (w[i] > 0) {
+        g->id[i] = v;
+        g->pos[v] = i;
+        v++;
+    }
+    return v;
+}
+
+/* numera per quadrati di GRAPH_TILE_SIDE celle di lato */
+static void number_tiles(Graph* g, const signed char* w)
+{
+    const int n = g->rows, m = g->cols, T = GRAPH_TILE_SIDE;
+    int tr, tc, i, j, v = 0;
+
+    for (tr = 0; tr < n; tr += T)
+        for (tc = 0; tc < m; tc += T)
+            for (i = tr; i < tr + T && i < n; i++)
+                for (j = tc; j < tc + T && j < m; j++)
+                    v = number_position(g, w, i * m + j, v);
+}
+
+/* bit di posto pari di `k`, compattati: 0b0101 -> 0b11 */
+static int even_bits(int k)
+{
+    int i, r = 0;
+
+    for (i = 0; (k >> (2 * i)) != 0; i++)
+        r |= ((k >> (2 * i)) & 1) << i;
+    return r;
+}
+
+/* numera secondo la curva di Morton il quadrato di lato `side` (una
+   potenza di 2) con l'angolo in alto a sinistra in (r0, c0), a
+   partire dal nodo `v`; restituisce il primo nodo ancora libero. I
+   quadranti che cadono fuori dalla mappa vengono saltati, e i
+   quadrati di 8 x 8 celle vengono percorsi senza ricorsione. */
+static int number_morton(Graph* g, const signed char* w, int r0, int c0, int side, int v)
+{
+    const int n = g->rows, m = g->cols;
+    int k;
+
+    if (r0 >= n || c0 >= m)
+        return v;
+    if (side > 8) {
+        side /= 2;
+        v = number_morton(g, w, r0, c0, side, v);
+        v = number_morton(g, w, r0, c0 + side, side, v);
+        v = number_morton(g, w, r0 + side, c0, side, v);
+        return number_morton(g, w, r0 + side, c0 + side, side, v);
+    }
+    for (k = 0; k < side * side; k++) {
+        const int i = r0 + even_bits(k >> 1), j = c0 + even_bits(k);
+        if (i < n && j < m)
+            v = number_position(g, w, i * m + j, v);
+    }
+    return v;
+}
+
+/* fase 4: archi dei nodi della fascia, a partire da `firstEdge`. Ogni
+   nodo ha un arco verso ciascuna posizione ammessa a SUD, NORD, EST e
+   OVEST, con il peso della posizione di destinazione. Gli archi
+   uscenti da ogni nodo sono consecutivi nel blocco, quindi le liste
+   di adiacenza vengono percorse in modo sequenziale. */
+static void* band_edges(void* arg)
+{
+    Band* b = (Band*)arg;
+    Graph* g = b->g;
+    const int m = b->m;
+    const signed char* w = b->cost;
+    Edge* e = b->firstEdge;
+    int v, k;
+
+    for (v = b->firstNode; v < b->firstNode + b->nnodes; v++) {
+        if (g->out_deg[v] == 0) {
+            g->edges[v] = NULL;
+            continue;
         }
-        if (i - 2 >= 0) { /* guardo a NORD del nodo corrente */
-            /* prendo il valore del peso della destinazione (NORD) */
-            weightDst = setWeight(matrix, i - 1, j);
-            if (weightSrc > 0 && weightDst > 0) {
-                /* effettuo dei controlli sui pesi trovati */
-                if (coordNodes[i][j] == -1) {
-                    coordNodes[i][j] = k;
-                    k++;
-                }
-                if (coordNodes[i - 1][j] == -1) {
-                    coordNodes[i - 1][j] = k + 1;
-                    k += 2;
-                }
-                /* aggiungo il nodo con i valori aggiornati della matrice */
-                graph_add_edge(g, coordNodes[i][j], coordNodes[i - 1][j], i, j, i - 1, j, weightDst);
+        g->edges[v] = e;
+        /* stesso ordine che si otterrebbe inserendo gli archi in
+           testa alla lista nell'ordine SUD, NORD, EST, OVEST */
+        for (k = 3; k >= 0; k--) {
+            const int u = g->pos[v] + DR[k] * m + DC[k];
+            if (w[u] > 0) {
+                e->d = g->id[u];
+                e->weight = w[u];
+                e->next = e + 1;
+                e++;
             }
         }
-        if (j + 2 <= m - 1) { /* guardo a EST del nodo corrente */
-            /* prendo il valore del peso della destinazione (EST) */
-            weightDst = setWeight(matrix, i, j + 1);
-            if (weightSrc > 0 && weightDst > 0) {
-                /* effettuo dei controlli sui pesi trovati */
-                if (coordNodes[i][j] == -1) {
-                    coordNodes[i][j] = k;
-                    k++;
-                }
-                if (coordNodes[i][j + 1] == -1) {
-                    coordNodes[i][j + 1] = k + 1;
-                    k += 2;
-                }
-                /* aggiungo il nodo con i valori aggiornati della matrice */
-                graph_add_edge(g, coordNodes[i][j], coordNodes[i][j + 1], i, j, i, j + 1, weightDst);
-            }
+        (e - 1)->next = NULL;
+    }
+    return NULL;
+}
+
+/* divide le `n` righe della mappa in (al più) `nthreads` fasce, ognuna
+   di almeno una riga; restituisce il numero di fasce */
+static int make_bands(Band** bands, int n, int m, char** matrix, signed char* cost, signed char* hmax, int nthreads)
+{
+    const int k = nthreads < n ? nthreads : n;
+    int t;
+
+    *bands = (Band*)mem_alloc(MEM_GRAPH, k * sizeof(**bands));
+    assert(*bands != NULL);
+    for (t = 0; t < k; t++) {
+        (*bands)[t].g = NULL;
+        (*bands)[t].n = n;
+        (*bands)[t].m = m;
+        (*bands)[t].matrix = matrix;
+        (*bands)[t].cost = cost;
+        (*bands)[t].hmax = hmax;
+        (*bands)[t].r0 = (int)((long)n * t / k);
+        (*bands)[t].r1 = (int)((long)n * (t + 1) / k);
+    }
+    return k;
+}
+
+/* fasi 3 e 4, a partire dai pesi in `bands[t].cost` e dal numero di
+   posizioni ammesse di ogni fascia */
+static Graph* graph_from_bands(Band* bands, int k, int n, int m, const int direction, Graph_layout layout)
+{
+    signed char* const cost = bands[0].cost;
+    int nNodes = 0, nEdges = 0, t, side;
+    Graph* g;
+
+    /* il numero di nodi di ogni fascia è noto solo dopo la fase 2:
+       il grafo viene allocato tra la fase 2 e la fase 3, e il blocco
+       degli archi tra la fase 3 e la fase 4 */
+    for (t = 0; t < k; t++) {
+        bands[t].firstNode = nNodes;
+        nNodes += bands[t].nnodes;
+    }
+
+    /* se la mappa non ammette alcuna posizione il grafo non ha nodi,
+       e qualunque nodo indicato e' fuori dai limiti */
+    g = graph_alloc(nNodes, direction);
+    g->rows = n;
+    g->cols = m;
+    g->layout = layout;
+    g->id = (int*)mem_alloc(MEM_GRAPH, n * m * sizeof(*(g->id)));
+    assert(g->id != NULL);
+    g->pos = (int*)mem_alloc(MEM_GRAPH, g->n * sizeof(*(g->pos)));
+    assert(g->pos != NULL);
+    for (t = 0; t < k; t++)
+        bands[t].g = g;
+    if (layout == GRAPH_LAYOUT_ROWS)
+        run_bands(bands, k, band_nodes);
+    else {
+        /* la numerazione non procede per fasce di righe e viene fatta
+           da un solo thread; i gradi vengono poi calcolati in
+           parallelo su intervalli di nodi di uguale ampiezza */
+        for (t = 0; t < n * m; t++)
+            g->id[t] = -1;
+        if (layout == GRAPH_LAYOUT_TILES)
+            number_tiles(g, cost);
+        else {
+            for (side = 8; side < n || side < m; side *= 2)
+                ;
+            number_morton(g, cost, 0, 0, side, 0);
         }
-        if (j - 2 >= 0) { /* guardo a OVEST del nodo corrente */
-            /* prendo il valore del peso della destinazione (OVEST) */
-            weightDst = setWeight(matrix, i, j - 1);
-            if (weightSrc > 0 && weightDst > 0) {
-                /* effettuo dei controlli sui pesi trovati */
-                if (coordNodes[i][j] == -1) {
-                    coordNodes[i][j] = k;
-                    k++;
-                }
-                if (coordNodes[i][j - 1] == -1) {
-                    coordNodes[i][j - 1] = k + 1;
-                    k += 2;
-                }
-                /* aggiungo il nodo con i valori aggiornati della matrice */
-                graph_add_edge(g, coordNodes[i][j], coordNodes[i][j - 1], i, j, i, j - 1, weightDst);
-            }
+        for (t = 0; t < k; t++) {
+            bands[t].firstNode = (int)((long)nNodes * t / k);
+            bands[t].nnodes = (int)((long)nNodes * (t + 1) / k) - bands[t].firstNode;
         }
-        j++;
+        run_bands(bands, k, band_degrees);
+    }
+
+    for (t = 0; t < k; t++)
+        nEdges += bands[t].nedges;
+    if (nEdges > 0) {
+        g->pool = (Edge*)mem_alloc(MEM_GRAPH, nEdges * sizeof(Edge));
+        assert(g->pool != NULL);
     }
+    nEdges = 0;
+    for (t = 0; t < k; t++) {
+        bands[t].firstEdge = (g->pool != NULL) ? g->pool + nEdges : NULL;
+        nEdges += bands[t].nedges;
+    }
+    run_bands(bands, k, band_edges);
+    g->m = (graph_type(g) == GRAPH_UNDIRECTED) ? nEdges / 2 : nEdges;
+    return g;
 }
 
 /* crea un grafo a partire dalla matrice ricavata dalla lettura di un file */
-Graph* graph_create_from_matrix(char* f, int** matrix, const int direction)
+Graph* graph_create_from_matrix(char** matrix, int n, int m, const int direction, int nthreads, Graph_layout layout)
 {
-    int n, m, nNodes;
-    int** coordNodes;
+    signed char* cost, * hmax;
+    Band* bands;
     Graph* g;
-    FILE* file = stdin;
-    file = fopen(f, "r");
+    int k;
 
-    assert(file != NULL);
+    assert(matrix != NULL);
+    assert(n > 0);
+    assert(m > 0);
+    assert((direction == GRAPH_UNDIRECTED) || (direction == GRAPH_DIRECTED));
+    assert(nthreads > 0);
+    assert(layout == GRAPH_LAYOUT_ROWS || layout == GRAPH_LAYOUT_TILES || layout == GRAPH_LAYOUT_MORTON);
+
+    cost = (signed char*)mem_alloc(MEM_GRAPH, n * m);
+    assert(cost != NULL);
+    hmax = (signed char*)mem_alloc(MEM_GRAPH, n * m);
+    assert(hmax != NULL);
+    k = make_bands(&bands, n, m, matrix, cost, hmax, nthreads);
+    run_bands(bands, k, band_costs);
+    run_bands(bands, k, band_weights);
+    g = graph_from_bands(bands, k, n, m, direction, layout);
+    mem_free(MEM_GRAPH, cost);
+    mem_free(MEM_GRAPH, hmax);
+    mem_free(MEM_GRAPH, bands);
+    return g;
+}
 
-    if (2 != fscanf(file, "%d %d ", &n, &m)) {
-        fprintf(stderr, "ERRORE durante la lettura dell'intestazione del grafo\n");
-        abort();
-    }
+Graph* graph_create_from_weights(signed char* weights, int n, int m, const int direction, int nthreads, Graph_layout layout)
+{
+    Band* bands;
+    Graph* g;
+    int k;
 
+    assert(weights != NULL);
     assert(n > 0);
-    assert(m >= 0);
+    assert(m > 0);
+    assert((direction == GRAPH_UNDIRECTED) || (direction == GRAPH_DIRECTED));
+    assert(nthreads > 0);
+    assert(layout == GRAPH_LAYOUT_ROWS || layout == GRAPH_LAYOUT_TILES || layout == GRAPH_LAYOUT_MORTON);
+
+    k = make_bands(&bands, n, m, NULL, weights, NULL, nthreads);
+    run_bands(bands, k, band_count);
+    g = graph_from_bands(bands, k, n, m, direction, layout);
+    mem_free(MEM_GRAPH, bands);
+    return g;
+}
 
-    nNodes = (n - 2) * (m - 2); /* calcolo il numero totale dei nodi del grado
-                            considerando ognuno di dimensione 3x3 */
+int graph_node_row(const Graph* g, int v)
+{
+    assert(g != NULL);
+    assert(g->pos != NULL);
+    assert((v >= 0) && (v < graph_n_nodes(g)));
 
-    assert(nNodes > 0);
-    assert((direction == GRAPH_UNDIRECTED) || (direction == GRAPH_DIRECTED));
+    return g->pos[v] / g->cols;
+}
 
-    g = graph_create(nNodes, direction);
+int graph_node_col(const Graph* g, int v)
+{
+    assert(g != NULL);
+    assert(g->pos != NULL);
+    assert((v >= 0) && (v < graph_n_nodes(g)));
 
-    coordNodes = malloc(sizeof * coordNodes * n);
-    init_matrix(coordNodes, n, m);
+    return g->pos[v] % g->cols;
+}
 
-    create_nodes(g, n, m, matrix, coordNodes, nNodes);
+int graph_node_from_rank(const Graph* g, int k)
+{
+    int i;
 
-    return g;
+    assert(g != NULL);
+    assert(g->id != NULL);
+
+    if (g->layout == GRAPH_LAYOUT_ROWS)
+        return k;
+    for (i = 0; i < g->rows * g->cols; i++)
+        if (g->id[i] >= 0 && k-- == 0)
+            return g->id[i];
+    return -1;
+}
+
+void graph_nodes_from_ranks(const Graph* g, int* v, int k)
+{
+    int* byRank;
+    int i, nr = 0;
+
+    assert(g != NULL);
+    assert(g->id != NULL);
+    assert(v != NULL);
+
+    if (g->layout == GRAPH_LAYOUT_ROWS)
+        return;
+    byRank = (int*)mem_alloc(MEM_GRAPH, g->n * sizeof(*byRank));
+    assert(byRank != NULL);
+    for (i = 0; i < g->rows * g->cols; i++)
+        if (g->id[i] >= 0)
+            byRank[nr++] = g->id[i];
+    for (i = 0; i < k; i++)
+        v[i] = (v[i] >= 0 && v[i] < nr) ? byRank[v[i]] : -1;
+    mem_free(MEM_GRAPH, byRank);
+}
+
+int graph_node_at(const Graph* g, int r, int c)
+{
+    assert(g != NULL);
+    assert(g->id != NULL);
+
+    if (r < 0 || r >= g->rows || c < 0 || c >= g->cols)
+        return -1;
+    return g->id[r * g->cols + c];
 }
 
 void graph_write_to_file(FILE* f, const Graph* g)
@@ -490,7 +936,6 @@ void graph_write_to_file(FILE* f, const Graph* g)
     for (v = 0; v < n; v++) {
         const Edge* e;
         for (e = graph_adj(g, v); e != NULL; e = e->next) {
-            assert(e->s == v);
             /* Se il grafo è non orientato, dobbiamo ricordarci che
                gli archi compaiono due volte nelle liste di
                adiacenza. Nel file pero' dobbiamo riportare ogni arco
@@ -500,62 +945,52 @@ void graph_write_to_file(FILE* f, const Graph* g)
                sola volta nel file. Per comodità, salviamo nel file la
                versione di ciascun arco in cui il nodo sorgente è
                minore del nodo destinazione. */
-            if ((graph_type(g) == GRAPH_DIRECTED) || (e->src < e->dst)) {
-                fprintf(f, "src(%d, %d) dst(%d, %d) %f\n", e->src[0], e->src[1], e->dst[0], e->dst[1], e->weight);
+            if ((graph_type(g) == GRAPH_DIRECTED) || (v < e->d)) {
+                fprintf(f, "%d %d %d\n", v, e->d, e->weight);
             }
         }
     }
 }
 
-/* restituisce la dimensione dell'array passato in input */
-int get_array_dim(const int* path, int n) {
-    int i, dim = 0;
-    for (i = 0; i < n; i++) {
-        if (path[i] != -1)
-            dim++;
-    }
-    return dim;
-}
+/* stampa su file l'intestazione `header` seguita dalle mosse
+   (N/S/E/O) del percorso */
+static void path_write(FILE* f, Graph* g, const List* path, int src, int header) {
+    const ListNode* node;
+    int prevX, prevY;
 
-/* stampa il percorso su un file */
-void path_write_to_file(FILE* f, Graph* g, const List* path, int src) {
-    int v, dim = 0;
-    const Edge* srcNode = graph_adj(g, src);
-    int prevX = srcNode->src[0];
-    int prevY = srcNode->src[1];
-    
     assert(path != NULL);
     assert(f != NULL);
 
-    dim = list_length(path);
-
-    if (dim == 0) {
-        int val = list_nth_element(path, 0)->val;
-        if (val != 0)
-            fprintf(f, "%d\n", (int) -1);
-        else 
-            fprintf(f, "%d\n", val);
+    if (list_is_empty(path)) {
+        fprintf(f, "%d\n", (int) -1);
         return;
     }
 
-    fprintf(f, "%u\n", dim - 1);
-    for (v = 0; v < dim; v++) {
-        const Edge* node = graph_adj(g, list_nth_element(path, v)->val);
-        if (node->src[0] > prevX && node->src[1] == prevY) {
+    fprintf(f, "%d\n", header);
+    prevX = graph_node_row(g, src);
+    prevY = graph_node_col(g, src);
+    for (node = list_first(path); node != list_end(path); node = list_succ(node)) {
+        const int curX = graph_node_row(g, node->val);
+        const int curY = graph_node_col(g, node->val);
+        if (curX > prevX && curY == prevY)
             fprintf(f, "S");
-            prevX = node->src[0];
-        }
-        else if (node->src[0] < prevX && node->src[1] == prevY) {
+        else if (curX < prevX && curY == prevY)
             fprintf(f, "N");
-            prevX = node->src[0];
-        }
-        else if (node->src[1] < prevY && node->src[0] == prevX) {
+        else if (curY < prevY && curX == prevX)
             fprintf(f, "O");
-            prevY = node->src[1];
-        }
-        else if (node->src[1] > prevY && node->src[0] == prevX) {
+        else if (curY > prevY && curX == prevX)
             fprintf(f, "E");
-            prevY = node->src[1];
-        }
+        prevX = curX;
+        prevY = curY;
     }
 }
+
+/* stampa il percorso su un file */
+void path_write_to_file(FILE* f, Graph* g, const List* path, int src) {
+    path_write(f, g, path, src, list_length(path) - 1);
+}
+
+/* stampa su un file il costo totale del percorso seguito dalle mosse */
+void path_cost_write_to_file(FILE* f, Graph* g, const List* path, int src, int cost) {
+    path_write(f, g, path, src, cost);
+}
@@ -23,21 +23,31 @@
 #define GRAPH_H
 
 #include <stdio.h>
+#include <stddef.h>
 
 #include "list.h"
 
-/* struttura arco */
+/* struttura arco: il nodo sorgente è quello nella cui lista di
+   adiacenza compare l'arco, e le coordinate dei nodi si ricavano con
+   `graph_node_row()` e `graph_node_col()` */
 typedef struct Edge {
-    int s;                  /* nodo sorgente        */
     int d;                  /* nodo destinazione    */
-    int src[2];            /* coordinate nodo sorgente        */
-    int dst[2];            /* coordinate nodo destinazione    */
-    double weight;      /* peso dell'arco       */
+    int weight;             /* peso dell'arco       */
     struct Edge *next;
 } Edge;
 
 typedef enum { GRAPH_UNDIRECTED, GRAPH_DIRECTED } Graph_type;
 
+/* ordine in cui vengono numerate le posizioni ammesse di una mappa:
+   per righe, per quadrati di GRAPH_TILE_SIDE x GRAPH_TILE_SIDE celle
+   (i quadrati per righe, le celle di ogni quadrato per righe) oppure
+   secondo la curva di Morton (ordine Z). Negli ultimi due casi le
+   posizioni vicine in verticale hanno numeri vicini, quindi anche i
+   loro elementi negli array indicizzati per nodo. */
+typedef enum { GRAPH_LAYOUT_ROWS, GRAPH_LAYOUT_TILES, GRAPH_LAYOUT_MORTON } Graph_layout;
+
+#define GRAPH_TILE_SIDE 16
+
 /* struttura grafo */
 typedef struct {
     int n;              /* numero di nodi               */
@@ -46,6 +56,22 @@ typedef struct {
     Edge **edges;       /* array di liste di adiacenza  */
     int *in_deg;        /* grado entrante dei nodi      */
     int *out_deg;       /* grado uscente dei nodi       */
+    int rows, cols;     /* dimensioni della mappa (0 se il grafo non
+                           e' stato creato da una mappa) */
+    int *pos;           /* pos[v] = riga * cols + colonna del nodo v */
+    int *id;            /* id[riga * cols + colonna] = nodo, -1 se la
+                           posizione non e' ammessa */
+    Graph_layout layout; /* ordine di numerazione dei nodi */
+    Edge *pool;         /* blocco unico che contiene tutti gli archi, se
+                           il grafo e' stato creato da una mappa; NULL
+                           se gli archi sono allocati uno alla volta */
+    int *comp;          /* comp[v] = componente connessa del nodo v, se
+                           nota (grafo letto da un'istantanea, vedi
+                           snapshot.h); NULL altrimenti */
+    void *mapping;      /* file mappato in memoria che contiene tutti
+                           gli array del grafo, NULL se gli array sono
+                           allocati dal programma */
+    size_t mappingSize; /* byte di `mapping` */
 } Graph;
 
 /* Crea un nuovo grafo con `n` nodi. Il numero di nodi deve essere
@@ -64,8 +90,10 @@ Graph_type graph_type(const Graph *g);
    assumere che l'arco non esista già (si può omettere il controllo,
    anche se nella soluzione fornita viene fatto). Nel caso di grafo
    non orientato, occorre aggiungere l'arco sia nella lista di
-   adiacenza di `src` che in quella di `dst`. */
-void graph_add_edge(Graph *g, int src, int dst, int srcX, int srcY, int dstX, int dstY, double weight);
+   adiacenza di `src` che in quella di `dst`. Non si può usare sui
+   grafi creati con `graph_create_from_matrix()`, i cui archi sono
+   allocati in blocco. */
+void graph_add_edge(Graph *g, int src, int dst, int weight);
 
 /* Restituisce un puntatore al primo arco della lista di adiacenza
    associata al nodo `v` (`NULL` se la lista è vuota) */
@@ -91,10 +119,65 @@ void graph_print(const Graph *g);
    stato aperto in scrittura. */
 void graph_write_to_file(FILE *f, const Graph *g);
 
-/* crea un grafo a partire dalla matrice ricavata dalla lettura di un file */
-Graph* graph_create_from_matrix(char* f, int** matrix, const int direction);
+/* crea un grafo a partire dalla matrice di `n` righe e `m` colonne
+   ricavata dalla lettura di un file. I nodi sono le posizioni ammesse
+   per il centro del robot, numerate nell'ordine `layout`: con
+   GRAPH_LAYOUT_ROWS il nodo 0 è la prima posizione ammessa della
+   prima riga, e così via; se nessuna posizione è ammessa il grafo
+   non ha nodi. Tutti gli archi vengono allocati con una sola
+   `malloc()`. La mappa viene divisa in `nthreads` fasce di
+   righe, elaborate in parallelo; il grafo prodotto non dipende dal
+   numero di thread. */
+Graph* graph_create_from_matrix(char** matrix, int n, int m, const int direction, int nthreads, Graph_layout layout);
+
+/* Scrive in `w + r * m`, per le righe r da `r0` a `r1` - 1, i pesi
+   delle posizioni della mappa `matrix` di `n` righe ed `m` colonne:
+   quelli calcolati da `setWeight()`, oppure -1 per le posizioni non
+   ammesse. Le impronte coprono anche le righe r0 - 1 ed r1, che
+   devono quindi essere già presenti in `matrix`. */
+void graph_footprint_weights(char** matrix, int n, int m, int r0, int r1, signed char* w);
+
+/* Come `graph_create_from_matrix()`, a partire dai pesi di tutte le
+   posizioni della mappa calcolati con `graph_footprint_weights()` */
+Graph* graph_create_from_weights(signed char* weights, int n, int m, const int direction, int nthreads, Graph_layout layout);
+
+/* Restituisce il nodo che occupa la posizione `k` nella numerazione
+   per righe delle posizioni ammesse, qualunque sia l'ordine con cui è
+   stato creato il grafo. Richiede tempo O(1) per i grafi numerati per
+   righe, altrimenti tempo proporzionale alla dimensione della mappa. */
+int graph_node_from_rank(const Graph *g, int k);
+
+/* Come `graph_node_from_rank()`, ma sostituisce ciascuno dei `k`
+   elementi di `v` con il nodo corrispondente, in tempo proporzionale
+   alla dimensione della mappa più `k` */
+void graph_nodes_from_ranks(const Graph *g, int *v, int k);
+
+/* Restituiscono la riga e la colonna della mappa in cui si trova il
+   centro del robot nel nodo `v`; il grafo deve essere stato creato
+   con `graph_create_from_matrix()`. Richiedono tempo O(1). */
+int graph_node_row(const Graph *g, int v);
+int graph_node_col(const Graph *g, int v);
+
+/* Restituisce il nodo corrispondente alla posizione (r, c) della
+   mappa, oppure -1 se il robot non può essere centrato in (r, c).
+   Richiede tempo O(1). */
+int graph_node_at(const Graph *g, int r, int c);
 
 /* stampa il percorso su un file */
 void path_write_to_file(FILE* f, Graph* g, const List* path, int src);
 
+/* stampa su un file il costo totale `cost` del percorso (anziché il
+   numero di mosse) seguito dalle mosse, nello stesso formato di
+   `path_write_to_file()` */
+void path_cost_write_to_file(FILE* f, Graph* g, const List* path, int src, int cost);
+
+/* restituisce il peso associato alla posizione del robot centrata in
+   (indX, indY), cioè il costo della cella più costosa coperta
+   dall'impronta 3x3, oppure -1 se l'impronta contiene un ostacolo */
+double setWeight(char** matrix, int indX, int indY);
+
+/* restituisce il costo di attraversamento della cella della mappa
+   rappresentata dal carattere `c` (-1 se e' un ostacolo) */
+int terrain_cost(int c);
+
 #endif
@@ -0,0 +1,503 @@
+/****************************************************************************
+ *
+ * jobs.c -- Esecuzione di molte richieste su più mappe con un pool di thread
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+Le richieste del manifesto vengono raggruppate per mappa (ordinandone
+gli indici per nome del file), così ogni mappa viene letta e
+trasformata in grafo una sola volta. Un unico pool di thread esegue
+due tipi di lavoro: la lettura di una mappa e le richieste di una
+mappa già letta, quindi mappe diverse vengono lette in parallelo e un
+manifesto con poche richieste per mappa usa comunque tutti i thread.
+
+Gli indici delle richieste stanno in un unico array, in cui le
+richieste di ogni mappa sono contigue. Ogni thread ha un blocco di
+quell'array, protetto da un mutex, e un proprio contesto di ricerca
+(`Search`): preleva le richieste dalla fine del proprio blocco, e
+quando il blocco è vuoto ruba la prima metà del blocco di un altro
+thread (_work stealing_). Se non c'è nulla da rubare il thread legge
+la mappa successiva, e il suo blocco diventa l'intervallo delle
+richieste di quella mappa, che gli altri thread possono rubargli.
+Le richieste hanno la precedenza sulla lettura, e i grafi in memoria
+sono al più JOBS_GRAPHS_PER_THREAD per thread: raggiunto il limite, un
+thread senza lavoro aspetta che l'ultima richiesta di un grafo lo
+liberi. Il grafo viene distrutto dal thread che esegue la sua ultima
+richiesta.
+
+Durante la ricerca i thread non condividono nulla tranne i grafi, che
+vengono solo letti; il mutex del pool protegge soltanto l'avanzamento
+delle letture. Ogni thread scrive il risultato nella stringa della
+richiesta che ha eseguito, e le stringhe vengono scritte nell'ordine
+del manifesto al termine.
+***/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "graph.h"
+#include "mapfile.h"
+#include "search.h"
+#include "jobs.h"
+#include "memstat.h"
+
+/* risultato di una richiesta che non è stato possibile eseguire */
+#define JOB_FAILED "-1\n\n"
+
+/* grafi in memoria per thread, al più */
+#define JOBS_GRAPHS_PER_THREAD 2
+
+int jobs_from_manifest(FILE* f, const char* name, Job** jobs)
+{
+    char line[4096], map[4096];
+    char extra;
+    int k = 0, cap = 64, lineno = 0, s, d;
+
+    *jobs = (Job*)mem_alloc(MEM_RESULTS, cap * sizeof(**jobs));
+    assert(*jobs != NULL);
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        if (1 == sscanf(line, " %c", &extra) && extra != '#') {
+            if (3 != sscanf(line, "%4095s %d %d %c", map, &s, &d, &extra)) {
+                fprintf(stderr, "%s:%d: richiesta non valida, attesi file_mappa, nodo_sorgente e nodo_destinazione\n", name, lineno);
+                jobs_free(*jobs, k);
+                return -1;
+            }
+            if (k == cap) {
+                cap *= 2;
+                *jobs = (Job*)mem_realloc(MEM_RESULTS, *jobs, cap * sizeof(**jobs));
+                assert(*jobs != NULL);
+            }
+            (*jobs)[k].map = (char*)mem_alloc(MEM_RESULTS, strlen(map) + 1);
+            assert((*jobs)[k].map != NULL);
+            strcpy((*jobs)[k].map, map);
+            (*jobs)[k].src = s;
+            (*jobs)[k].dst = d;
+            (*jobs)[k].line = lineno;
+            (*jobs)[k].result = NULL;
+            k++;
+        }
+    }
+    return k;
+}
+
+void jobs_free(Job* jobs, int njobs)
+{
+    int i;
+
+    for (i = 0; i < njobs; i++) {
+        mem_free(MEM_RESULTS, jobs[i].map);
+        mem_free(MEM_RESULTS, jobs[i].result);
+    }
+    mem_free(MEM_RESULTS, jobs);
+}
+
+/* blocco di richieste di un thread: gli indici da order[top] a
+   order[bottom - 1] */
+typedef struct {
+    pthread_mutex_t lock;
+    int top, bottom;
+} Block;
+
+/* richieste di una mappa: gli indici da order[first] a
+   order[first + count - 1] */
+typedef struct {
+    int first, count;
+    Graph* g;           /* grafo, se la mappa è stata letta              */
+    int remaining;      /* richieste ancora da eseguire sul grafo        */
+} MapGroup;
+
+/* stato condiviso dai thread */
+typedef struct {
+    Job* jobs;
+    int* order;         /* indici delle richieste, raggruppati per mappa */
+    const int* groupOf; /* groupOf[i] = gruppo della richiesta i         */
+    MapGroup* groups;
+    int ngroups;
+    Block* blocks;      /* un blocco per thread                          */
+    int nworkers;
+    int loadThreads;    /* thread usati per leggere ogni mappa           */
+    pthread_mutex_t lock; /* protegge i campi seguenti                   */
+    pthread_cond_t changed; /* segnalata quando un grafo viene creato o
+                               distrutto                                 */
+    int nextGroup;      /* prima mappa non ancora assegnata              */
+    int loading;        /* mappe in lettura                              */
+    int loaded;         /* grafi in memoria                              */
+    int maxLoaded;      /* limite di `loaded`                            */
+    int peakLoaded;     /* massimo raggiunto da `loaded`                 */
+    long generation;    /* numero di grafi creati o distrutti            */
+} Pool;
+
+/* thread del pool, con i suoi contatori */
+typedef struct {
+    Pool* pool;
+    int self;           /* indice del blocco del thread                  */
+    int group;          /* gruppo del grafo di `s`, -1 se `s` è NULL     */
+    Search* s;          /* contesto di ricerca dell'ultimo grafo usato   */
+    int nreached;       /* richieste con destinazione raggiungibile      */
+    int nstolen;        /* richieste rubate ad altri thread              */
+    int nfailed;        /* richieste non eseguibili                      */
+} Worker;
+
+static char* job_string(const char* s)
+{
+    char* r = (char*)mem_alloc(MEM_RESULTS, strlen(s) + 1);
+
+    assert(r != NULL);
+    strcpy(r, s);
+    return r;
+}
+
+/* scrive in `job->result` il percorso trovato dall'ultima ricerca
+   del contesto `s`, nello stesso formato di `path_write_to_file()`
+   seguito da una riga vuota */
+static void job_result(Job* job, const Graph* g, const Search* s, int src, int dst)
+{
+    const int len = search_dist(s, dst);
+    char* r;
+    int k, v;
+
+    if (len < 0) {
+        job->result = job_string(JOB_FAILED);
+        return;
+    }
+    r = (char*)mem_alloc(MEM_RESULTS, len + 16);
+    assert(r != NULL);
+    /* le mosse si ricavano a ritroso dalla destinazione, quindi
+       vengono scritte dall'ultima alla prima */
+    k = sprintf(r, "%d\n", len) + len;
+    strcpy(r + k, "\n");
+    for (v = dst; v != src; v = s->p[v]) {
+        const int u = s->p[v];
+        const int dr = graph_node_row(g, v) - graph_node_row(g, u);
+        const int dc = graph_node_col(g, v) - graph_node_col(g, u);
+        r[--k] = dr > 0 ? 'S' : dr < 0 ? 'N' : dc < 0 ? 'O' : 'E';
+    }
+    job->result = r;
+}
+
+/* preleva una richiesta dalla fine del blocco `b`; restituisce -1
+   se il blocco è vuoto */
+static int block_pop(Block* b, const int* order)
+{
+    int k = -1;
+
+    pthread_mutex_lock(&b->lock);
+    if (b->top < b->bottom)
+        k = order[--b->bottom];
+    pthread_mutex_unlock(&b->lock);
+    return k;
+}
+
+/* assegna al blocco `b`, che è vuoto, gli indici da order[top] a
+   order[bottom - 1] */
+static void block_set(Block* b, int top, int bottom)
+{
+    pthread_mutex_lock(&b->lock);
+    b->top = top;
+    b->bottom = bottom;
+    pthread_mutex_unlock(&b->lock);
+}
+
+/* ruba la prima metà (arrotondata per eccesso) del blocco di un altro
+   thread e la assegna al blocco del thread `w`, che è vuoto.
+   Restituisce il numero di richieste rubate, zero se tutti i blocchi
+   sono vuoti. */
+static int steal(Worker* w)
+{
+    Pool* const pool = w->pool;
+    int t;
+
+    for (t = 1; t < pool->nworkers; t++) {
+        Block* const victim = &pool->blocks[(w->self + t) % pool->nworkers];
+        int top = 0, h = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        if (victim->top < victim->bottom) {
+            h = (victim->bottom - victim->top + 1) / 2;
+            top = victim->top;
+            victim->top += h;
+        }
+        pthread_mutex_unlock(&victim->lock);
+        if (h > 0) {
+            block_set(&pool->blocks[w->self], top, top + h);
+            w->nstolen += h;
+            return h;
+        }
+    }
+    return 0;
+}
+
+/* carica la mappa del file `name` e ne costruisce il grafo, con
+   i nodi numerati per righe; restituisce NULL se la mappa non è
+   valida */
+static Graph* load_graph(const char* name, int nthreads)
+{
+    FILE* f = fopen(name, "r");
+    char** matrix;
+    Graph* g;
+    int rows, cols;
+
+    if (f == NULL) {
+        fprintf(stderr, "Can not open %s\n", name);
+        return NULL;
+    }
+    matrix = map_from_file(f, name, &rows, &cols, nthreads);
+    fclose(f);
+    if (matrix == NULL)
+        return NULL;
+    g = graph_create_from_matrix(matrix, rows, cols, 1, nthreads, GRAPH_LAYOUT_ROWS);
+    map_free(matrix);
+    return g;
+}
+
+/* distrugge il grafo del gruppo `gr`, di cui sono state eseguite
+   tutte le richieste, e lo segnala ai thread in attesa */
+static void release_graph(Pool* pool, MapGroup* gr)
+{
+    graph_destroy(gr->g);
+    gr->g = NULL;
+    pthread_mutex_lock(&pool->lock);
+    pool->loaded--;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->changed);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* legge la mappa del gruppo `gr`, già contata in `loading` e
+   `loaded`, e assegna al blocco del thread `w` le sue richieste
+   eseguibili; le altre ricevono subito il risultato -1 */
+static void load_group(Worker* w, MapGroup* gr)
+{
+    Pool* const pool = w->pool;
+    const char* const name = pool->jobs[pool->order[gr->first]].map;
+    Graph* const g = load_graph(name, pool->loadThreads);
+    const int n = (g != NULL) ? graph_n_nodes(g) : 0;
+    int k, count = 0;
+
+    /* le richieste non eseguibili vengono escluse, e le altre
+       compattate all'inizio del gruppo */
+    for (k = gr->first; k < gr->first + gr->count; k++) {
+        Job* const job = &pool->jobs[pool->order[k]];
+        if (g == NULL) {
+            job->result = job_string(JOB_FAILED);
+            w->nfailed++;
+        }
+        else if (job->src < 0 || job->src >= n || job->dst < 0 || job->dst >= n) {
+            fprintf(stderr, "%s: richiesta alla riga %d non valida: i nodi %d e %d devono essere compresi tra 0 e %d\n",
+                    job->map, job->line, job->src, job->dst, n - 1);
+            job->result = job_string(JOB_FAILED);
+            w->nfailed++;
+        }
+        else
+            pool->order[gr->first + count++] = pool->order[k];
+    }
+    gr->g = g;
+    gr->remaining = count;
+    if (count > 0)
+        block_set(&pool->blocks[w->self], gr->first, gr->first + count);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->loading--;
+    if (count == 0)
+        pool->loaded--;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->changed);
+    pthread_mutex_unlock(&pool->lock);
+    if (count == 0 && g != NULL)
+        graph_destroy(g);
+}
+
+/* esegue la richiesta di indice `k` */
+static void run_job(Worker* w, int k)
+{
+    Pool* const pool = w->pool;
+    MapGroup* const gr = &pool->groups[pool->groupOf[k]];
+    Job* const job = &pool->jobs[k];
+    int src, dst;
+
+    /* il contesto si riconosce dal gruppo e non dall'indirizzo del
+       grafo, che puo' essere riusato dopo la sua distruzione */
+    if (w->group != pool->groupOf[k]) {
+        if (w->s != NULL)
+            search_destroy(w->s);
+        w->s = search_create(gr->g);
+        w->group = pool->groupOf[k];
+    }
+    src = graph_node_from_rank(gr->g, job->src);
+    dst = graph_node_from_rank(gr->g, job->dst);
+    w->nreached += (search_bfs_to(w->s, gr->g, src, dst) >= 0);
+    job_result(job, gr->g, w->s, src, dst);
+    if (__atomic_sub_fetch(&gr->remaining, 1, __ATOMIC_ACQ_REL) == 0)
+        release_graph(pool, gr);
+}
+
+static void* worker_run(void* arg)
+{
+    Worker* const w = (Worker*)arg;
+    Pool* const pool = w->pool;
+
+    for (;;) {
+        const int k = block_pop(&pool->blocks[w->self], pool->order);
+        long seen;
+
+        if (k >= 0) {
+            run_job(w, k);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        if (steal(w) > 0)
+            continue;
+
+        pthread_mutex_lock(&pool->lock);
+        if (pool->nextGroup < pool->ngroups && pool->loaded < pool->maxLoaded) {
+            MapGroup* const gr = &pool->groups[pool->nextGroup++];
+            pool->loading++;
+            pool->loaded++;
+            if (pool->loaded > pool->peakLoaded)
+                pool->peakLoaded = pool->loaded;
+            pthread_mutex_unlock(&pool->lock);
+            load_group(w, gr);
+            continue;
+        }
+        if (pool->nextGroup == pool->ngroups && pool->loading == 0 && pool->generation == seen) {
+            /* nessuna mappa da leggere e nessuna richiesta da rubare:
+               quelle rimaste sono nei blocchi di thread attivi */
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        /* altre richieste arriveranno dalle mappe in lettura, oppure
+           un grafo liberato permetterà di leggere la mappa successiva */
+        while (pool->generation == seen)
+            pthread_cond_wait(&pool->changed, &pool->lock);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    if (w->s != NULL)
+        search_destroy(w->s);
+    return NULL;
+}
+
+/* ordine delle richieste per nome della mappa e, a parità di mappa,
+   per posizione nel manifesto */
+static const Job* sortJobs;
+
+static int compare_jobs(const void* a, const void* b)
+{
+    const int i = *(const int*)a, j = *(const int*)b;
+    const int c = strcmp(sortJobs[i].map, sortJobs[j].map);
+
+    return c != 0 ? c : i - j;
+}
+
+int jobs_run(Job* jobs, int njobs, int nthreads, FILE* out, FILE* info)
+{
+    int* order = (int*)mem_alloc(MEM_QUEUE, (njobs > 0 ? njobs : 1) * sizeof(*order));
+    int* groupOf = (int*)mem_alloc(MEM_QUEUE, (njobs > 0 ? njobs : 1) * sizeof(*groupOf));
+    MapGroup* groups = (MapGroup*)mem_alloc(MEM_QUEUE, (njobs > 0 ? njobs : 1) * sizeof(*groups));
+    int i, j, t, nfailed = 0, nreached = 0, ngroups = 0;
+    long nstolen = 0;
+    Pool pool;
+    Worker* workers;
+    pthread_t* tid;
+
+    assert(order != NULL && groupOf != NULL && groups != NULL);
+    for (i = 0; i < njobs; i++)
+        order[i] = i;
+    sortJobs = jobs;
+    qsort(order, njobs, sizeof(*order), compare_jobs);
+
+    /* le richieste della stessa mappa sono order[i .. j - 1] */
+    for (i = 0; i < njobs; i = j) {
+        for (j = i + 1; j < njobs && strcmp(jobs[order[j]].map, jobs[order[i]].map) == 0; j++)
+            ;
+        groups[ngroups].first = i;
+        groups[ngroups].count = j - i;
+        groups[ngroups].g = NULL;
+        groups[ngroups].remaining = 0;
+        for (t = i; t < j; t++)
+            groupOf[order[t]] = ngroups;
+        ngroups++;
+    }
+
+    pool.jobs = jobs;
+    pool.order = order;
+    pool.groupOf = groupOf;
+    pool.groups = groups;
+    pool.ngroups = ngroups;
+    pool.nworkers = nthreads;
+    /* con poche mappe ognuna viene letta da piu' thread, come senza -m */
+    pool.loadThreads = (ngroups > 0 && ngroups < nthreads) ? nthreads / ngroups : 1;
+    pool.nextGroup = 0;
+    pool.loading = 0;
+    pool.loaded = 0;
+    pool.maxLoaded = JOBS_GRAPHS_PER_THREAD * nthreads;
+    pool.peakLoaded = 0;
+    pool.generation = 0;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.changed, NULL);
+    pool.blocks = (Block*)mem_alloc(MEM_QUEUE, nthreads * sizeof(*pool.blocks));
+    workers = (Worker*)mem_alloc(MEM_QUEUE, nthreads * sizeof(*workers));
+    tid = (pthread_t*)mem_alloc(MEM_QUEUE, nthreads * sizeof(*tid));
+    assert(pool.blocks != NULL && workers != NULL && tid != NULL);
+    for (t = 0; t < nthreads; t++) {
+        pthread_mutex_init(&pool.blocks[t].lock, NULL);
+        pool.blocks[t].top = pool.blocks[t].bottom = 0;
+        workers[t].pool = &pool;
+        workers[t].self = t;
+        workers[t].group = -1;
+        workers[t].s = NULL;
+        workers[t].nreached = 0;
+        workers[t].nstolen = 0;
+        workers[t].nfailed = 0;
+    }
+    /* il primo thread del pool è il chiamante */
+    for (t = 1; t < nthreads; t++) {
+        const int err = pthread_create(&tid[t], NULL, worker_run, &workers[t]);
+        assert(err == 0);
+        (void)err;
+    }
+    worker_run(&workers[0]);
+    for (t = 1; t < nthreads; t++)
+        pthread_join(tid[t], NULL);
+    for (t = 0; t < nthreads; t++) {
+        nreached += workers[t].nreached;
+        nstolen += workers[t].nstolen;
+        nfailed += workers[t].nfailed;
+        pthread_mutex_destroy(&pool.blocks[t].lock);
+    }
+    assert(pool.loaded == 0);
+    pthread_mutex_destroy(&pool.lock);
+    pthread_cond_destroy(&pool.changed);
+
+    for (i = 0; i < njobs; i++)
+        fputs(jobs[i].result, out);
+    fprintf(info, "# %d richieste su %d mappe con %d thread, %d destinazioni raggiungibili, %ld richieste rubate, %d grafi al massimo in memoria\n",
+            njobs, ngroups, nthreads, nreached, nstolen, pool.peakLoaded);
+    mem_free(MEM_QUEUE, pool.blocks);
+    mem_free(MEM_QUEUE, workers);
+    mem_free(MEM_QUEUE, tid);
+    mem_free(MEM_QUEUE, groups);
+    mem_free(MEM_QUEUE, groupOf);
+    mem_free(MEM_QUEUE, order);
+    return nfailed;
+}
@@ -0,0 +1,54 @@
+/****************************************************************************
+ *
+ * jobs.h -- Esecuzione di molte richieste su più mappe con un pool di thread
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdio.h>
+
+/* richiesta del manifesto: percorso da `src` a `dst` (posizioni
+   numerate per righe) sulla mappa del file `map` */
+typedef struct {
+    char* map;      /* nome del file della mappa                      */
+    int src, dst;
+    int line;       /* riga del manifesto, per i messaggi di errore   */
+    char* result;   /* risultato, nel formato del file di output      */
+} Job;
+
+/* Legge dal file `f` (di nome `name`) il manifesto: una richiesta per
+   riga, nella forma "file_mappa nodo_sorgente nodo_destinazione"; le
+   righe vuote e quelle che iniziano con '#' vengono ignorate.
+   Restituisce il numero di richieste e in `*jobs` un array da
+   liberare con `jobs_free()`, oppure -1 se il manifesto non è
+   valido. */
+int jobs_from_manifest(FILE* f, const char* name, Job** jobs);
+
+/* Esegue le `njobs` richieste con `nthreads` thread e scrive i
+   risultati su `out` nell'ordine del manifesto: per ogni richiesta
+   la lunghezza del percorso e le mosse, come nella modalità -q. Ogni
+   mappa viene letta una sola volta, e le letture di mappe diverse
+   vengono eseguite in parallelo alle ricerche. Le richieste che non si possono
+   eseguire (mappa non valida, nodi fuori intervallo) producono -1 e
+   un messaggio su stderr. Restituisce il numero di tali richieste. */
+int jobs_run(Job* jobs, int njobs, int nthreads, FILE* out, FILE* info);
+
+/* Libera la memoria associata alle richieste */
+void jobs_free(Job* jobs, int njobs);
+
+#endif
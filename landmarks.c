@@ -0,0 +1,379 @@
+/****************************************************************************
+ *
+ * landmarks.c -- Ricerca A* con limiti inferiori calcolati da landmark (ALT)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+Se $L$ è un landmark e $d_L$ sono le distanze da $L$, la
+disuguaglianza triangolare garantisce che la distanza tra due nodi
+$v$ e $t$ è almeno $|d_L(v) - d_L(t)|$. Il massimo su tutti i landmark
+è un limite inferiore _consistente_ (cambia al più di 1 lungo ogni
+arco), che a differenza della distanza di Manhattan tiene conto dei
+muri: quando un muro separa $v$ da $t$, un landmark posto oltre
+l'estremità del muro "vede" il giro che il robot deve fare.
+
+I landmark vengono scelti con il criterio del punto più lontano: il
+primo è il nodo più lontano dal nodo 0, ogni successivo è il nodo la
+cui distanza minima dai landmark già scelti è massima (i nodi non
+raggiunti da nessun landmark, cioè in un'altra componente connessa,
+hanno la precedenza). Si ottengono così gli angoli e le estremità
+della mappa. Le distanze sono calcolate con una visita in ampiezza
+completa per landmark e memorizzate in 32 bit, interlacciate per nodo:
+il limite inferiore di un nodo legge al più 64 byte consecutivi. Le
+distanze non vengono mai troncate: con un valore troncato il limite
+potrebbe cambiare di più di 1 lungo un arco, e la coda a tre bucket
+descritta sotto perderebbe dei nodi. Poiché
+ogni componente connessa riceve un landmark prima che una stessa
+componente ne riceva due, quando un landmark raggiunge solo uno dei due
+nodi la destinazione non è raggiungibile: la risposta è immediata,
+invece di una visita dell'intera componente della sorgente.
+
+La ricerca è A* con priorità $f = g + h$. Con un limite consistente e
+archi di peso unitario le priorità in coda stanno tra quella minima e
+la minima più 2, quindi bastano tre bucket gestiti in modo circolare.
+Ogni bucket è una pila: a parità di $f$ viene espanso il nodo inserito
+per ultimo, cioè quello con $g$ maggiore e più vicino alla
+destinazione, e la ricerca non esplora per intero le zone in cui molti
+nodi hanno la stessa priorità.
+
+Il file dei landmark contiene l'hash della mappa, il numero di nodi,
+l'ordine di numerazione e i landmark, seguiti dalla tabella delle
+distanze; i valori sono scritti nella rappresentazione della macchina.
+Le distanze lette vengono confrontate lungo tutti gli archi del grafo,
+con una passata che costa meno di una visita per landmark: un file
+danneggiato viene scartato e le distanze ricalcolate.
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include "landmarks.h"
+#include "memstat.h"
+
+/* intestazione del file dei landmark */
+static const char LANDMARKS_MAGIC[8] = { 'R', 'O', 'B', 'O', 'A', 'L', 'T', '2' };
+
+/* visita in ampiezza completa da `s`: d[v] = -1 per i nodi non
+   raggiungibili. `queue` deve avere spazio per n nodi. */
+static void bfs_from(const Graph* g, int s, int* d, int* queue)
+{
+    const int n = graph_n_nodes(g);
+    int head = 0, tail = 0, i;
+
+    for (i = 0; i < n; i++)
+        d[i] = -1;
+    d[s] = 0;
+    queue[tail++] = s;
+    while (head < tail) {
+        const int u = queue[head++];
+        const Edge* edge;
+        for (edge = graph_adj(g, u); edge != NULL; edge = edge->next) {
+            const int v = edge->d;
+            if (d[v] < 0 && edge->weight > -1) {
+                d[v] = d[u] + 1;
+                queue[tail++] = v;
+            }
+        }
+    }
+}
+
+static Landmarks* landmarks_alloc(int n, int k)
+{
+    Landmarks* lm = (Landmarks*)mem_alloc(MEM_LANDMARKS, sizeof(*lm));
+
+    assert(lm != NULL);
+    assert((k >= 1) && (k <= LANDMARKS_MAX));
+
+    lm->n = n;
+    lm->k = k;
+    lm->dist = (uint32_t*)mem_alloc(MEM_LANDMARKS, (size_t)n * k * sizeof(*(lm->dist)));
+    assert(lm->dist != NULL);
+    return lm;
+}
+
+Landmarks* landmarks_create(const Graph* g, int k)
+{
+    const int n = graph_n_nodes(g);
+    Landmarks* lm;
+    int* d = (int*)mem_alloc(MEM_SEARCH, n * sizeof(*d));
+    int* queue = (int*)mem_alloc(MEM_QUEUE, n * sizeof(*queue));
+    int* mind = (int*)mem_alloc(MEM_SEARCH, n * sizeof(*mind));
+    int next = 0, nchosen = 0, i, j;
+
+    assert(d != NULL && queue != NULL && mind != NULL);
+    assert(n > 0);
+
+    if (k > n)
+        k = n;
+    lm = landmarks_alloc(n, k);
+
+    /* il primo landmark è il nodo più lontano dal nodo 0 */
+    bfs_from(g, 0, d, queue);
+    for (i = 0; i < n; i++) {
+        mind[i] = INT_MAX;
+        if (d[i] > d[next])
+            next = i;
+    }
+
+    for (j = 0; j < k; j++) {
+        lm->nodes[j] = next;
+        nchosen++;
+        bfs_from(g, next, d, queue);
+        for (i = 0; i < n; i++) {
+            if (d[i] < 0)
+                lm->dist[(size_t)i * k + j] = LANDMARK_UNREACHABLE;
+            else
+                lm->dist[(size_t)i * k + j] = (uint32_t)d[i];
+            if (d[i] >= 0 && d[i] < mind[i])
+                mind[i] = d[i];
+        }
+        /* il successivo è il nodo più lontano dai landmark scelti */
+        next = 0;
+        for (i = 1; i < n; i++) {
+            if (mind[i] > mind[next])
+                next = i;
+        }
+        if (mind[next] == 0)
+            break; /* tutti i nodi sono landmark */
+    }
+
+    /* se tutti i nodi sono già landmark, le colonne in più ripetono
+       il primo e non cambiano il limite inferiore */
+    for (j = nchosen; j < k; j++) {
+        lm->nodes[j] = lm->nodes[0];
+        for (i = 0; i < n; i++)
+            lm->dist[(size_t)i * k + j] = lm->dist[(size_t)i * k];
+    }
+
+    mem_free(MEM_SEARCH, d);
+    mem_free(MEM_QUEUE, queue);
+    mem_free(MEM_SEARCH, mind);
+    return lm;
+}
+
+void landmarks_destroy(Landmarks* lm)
+{
+    assert(lm != NULL);
+
+    mem_free(MEM_LANDMARKS, lm->dist);
+    mem_free(MEM_LANDMARKS, lm);
+}
+
+int landmarks_save(const Landmarks* lm, const Graph* g, const char* path, uint64_t mapHash)
+{
+    const int layout = (int)g->layout;
+    const size_t size = (size_t)lm->n * lm->k;
+    FILE* f = fopen(path, "wb");
+    int ok;
+
+    if (f == NULL)
+        return -1;
+    ok = (fwrite(LANDMARKS_MAGIC, sizeof(LANDMARKS_MAGIC), 1, f) == 1 &&
+          fwrite(&mapHash, sizeof(mapHash), 1, f) == 1 &&
+          fwrite(&lm->n, sizeof(lm->n), 1, f) == 1 &&
+          fwrite(&layout, sizeof(layout), 1, f) == 1 &&
+          fwrite(&lm->k, sizeof(lm->k), 1, f) == 1 &&
+          fwrite(lm->nodes, sizeof(lm->nodes[0]), lm->k, f) == (size_t)lm->k &&
+          fwrite(lm->dist, sizeof(lm->dist[0]), size, f) == size);
+    if (fclose(f) != 0 || !ok) {
+        remove(path);
+        return -1;
+    }
+    return 0;
+}
+
+/* controlla che le distanze lette da un file siano quelle di una
+   visita in ampiezza: ogni landmark ha distanza 0 da se stesso e lungo
+   ogni arco percorribile la distanza cambia al più di 1, oppure è
+   LANDMARK_UNREACHABLE ad entrambi gli estremi. Su queste proprietà
+   si basa la coda a tre bucket: con un file danneggiato la ricerca
+   perderebbe dei nodi invece di fallire. */
+static int landmarks_valid(const Landmarks* lm, const Graph* g)
+{
+    int u, j;
+
+    for (j = 0; j < lm->k; j++) {
+        if (lm->dist[(size_t)lm->nodes[j] * lm->k + j] != 0)
+            return 0;
+    }
+    for (u = 0; u < lm->n; u++) {
+        const uint32_t* du = lm->dist + (size_t)u * lm->k;
+        const Edge* edge;
+        for (edge = graph_adj(g, u); edge != NULL; edge = edge->next) {
+            const uint32_t* dv = lm->dist + (size_t)edge->d * lm->k;
+            if (edge->weight <= -1)
+                continue;
+            for (j = 0; j < lm->k; j++) {
+                if ((du[j] == LANDMARK_UNREACHABLE) != (dv[j] == LANDMARK_UNREACHABLE) ||
+                    (du[j] != LANDMARK_UNREACHABLE && (du[j] > dv[j] + 1 || dv[j] > du[j] + 1)))
+                    return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+Landmarks* landmarks_load(const Graph* g, const char* path, uint64_t mapHash, int k)
+{
+    char magic[sizeof(LANDMARKS_MAGIC)];
+    uint64_t hash;
+    int n, layout, fk, j;
+    Landmarks* lm;
+    size_t size;
+    FILE* f = fopen(path, "rb");
+
+    if (f == NULL)
+        return NULL;
+    if (fread(magic, sizeof(magic), 1, f) != 1 ||
+        memcmp(magic, LANDMARKS_MAGIC, sizeof(magic)) != 0 ||
+        fread(&hash, sizeof(hash), 1, f) != 1 || hash != mapHash ||
+        fread(&n, sizeof(n), 1, f) != 1 || n != graph_n_nodes(g) ||
+        fread(&layout, sizeof(layout), 1, f) != 1 || layout != (int)g->layout ||
+        fread(&fk, sizeof(fk), 1, f) != 1 || fk != (k < n ? k : n)) {
+        fclose(f);
+        return NULL;
+    }
+    lm = landmarks_alloc(n, fk);
+    size = (size_t)n * fk;
+    if (fread(lm->nodes, sizeof(lm->nodes[0]), fk, f) != (size_t)fk ||
+        fread(lm->dist, sizeof(lm->dist[0]), size, f) != size) {
+        fclose(f);
+        landmarks_destroy(lm);
+        return NULL;
+    }
+    fclose(f);
+    for (j = 0; j < fk; j++) {
+        if (lm->nodes[j] < 0 || lm->nodes[j] >= n) {
+            landmarks_destroy(lm);
+            return NULL;
+        }
+    }
+    if (!landmarks_valid(lm, g)) {
+        landmarks_destroy(lm);
+        return NULL;
+    }
+    return lm;
+}
+
+/* limite inferiore della distanza tra il nodo `v` e la destinazione,
+   le cui distanze dai landmark sono in `t` */
+static int lower_bound(const Landmarks* lm, const uint32_t* t, int v)
+{
+    const uint32_t* dv = lm->dist + (size_t)v * lm->k;
+    int h = 0, j;
+
+    for (j = 0; j < lm->k; j++) {
+        if (dv[j] != LANDMARK_UNREACHABLE && t[j] != LANDMARK_UNREACHABLE) {
+            const int x = abs((int)dv[j] - (int)t[j]);
+            if (x > h)
+                h = x;
+        }
+    }
+    return h;
+}
+
+/* pila di nodi con la stessa priorità */
+typedef struct {
+    int* data;
+    int size, capacity;
+} Bucket;
+
+static void bucket_push(Bucket* b, int v)
+{
+    if (b->size == b->capacity) {
+        b->capacity = (b->capacity == 0) ? 64 : 2 * b->capacity;
+        b->data = (int*)mem_realloc(MEM_QUEUE, b->data, b->capacity * sizeof(*(b->data)));
+        assert(b->data != NULL);
+    }
+    b->data[b->size++] = v;
+}
+
+int landmarks_search(const Landmarks* lm, Search* s, const Graph* g, int src, int dst, int* nexpanded)
+{
+    unsigned* const epoch = s->epoch;
+    int* const d = s->d;
+    int* const p = s->p;
+    uint32_t t[LANDMARKS_MAX];
+    Bucket open[3];
+    unsigned cur;
+    int fcur, nopen = 0, expanded = 0, i;
+
+    assert(lm != NULL);
+    assert(graph_n_nodes(g) == s->n && lm->n == s->n);
+    assert((src >= 0) && (src < s->n));
+    assert((dst >= 0) && (dst < s->n));
+
+    /* nuova epoca, come in `search_bfs_to()` */
+    if (++s->cur == 0) {
+        memset(epoch, 0, s->n * sizeof(*epoch));
+        s->cur = 1;
+    }
+    cur = s->cur;
+
+    memcpy(t, lm->dist + (size_t)dst * lm->k, lm->k * sizeof(*t));
+    memset(open, 0, sizeof(open));
+    epoch[src] = cur;
+    d[src] = 0;
+    p[src] = -1;
+    s->touched[0] = src;
+    s->ntouched = 1;
+    if (nexpanded != NULL)
+        *nexpanded = 0;
+    for (i = 0; i < lm->k; i++) {
+        const uint32_t ds = lm->dist[(size_t)src * lm->k + i];
+        if ((ds == LANDMARK_UNREACHABLE) != (t[i] == LANDMARK_UNREACHABLE))
+            return -1; /* componenti connesse diverse */
+    }
+    fcur = lower_bound(lm, t, src);
+    bucket_push(&open[fcur % 3], src);
+    nopen++;
+
+    while (nopen > 0) {
+        const Edge* edge;
+        int u;
+        while (open[fcur % 3].size == 0)
+            fcur++;
+        u = open[fcur % 3].data[--open[fcur % 3].size];
+        nopen--;
+        if (d[u] + lower_bound(lm, t, u) != fcur)
+            continue; /* inserito di nuovo con distanza minore */
+        if (u == dst)
+            break;
+        expanded++;
+        for (edge = graph_adj(g, u); edge != NULL; edge = edge->next) {
+            const int v = edge->d;
+            if (edge->weight > -1 && (epoch[v] != cur || d[u] + 1 < d[v])) {
+                if (epoch[v] != cur) {
+                    epoch[v] = cur;
+                    s->touched[s->ntouched++] = v;
+                }
+                d[v] = d[u] + 1;
+                p[v] = u;
+                bucket_push(&open[(d[v] + lower_bound(lm, t, v)) % 3], v);
+                nopen++;
+            }
+        }
+    }
+
+    for (i = 0; i < 3; i++)
+        mem_free(MEM_QUEUE, open[i].data);
+    if (nexpanded != NULL)
+        *nexpanded = expanded;
+    return search_dist(s, dst);
+}
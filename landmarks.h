@@ -0,0 +1,72 @@
+/****************************************************************************
+ *
+ * landmarks.h -- Ricerca A* con limiti inferiori calcolati da landmark (ALT)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <stdint.h>
+#include "graph.h"
+#include "search.h"
+
+/* numero massimo di landmark */
+#define LANDMARKS_MAX 16
+
+/* distanza memorizzata per i nodi non raggiungibili da un landmark */
+#define LANDMARK_UNREACHABLE 0xFFFFFFFFu
+
+/* landmark di un grafo, con le loro distanze da tutti i nodi */
+typedef struct {
+    int n;              /* numero di nodi del grafo                      */
+    int k;              /* numero di landmark                            */
+    int nodes[LANDMARKS_MAX]; /* nodi scelti come landmark               */
+    uint32_t* dist;     /* dist[v * k + j]: distanza tra il landmark j e
+                           il nodo v, oppure LANDMARK_UNREACHABLE        */
+} Landmarks;
+
+/* Sceglie (al più) `k` landmark tra i nodi di `g`, ognuno il più
+   lontano possibile da quelli già scelti, e calcola le loro distanze
+   da tutti i nodi con una visita in ampiezza per landmark. */
+Landmarks* landmarks_create(const Graph* g, int k);
+
+/* Libera la memoria associata ai landmark */
+void landmarks_destroy(Landmarks* lm);
+
+/* Salva i landmark nel file `path`, insieme all'hash `mapHash` del
+   contenuto della mappa da cui è stato costruito `g`. Restituisce 0
+   se il salvataggio è riuscito, -1 altrimenti. */
+int landmarks_save(const Landmarks* lm, const Graph* g, const char* path, uint64_t mapHash);
+
+/* Legge i landmark dal file `path`. Restituisce NULL se il file non
+   esiste oppure non corrisponde alla mappa con hash `mapHash`, al
+   grafo `g` (numero di nodi e ordine di numerazione) o al numero `k`
+   di landmark richiesto, oppure se le distanze non sono coerenti con
+   gli archi di `g`. */
+Landmarks* landmarks_load(const Graph* g, const char* path, uint64_t mapHash, int k);
+
+/* Ricerca A* da `src` a `dst` con il limite inferiore ottenuto dalla
+   disuguaglianza triangolare sui landmark. Usa gli array del contesto
+   `s` come `search_bfs_to()`, a cui è equivalente: restituisce la
+   distanza di `dst` (-1 se non è raggiungibile) e il cammino si
+   ricava con `search_get_path()`, anche se a parità di lunghezza può
+   essere diverso da quello della visita in ampiezza. In `nexpanded`
+   viene scritto il numero di nodi espansi: è zero, senza alcuna
+   ricerca, quando un landmark raggiunge solo uno dei due nodi. */
+int landmarks_search(const Landmarks* lm, Search* s, const Graph* g, int src, int dst, int* nexpanded);
+
+#endif
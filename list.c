@@ -146,6 +146,7 @@ Come sempre, è possibile realizzare ulteriori funzioni di supporto.
 #include <stdlib.h>
 #include <assert.h>
 #include "list.h"
+#include "memstat.h"
 
 /* Crea un nuovo nuovo oggetto nodo contenente valore v. I puntatori
    al nodo successivo e precedente puntano entrambi al nodo appena
@@ -155,7 +156,7 @@ Come sempre, è possibile realizzare ulteriori funzioni di supporto.
    sorgente. */
 static ListNode *list_new_node(int v)
 {
-    ListNode *r = (ListNode *)malloc(sizeof(ListNode));
+    ListNode *r = (ListNode *)mem_alloc(MEM_LIST, sizeof(ListNode));
     assert(r != NULL); /* evitiamo un warning con VS */
     r->val = v;
     r->succ = r->pred = r;
@@ -172,7 +173,7 @@ const ListNode *list_end(const List *L)
 
 List *list_create( void )
 {
-    List *L = (List*)malloc(sizeof(List));
+    List *L = (List*)mem_alloc(MEM_LIST, sizeof(List));
     assert(L != NULL);
 
     L->length = 0;
@@ -208,7 +209,7 @@ void list_clear(List *L)
     node = list_first(L);
     while (node != list_end(L)) {
         ListNode *succ = list_succ(node);
-        free(node);
+        mem_free(MEM_LIST, node);
         node = succ;
     }
     L->length = 0;
@@ -218,7 +219,7 @@ void list_clear(List *L)
 void list_destroy(List *L)
 {
     list_clear(L);
-    free(L);
+    mem_free(MEM_LIST, L);
 }
 
 /* Nota: questa funzione assume che ListInfo sia il tipo "int" */
@@ -304,7 +305,7 @@ void list_remove(List *L, ListNode *n)
     assert(n != NULL);
     assert(n != list_end(L));
     list_join(list_pred(n), list_succ(n));
-    free(n);
+    mem_free(MEM_LIST, n);
     L->length--;
 }
 
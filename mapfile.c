@@ -0,0 +1,584 @@
+/****************************************************************************
+ *
+ * mapfile.c -- Lettura della mappa da file di testo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+Il file viene portato in memoria per intero: con `mmap()` se è un file
+regolare, altrimenti (pipe, terminale) leggendolo a blocchi. Dopo
+l'intestazione, il testo viene diviso in tanti blocchi quanti sono i
+thread, spostando ogni confine subito dopo il ritorno a capo
+successivo, in modo che nessuna riga sia spezzata tra due blocchi.
+
+La decodifica avviene in due fasi parallele. Nella prima ogni thread
+conta le righe del proprio blocco; le somme prefisse dei conteggi
+danno la prima riga della mappa di ogni blocco. Nella seconda ogni
+thread controlla la larghezza delle proprie righe e le copia nella
+posizione finale della mappa. Ogni thread si ferma al primo errore del
+proprio blocco; viene segnalato quello del primo blocco che ne
+contiene uno, cioè il primo errore del file.
+
+In alternativa, `map_stream()` non porta in memoria l'intero file. Un
+thread di lettura lo legge a blocchi che terminano ad un ritorno a
+capo e li inserisce in un buffer circolare di STREAM_SLOTS blocchi,
+con un solo produttore ed un solo consumatore; quando il buffer è
+pieno la lettura si ferma finché il consumatore non libera un blocco.
+Il thread chiamante decodifica ogni blocco appena è disponibile, con
+le stesse funzioni usate da `map_parse()`, e comunica le righe
+complete ad una funzione indicata dal chiamante: l'elaborazione delle
+prime righe si sovrappone così alla lettura delle successive.
+***/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "mapfile.h"
+#include "memstat.h"
+
+/* dimensione minima di un blocco: file più piccoli vengono decodificati
+   da meno thread, perché la creazione di un thread costerebbe più della
+   decodifica */
+#define MIN_CHUNK (1 << 16)
+
+/* dimensione iniziale di un blocco di `map_stream()`, e numero di
+   blocchi del buffer circolare */
+#define STREAM_BLOCK (1 << 20)
+#define STREAM_SLOTS 8
+
+/* blocco del file assegnato ad un thread */
+typedef struct {
+    const char* begin;  /* primo carattere, all'inizio di una riga     */
+    const char* end;    /* carattere successivo all'ultimo             */
+    int last;           /* 1 se è l'ultimo blocco del file             */
+    long nlines;        /* numero di righe del blocco                  */
+    long firstRow;      /* indice nella mappa della prima riga         */
+    char** matrix;
+    int n, m;
+    long errLine;       /* riga del primo errore (0 = nessun errore),
+                           contata dalla prima riga della mappa        */
+    int errCol;         /* colonna del primo errore (da 1)             */
+    const char* errMsg;
+    int errLen;         /* lunghezza della riga, se l'errore riguarda
+                           la larghezza; -1 altrimenti                 */
+} Chunk;
+
+static int is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* fase 1: conta le righe del blocco. Solo l'ultimo blocco può terminare
+   con una riga senza ritorno a capo. */
+static void* chunk_count(void* arg)
+{
+    Chunk* ch = (Chunk*)arg;
+    const char* s = ch->begin;
+    long nl = 0;
+
+    while (s < ch->end) {
+        s = (const char*)memchr(s, '\n', ch->end - s);
+        if (s == NULL)
+            break;
+        nl++;
+        s++;
+    }
+    if (ch->last && ch->end > ch->begin && ch->end[-1] != '\n')
+        nl++;
+    ch->nlines = nl;
+    return NULL;
+}
+
+static void chunk_error(Chunk* ch, long row, int col, const char* msg, int len)
+{
+    ch->errLine = row + 1;
+    ch->errCol = col;
+    ch->errMsg = msg;
+    ch->errLen = len;
+}
+
+/* fase 2: controlla e copia nella mappa le righe del blocco */
+static void* chunk_decode(void* arg)
+{
+    Chunk* ch = (Chunk*)arg;
+    const int m = ch->m;
+    const char* s = ch->begin;
+    long r = ch->firstRow;
+
+    while (s < ch->end) {
+        const char* eol = (const char*)memchr(s, '\n', ch->end - s);
+        const char* e;
+        int j, len;
+
+        if (eol == NULL)
+            eol = ch->end;
+        /* gli spazi in fondo alla riga (ed un eventuale '\r') non fanno
+           parte della mappa */
+        for (e = eol; e > s && is_blank(e[-1]); e--)
+            ;
+        len = (int)(e - s < INT_MAX ? e - s : INT_MAX);
+        if (r >= ch->n) {
+            if (len > 0) {
+                chunk_error(ch, r, 1, "righe in eccesso rispetto all'intestazione", -1);
+                return NULL;
+            }
+        }
+        else {
+            for (j = 0; j < len && j < m; j++) {
+                const unsigned char c = (unsigned char)s[j];
+                if (c <= ' ' || c == 127) {
+                    chunk_error(ch, r, j + 1, "carattere non valido", -1);
+                    return NULL;
+                }
+            }
+            if (len != m) {
+                chunk_error(ch, r, len < m ? len + 1 : m + 1,
+                            len < m ? "riga troppo corta" : "riga troppo lunga", len);
+                return NULL;
+            }
+            memcpy(ch->matrix[r], s, m);
+        }
+        r++;
+        s = eol + 1;
+    }
+    return NULL;
+}
+
+static void run_chunks(Chunk* chunks, int k, void* (*phase)(void*))
+{
+    pthread_t* tid;
+    int t;
+
+    if (k == 1) {
+        phase(&chunks[0]);
+        return;
+    }
+    tid = (pthread_t*)mem_alloc(MEM_MAP, k * sizeof(*tid));
+    assert(tid != NULL);
+    for (t = 1; t < k; t++) {
+        const int err = pthread_create(&tid[t], NULL, phase, &chunks[t]);
+        assert(err == 0);
+        (void)err;
+    }
+    phase(&chunks[0]);
+    for (t = 1; t < k; t++)
+        pthread_join(tid[t], NULL);
+    mem_free(MEM_MAP, tid);
+}
+
+/* legge per intero un file che non può essere mappato in memoria */
+static char* read_all(FILE* f, size_t* size)
+{
+    size_t cap = 1 << 16, len = 0, got;
+    char* buf = (char*)mem_alloc(MEM_MAP, cap);
+
+    assert(buf != NULL);
+    while ((got = fread(buf + len, 1, cap - len, f)) > 0) {
+        len += got;
+        if (len == cap) {
+            cap *= 2;
+            buf = (char*)mem_realloc(MEM_MAP, buf, cap);
+            assert(buf != NULL);
+        }
+    }
+    *size = len;
+    return buf;
+}
+
+/* legge un intero non negativo a partire da `*s`, saltando gli spazi
+   che lo precedono; restituisce -1 se non c'è un intero valido */
+static long parse_dim(const char** s, const char* end)
+{
+    const char* p = *s;
+    long v = 0;
+
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    if (p == end || *p < '0' || *p > '9')
+        return -1;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p - '0');
+        if (v > INT_MAX)
+            return -1;
+        p++;
+    }
+    *s = p;
+    return v;
+}
+
+void map_text_load(FILE* f, MapText* text)
+{
+    struct stat st;
+
+    assert(f != NULL);
+    assert(text != NULL);
+
+    text->mapped = 0;
+    if (fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        text->size = (size_t)st.st_size;
+        text->data = (char*)mmap(NULL, text->size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+        text->mapped = (text->data != MAP_FAILED);
+    }
+    if (!text->mapped)
+        text->data = read_all(f, &text->size);
+}
+
+void map_text_free(MapText* text)
+{
+    assert(text != NULL);
+
+    if (text->mapped)
+        munmap(text->data, text->size);
+    else
+        mem_free(MEM_MAP, text->data);
+    text->data = NULL;
+    text->size = 0;
+}
+
+char** map_from_file(FILE* f, const char* name, int* rows, int* cols, int nthreads)
+{
+    MapText text;
+    char** matrix;
+
+    map_text_load(f, &text);
+    matrix = map_parse(&text, name, rows, cols, nthreads);
+    map_text_free(&text);
+    return matrix;
+}
+
+/* legge l'intestazione (numero di righe e di colonne) all'inizio di
+   `data` e restituisce il primo carattere della mappa, oppure NULL se
+   l'intestazione non è valida */
+static const char* parse_header(const char* data, const char* end, const char* name, long* n, long* m)
+{
+    const char* s = data;
+
+    *n = parse_dim(&s, end);
+    *m = (*n < 0 ? -1 : parse_dim(&s, end));
+    while (s < end && is_blank(*s))
+        s++;
+    if (*n <= 0 || *m <= 0 || (s < end && *s != '\n')) {
+        fprintf(stderr, "%s:1:%d: intestazione non valida: attesi numero di righe e di colonne\n",
+                name, (int)(s - data) + 1);
+        return NULL;
+    }
+    if (*n > INT_MAX / *m) {
+        fprintf(stderr, "%s:1:1: mappa troppo grande (%ld x %ld)\n", name, *n, *m);
+        return NULL;
+    }
+    return (s < end ? s + 1 : end);
+}
+
+/* matrice di n righe che puntano ad un unico blocco di n * m celle */
+static char** alloc_matrix(long n, long m)
+{
+    char** matrix = (char**)mem_alloc(MEM_MAP, n * sizeof(*matrix));
+    char* cells = (char*)mem_alloc(MEM_MAP, n * m);
+    long i;
+
+    assert(matrix != NULL);
+    assert(cells != NULL);
+    for (i = 0; i < n; i++)
+        matrix[i] = cells + (size_t)i * m;
+    return matrix;
+}
+
+/* segnala l'errore trovato nel blocco `ch` */
+static void report_error(const char* name, const Chunk* ch, long m)
+{
+    /* le righe del file sono numerate da 1, e la prima è l'intestazione */
+    fprintf(stderr, "%s:%ld:%d: %s", name, ch->errLine + 1, ch->errCol, ch->errMsg);
+    if (ch->errLen >= 0)
+        fprintf(stderr, " (%d caratteri, attesi %ld)", ch->errLen, m);
+    fprintf(stderr, "\n");
+}
+
+/* segnala un file con meno righe di quelle indicate nell'intestazione */
+static void report_short(const char* name, long total, long n)
+{
+    fprintf(stderr, "%s:%ld:1: file terminato dopo %ld righe della mappa, attese %ld\n",
+            name, total + 2, total, n);
+}
+
+char** map_parse(const MapText* text, const char* name, int* rows, int* cols, int nthreads)
+{
+    const char* const data = text->data;
+    const char *s, *body, *end;
+    char** matrix = NULL;
+    Chunk* chunks;
+    long n, m, total;
+    int k, t;
+
+    assert(text != NULL);
+    assert(nthreads > 0);
+
+    end = data + text->size;
+    body = parse_header(data, end, name, &n, &m);
+    if (body == NULL)
+        return NULL;
+    matrix = alloc_matrix(n, m);
+
+    /* divisione in blocchi che terminano ad un ritorno a capo */
+    k = nthreads;
+    if ((size_t)(end - body) / MIN_CHUNK + 1 < (size_t)k)
+        k = (int)((end - body) / MIN_CHUNK) + 1;
+    chunks = (Chunk*)mem_alloc(MEM_MAP, k * sizeof(*chunks));
+    assert(chunks != NULL);
+    s = body;
+    for (t = 0; t < k; t++) {
+        const char* e = (t == k - 1 ? end : body + (end - body) / k * (t + 1));
+        if (e < s)
+            e = s;
+        if (e < end) {
+            e = (const char*)memchr(e, '\n', end - e);
+            e = (e == NULL ? end : e + 1);
+        }
+        chunks[t].begin = s;
+        chunks[t].end = e;
+        chunks[t].last = (e == end);
+        chunks[t].matrix = matrix;
+        chunks[t].n = (int)n;
+        chunks[t].m = (int)m;
+        chunks[t].errLine = 0;
+        s = e;
+    }
+
+    run_chunks(chunks, k, chunk_count);
+    total = 0;
+    for (t = 0; t < k; t++) {
+        chunks[t].firstRow = total;
+        total += chunks[t].nlines;
+    }
+    run_chunks(chunks, k, chunk_decode);
+
+    for (t = 0; t < k && chunks[t].errLine == 0; t++)
+        ;
+    if (t < k) {
+        report_error(name, &chunks[t], m);
+        map_free(matrix);
+        matrix = NULL;
+    }
+    else if (total < n) {
+        report_short(name, total, n);
+        map_free(matrix);
+        matrix = NULL;
+    }
+    else {
+        *rows = (int)n;
+        *cols = (int)m;
+    }
+    mem_free(MEM_MAP, chunks);
+    return matrix;
+}
+
+/* blocco del buffer circolare di `map_stream()` */
+typedef struct {
+    char* data;
+    size_t len;         /* byte validi, fino ad un ritorno a capo       */
+    size_t cap;         /* byte allocati                               */
+    int last;           /* 1 se è l'ultimo blocco del file             */
+} Slot;
+
+/* buffer circolare tra il thread di lettura ed il thread chiamante:
+   i blocchi da head (incluso) a head + count (escluso), modulo
+   STREAM_SLOTS, sono pieni e vengono letti solo dal consumatore; gli
+   altri vengono scritti solo dal produttore */
+typedef struct {
+    FILE* f;
+    Slot slots[STREAM_SLOTS];
+    int head, count;
+    int stop;           /* 1 se il consumatore non vuole altri blocchi */
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty, notFull;
+} Stream;
+
+/* thread di lettura: riempie i blocchi liberi del buffer. Ogni blocco
+   termina con l'ultimo ritorno a capo letto; i caratteri successivi
+   vengono copiati all'inizio del blocco seguente. */
+static void* stream_reader(void* arg)
+{
+    Stream* st = (Stream*)arg;
+    char* carry = NULL;
+    size_t carryLen = 0, carryCap = 0;
+    int eof = 0, tail;
+
+    while (!eof) {
+        Slot* sl;
+        size_t e;
+
+        pthread_mutex_lock(&st->lock);
+        while (st->count == STREAM_SLOTS && !st->stop)
+            pthread_cond_wait(&st->notFull, &st->lock);
+        if (st->stop) {
+            pthread_mutex_unlock(&st->lock);
+            break;
+        }
+        tail = (st->head + st->count) % STREAM_SLOTS;
+        pthread_mutex_unlock(&st->lock);
+
+        sl = &st->slots[tail];
+        if (sl->cap < carryLen + STREAM_BLOCK) {
+            sl->cap = carryLen + STREAM_BLOCK;
+            sl->data = (char*)mem_realloc(MEM_MAP, sl->data, sl->cap);
+            assert(sl->data != NULL);
+        }
+        if (carryLen > 0)
+            memcpy(sl->data, carry, carryLen);
+        sl->len = carryLen;
+        for (;;) {
+            sl->len += fread(sl->data + sl->len, 1, sl->cap - sl->len, st->f);
+            if (sl->len < sl->cap) {
+                eof = 1; /* fine del file, o errore di lettura */
+                break;
+            }
+            for (e = sl->len; e > carryLen && sl->data[e - 1] != '\n'; e--)
+                ;
+            if (e > carryLen)
+                break;
+            /* nessun ritorno a capo: la riga non sta nel blocco */
+            sl->cap *= 2;
+            sl->data = (char*)mem_realloc(MEM_MAP, sl->data, sl->cap);
+            assert(sl->data != NULL);
+        }
+        if (eof)
+            carryLen = 0;
+        else {
+            carryLen = sl->len - e;
+            if (carryCap < carryLen) {
+                carryCap = carryLen;
+                carry = (char*)mem_realloc(MEM_MAP, carry, carryCap);
+                assert(carry != NULL);
+            }
+            memcpy(carry, sl->data + e, carryLen);
+            sl->len = e;
+        }
+        sl->last = eof;
+
+        pthread_mutex_lock(&st->lock);
+        st->count++;
+        pthread_cond_signal(&st->notEmpty);
+        pthread_mutex_unlock(&st->lock);
+    }
+    mem_free(MEM_MAP, carry);
+    return NULL;
+}
+
+char** map_stream(FILE* f, const char* name, int* rows, int* cols, MapRowsReady ready, void* arg)
+{
+    Stream st;
+    pthread_t reader;
+    char** matrix = NULL;
+    long n = 0, m = 0, total = 0;
+    int failed = 0, done = 0, t, err;
+
+    assert(f != NULL);
+
+    st.f = f;
+    memset(st.slots, 0, sizeof(st.slots));
+    st.head = st.count = st.stop = 0;
+    pthread_mutex_init(&st.lock, NULL);
+    pthread_cond_init(&st.notEmpty, NULL);
+    pthread_cond_init(&st.notFull, NULL);
+    err = pthread_create(&reader, NULL, stream_reader, &st);
+    assert(err == 0);
+    (void)err;
+
+    while (!done) {
+        const Slot* sl;
+        const char* begin;
+
+        pthread_mutex_lock(&st.lock);
+        while (st.count == 0)
+            pthread_cond_wait(&st.notEmpty, &st.lock);
+        sl = &st.slots[st.head];
+        pthread_mutex_unlock(&st.lock);
+
+        begin = sl->data;
+        if (matrix == NULL) {
+            begin = parse_header(sl->data, sl->data + sl->len, name, &n, &m);
+            if (begin == NULL)
+                failed = 1;
+            else
+                matrix = alloc_matrix(n, m);
+        }
+        if (!failed) {
+            Chunk ch;
+            ch.begin = begin;
+            ch.end = sl->data + sl->len;
+            ch.last = sl->last;
+            ch.matrix = matrix;
+            ch.n = (int)n;
+            ch.m = (int)m;
+            ch.firstRow = total;
+            ch.errLine = 0;
+            chunk_count(&ch);
+            chunk_decode(&ch);
+            if (ch.errLine != 0) {
+                report_error(name, &ch, m);
+                failed = 1;
+            }
+            else {
+                total += ch.nlines;
+                if (ready != NULL)
+                    ready(matrix, (int)n, (int)m, (int)(total < n ? total : n), arg);
+            }
+        }
+        done = failed || sl->last;
+
+        /* il blocco torna al thread di lettura */
+        pthread_mutex_lock(&st.lock);
+        st.head = (st.head + 1) % STREAM_SLOTS;
+        st.count--;
+        st.stop = failed;
+        pthread_cond_signal(&st.notFull);
+        pthread_mutex_unlock(&st.lock);
+    }
+
+    pthread_join(reader, NULL);
+    for (t = 0; t < STREAM_SLOTS; t++)
+        mem_free(MEM_MAP, st.slots[t].data);
+    pthread_mutex_destroy(&st.lock);
+    pthread_cond_destroy(&st.notEmpty);
+    pthread_cond_destroy(&st.notFull);
+
+    if (!failed && total < n) {
+        report_short(name, total, n);
+        failed = 1;
+    }
+    if (failed) {
+        map_free(matrix);
+        return NULL;
+    }
+    *rows = (int)n;
+    *cols = (int)m;
+    return matrix;
+}
+
+void map_free(char** matrix)
+{
+    if (matrix != NULL) {
+        mem_free(MEM_MAP, matrix[0]);
+        mem_free(MEM_MAP, matrix);
+    }
+}
@@ -0,0 +1,74 @@
+/****************************************************************************
+ *
+ * mapfile.h -- Lettura della mappa da file di testo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* testo di un file di mappa, interamente in memoria */
+typedef struct {
+    char* data;     /* contenuto del file (non terminato da '\0')    */
+    size_t size;    /* numero di byte                                */
+    int mapped;     /* 1 se `data` e' mappato con mmap()             */
+} MapText;
+
+/* Porta in memoria l'intero contenuto del file `f`: con `mmap()` se
+   si tratta di un file regolare, altrimenti (pipe, terminale)
+   leggendolo fino alla fine. */
+void map_text_load(FILE* f, MapText* text);
+
+/* Libera la memoria associata al testo */
+void map_text_free(MapText* text);
+
+/* Decodifica il testo di una mappa; vedi `map_from_file()` */
+char** map_parse(const MapText* text, const char* name, int* rows, int* cols, int nthreads);
+
+/* Legge una mappa dal file `f` (di nome `name`, usato solo nei
+   messaggi di errore). Il file inizia con una riga contenente il
+   numero di righe n e di colonne m, seguita da n righe di esattamente
+   m caratteri ciascuna. Le righe vengono decodificate da `nthreads`
+   thread, ognuno su un blocco del file che inizia e termina ad un
+   ritorno a capo.
+
+   Restituisce un array di n puntatori alle righe, che puntano ad un
+   unico blocco contiguo di n * m caratteri, e scrive le dimensioni in
+   `rows` e `cols`. Se il contenuto del file non è valido stampa su
+   stderr un messaggio con la riga e la colonna dell'errore e
+   restituisce NULL. */
+char** map_from_file(FILE* f, const char* name, int* rows, int* cols, int nthreads);
+
+/* funzione chiamata da `map_stream()` ogni volta che vengono
+   decodificate nuove righe: le righe da 0 a `nready` - 1 della mappa
+   `matrix` di `n` righe ed `m` colonne sono complete */
+typedef void (*MapRowsReady)(char** matrix, int n, int m, int nready, void* arg);
+
+/* Come `map_from_file()`, ma il file viene letto a blocchi da un
+   thread separato, e solo una parte limitata del testo è in memoria
+   in ogni istante. Il thread chiamante decodifica ogni blocco appena
+   letto e chiama `ready` (se non è NULL) con l'argomento `arg`,
+   mentre la lettura prosegue. */
+char** map_stream(FILE* f, const char* name, int* rows, int* cols, MapRowsReady ready, void* arg);
+
+/* Libera la memoria associata ad una mappa restituita da
+   `map_from_file()`, `map_parse()` o `map_stream()` */
+void map_free(char** matrix);
+
+#endif
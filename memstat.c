@@ -0,0 +1,185 @@
+/****************************************************************************
+ *
+ * memstat.c -- Conteggio della memoria allocata da ciascun sottosistema
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+Ogni blocco è preceduto da un'intestazione con la sua dimensione e il
+sottosistema a cui appartiene, così `mem_free()` e `mem_realloc()`
+sanno quanti byte togliere dal conteggio senza che il chiamante debba
+ricordarlo, e un blocco liberato come appartenente ad un sottosistema
+diverso viene segnalato da un'asserzione. L'intestazione è un'unione
+con i tipi che hanno l'allineamento più restrittivo, quindi anche il
+blocco restituito è allineato come quelli di malloc().
+
+I blocchi vengono allocati anche dai thread di `-j` e dal pool di
+`-m`, quindi i contatori vengono aggiornati con le operazioni atomiche
+di GCC; il massimo viene aggiornato con un confronto e scambio, e solo
+quando il valore attuale lo supera. Le operazioni atomiche costano
+più di quanto sembri quando si allocano molti oggetti piccoli (un
+nodo di lista per ogni passo dei percorsi di `-q`: il 9% del tempo
+su 100 000 richieste brevi), quindi i contatori vengono aggiornati
+solo dopo `mem_enable()`; l'intestazione c'è comunque, perché
+`mem_free()` deve funzionare anche sui blocchi allocati prima.
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "memstat.h"
+
+/* intestazione di ogni blocco */
+typedef union {
+    struct {
+        size_t size;    /* byte richiesti dal chiamante                 */
+        int sub;        /* sottosistema                                 */
+    } h;
+    long double alignLd;
+    long long alignLl;
+    void* alignP;
+} Header;
+
+static size_t current[MEM_NSUBSYSTEMS + 1]; /* l'ultimo e' il totale */
+static size_t peak[MEM_NSUBSYSTEMS + 1];
+
+static int enabled = 0;
+
+static const char* const names[MEM_NSUBSYSTEMS] = {
+    "mappa", "grafo", "ricerca", "liste", "code", "cache", "landmark",
+    "risultati"
+};
+
+/* aggiorna il massimo `*max` se `v` lo supera */
+static void update_peak(size_t* max, size_t v)
+{
+    size_t old = __atomic_load_n(max, __ATOMIC_RELAXED);
+
+    while (v > old && !__atomic_compare_exchange_n(max, &old, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static void account_add(int s, size_t size)
+{
+    if (!enabled)
+        return;
+    update_peak(&peak[s], __atomic_add_fetch(&current[s], size, __ATOMIC_RELAXED));
+    update_peak(&peak[MEM_NSUBSYSTEMS], __atomic_add_fetch(&current[MEM_NSUBSYSTEMS], size, __ATOMIC_RELAXED));
+}
+
+static void account_sub(int s, size_t size)
+{
+    if (!enabled)
+        return;
+    __atomic_sub_fetch(&current[s], size, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&current[MEM_NSUBSYSTEMS], size, __ATOMIC_RELAXED);
+}
+
+void mem_enable(void)
+{
+    enabled = 1;
+}
+
+void* mem_alloc(Mem_subsystem s, size_t size)
+{
+    Header* h = (Header*)malloc(sizeof(Header) + size);
+
+    assert(h != NULL);
+    assert(s >= 0 && s < MEM_NSUBSYSTEMS);
+    h->h.size = size;
+    h->h.sub = s;
+    account_add(s, size);
+    return h + 1;
+}
+
+void* mem_calloc(Mem_subsystem s, size_t n, size_t size)
+{
+    Header* h;
+
+    assert(size == 0 || n <= ((size_t)-1 - sizeof(Header)) / size);
+    h = (Header*)calloc(1, sizeof(Header) + n * size);
+    assert(h != NULL);
+    assert(s >= 0 && s < MEM_NSUBSYSTEMS);
+    h->h.size = n * size;
+    h->h.sub = s;
+    account_add(s, n * size);
+    return h + 1;
+}
+
+void* mem_realloc(Mem_subsystem s, void* p, size_t size)
+{
+    Header* h;
+    size_t old;
+
+    if (p == NULL)
+        return mem_alloc(s, size);
+    h = (Header*)p - 1;
+    assert(h->h.sub == (int)s);
+    old = h->h.size;
+    h = (Header*)realloc(h, sizeof(Header) + size);
+    assert(h != NULL);
+    h->h.size = size;
+    account_sub(s, old);
+    account_add(s, size);
+    return h + 1;
+}
+
+void mem_free(Mem_subsystem s, void* p)
+{
+    Header* h;
+
+    if (p == NULL)
+        return;
+    h = (Header*)p - 1;
+    assert(h->h.sub == (int)s);
+    account_sub(s, h->h.size);
+    free(h);
+}
+
+size_t mem_current(Mem_subsystem s)
+{
+    assert(s >= 0 && s <= MEM_NSUBSYSTEMS);
+    return __atomic_load_n(&current[s], __ATOMIC_RELAXED);
+}
+
+size_t mem_peak(Mem_subsystem s)
+{
+    assert(s >= 0 && s <= MEM_NSUBSYSTEMS);
+    return __atomic_load_n(&peak[s], __ATOMIC_RELAXED);
+}
+
+void mem_report(FILE* f)
+{
+    int s;
+
+    fprintf(f, "# memoria (byte, attuale/massima):");
+    for (s = 0; s < MEM_NSUBSYSTEMS; s++)
+        fprintf(f, " %s %lu/%lu,", names[s], (unsigned long)mem_current(s), (unsigned long)mem_peak(s));
+    fprintf(f, " totale %lu/%lu\n", (unsigned long)mem_current(MEM_NSUBSYSTEMS), (unsigned long)mem_peak(MEM_NSUBSYSTEMS));
+}
+
+int mem_check_released(FILE* f)
+{
+    int s, k = 0;
+
+    for (s = 0; s < MEM_NSUBSYSTEMS; s++) {
+        if (mem_current(s) > 0) {
+            fprintf(f, "# memoria non liberata: %s, %lu byte\n", names[s], (unsigned long)mem_current(s));
+            k++;
+        }
+    }
+    return k;
+}
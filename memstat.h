@@ -0,0 +1,68 @@
+/****************************************************************************
+ *
+ * memstat.h -- Conteggio della memoria allocata da ciascun sottosistema
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef MEMSTAT_H
+#define MEMSTAT_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* sottosistemi di cui viene contata la memoria */
+typedef enum {
+    MEM_MAP,        /* lettura della mappa: testo e matrice             */
+    MEM_GRAPH,      /* grafo: archi, gradi, numerazione dei nodi        */
+    MEM_SEARCH,     /* contesti di ricerca                              */
+    MEM_LIST,       /* liste (percorsi)                                 */
+    MEM_QUEUE,      /* code                                             */
+    MEM_CACHE,      /* elementi della cache dei risultati (-k)          */
+    MEM_LANDMARKS,  /* distanze dai landmark (-a)                       */
+    MEM_RESULTS,    /* richieste e risultati di -m, risultati di -b, -z */
+    MEM_NSUBSYSTEMS
+} Mem_subsystem;
+
+/* Attiva il conteggio, da chiamare prima di qualunque allocazione:
+   finché non viene attivato i contatori restano a zero, e ogni
+   allocazione costa quanto malloc() più l'intestazione del blocco */
+void mem_enable(void);
+
+/* Come malloc(), calloc() e realloc(), ma la memoria viene attribuita
+   al sottosistema `s`. Terminano il programma (con assert) se la
+   memoria non è sufficiente, quindi non restituiscono mai NULL. */
+void* mem_alloc(Mem_subsystem s, size_t size);
+void* mem_calloc(Mem_subsystem s, size_t n, size_t size);
+void* mem_realloc(Mem_subsystem s, void* p, size_t size);
+
+/* Libera un blocco allocato per il sottosistema `s` con una delle
+   funzioni precedenti; `p` può essere NULL */
+void mem_free(Mem_subsystem s, void* p);
+
+/* Byte allocati in questo momento e massimo raggiunto dal sottosistema
+   `s`; con `s` = MEM_NSUBSYSTEMS si ottiene il totale */
+size_t mem_current(Mem_subsystem s);
+size_t mem_peak(Mem_subsystem s);
+
+/* Scrive su `f` una riga con la memoria attuale e massima di ogni
+   sottosistema */
+void mem_report(FILE* f);
+
+/* Scrive su `f` i sottosistemi che hanno ancora memoria allocata, e
+   ne restituisce il numero */
+int mem_check_released(FILE* f);
+
+#endif
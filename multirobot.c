@@ -0,0 +1,134 @@
+/****************************************************************************
+ *
+ * multirobot.c -- Cammini minimi di più robot verso la stessa stazione
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+Quando più robot devono raggiungere la stessa stazione di ricarica,
+eseguire `search_bfs_to()` una volta per robot ripete $K$ volte lo stesso
+lavoro. Dato che il grafo è simmetrico, basta una sola visita in
+ampiezza a partire dalla stazione: l'albero BFS risultante, percorso
+"al contrario", fornisce un cammino minimo verso la stazione da
+qualunque nodo, e quindi da ciascun robot.
+
+La visita procede per livelli: la frontiera corrente è memorizzata in
+un array e viene espansa in blocco producendo la frontiera
+successiva. Ad ogni nodo è associata una parola a 64 bit in cui il bit
+$i$ vale 1 se il robot $i$ parte da quel nodo; una seconda parola
+tiene traccia dei robot non ancora raggiunti, e la visita termina non
+appena questa si azzera. Il costo è quindi quello di una singola BFS
+(spesso meno, grazie alla terminazione anticipata), indipendentemente
+dal numero di robot.
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include "graph.h"
+#include "list.h"
+#include "multirobot.h"
+#include "memstat.h"
+
+int multi_bfs(const Graph* g, int dst, const int* starts, int k, int* d, int* next)
+{
+    const int n = graph_n_nodes(g);
+    uint64_t* robots; /* robots[v]: insieme dei robot che partono da v */
+    uint64_t remaining = 0; /* robot non ancora raggiunti */
+    int* frontier, * nextFrontier;
+    int nfrontier, nnext;
+    int i, nreached;
+
+    assert((dst >= 0) && (dst < n));
+    assert((k > 0) && (k <= MAX_ROBOTS));
+    assert(starts != NULL);
+    assert(d != NULL);
+    assert(next != NULL);
+
+    robots = (uint64_t*)mem_calloc(MEM_SEARCH, n, sizeof(*robots));
+    assert(robots != NULL);
+    frontier = (int*)mem_alloc(MEM_QUEUE, n * sizeof(*frontier));
+    assert(frontier != NULL);
+    nextFrontier = (int*)mem_alloc(MEM_QUEUE, n * sizeof(*nextFrontier));
+    assert(nextFrontier != NULL);
+
+    for (i = 0; i < n; i++) {
+        d[i] = -1;
+        next[i] = -1;
+    }
+    for (i = 0; i < k; i++) {
+        assert((starts[i] >= 0) && (starts[i] < n));
+        robots[starts[i]] |= (uint64_t)1 << i;
+        remaining |= (uint64_t)1 << i;
+    }
+
+    d[dst] = 0;
+    remaining &= ~robots[dst];
+    frontier[0] = dst;
+    nfrontier = 1;
+
+    while (nfrontier > 0 && remaining != 0) {
+        nnext = 0;
+        for (i = 0; i < nfrontier; i++) {
+            const int u = frontier[i];
+            const Edge* edge;
+            for (edge = graph_adj(g, u); edge != NULL; edge = edge->next) {
+                const int v = edge->d;
+                /* grazie alla simmetria, (u, v) in G implica (v, u) in
+                   G: u e' il successore di v verso la stazione */
+                if (d[v] < 0 && edge->weight > -1) {
+                    d[v] = d[u] + 1;
+                    next[v] = u;
+                    remaining &= ~robots[v];
+                    nextFrontier[nnext++] = v;
+                }
+            }
+        }
+        /* scambiamo le frontiere */
+        {
+            int* tmp = frontier;
+            frontier = nextFrontier;
+            nextFrontier = tmp;
+            nfrontier = nnext;
+        }
+    }
+
+    nreached = 0;
+    for (i = 0; i < k; i++) {
+        if (d[starts[i]] >= 0)
+            nreached++;
+    }
+
+    mem_free(MEM_SEARCH, robots);
+    mem_free(MEM_QUEUE, frontier);
+    mem_free(MEM_QUEUE, nextFrontier);
+    return nreached;
+}
+
+void multi_get_path(int s, const int* d, const int* next, List* path)
+{
+    assert(d != NULL);
+    assert(next != NULL);
+    assert(path != NULL);
+
+    if (d[s] < 0)
+        return;
+    while (s >= 0) {
+        list_add_last(path, s);
+        s = next[s];
+    }
+}
@@ -0,0 +1,49 @@
+/****************************************************************************
+ *
+ * multirobot.h -- Cammini minimi di più robot verso la stessa stazione
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef MULTIROBOT_H
+#define MULTIROBOT_H
+
+#include "graph.h"
+#include "list.h"
+
+/* numero massimo di robot gestiti con una sola visita (uno per bit
+   di una parola a 64 bit) */
+#define MAX_ROBOTS 64
+
+/* Visita in ampiezza "a ritroso" a partire dalla stazione di ricarica
+   `dst`, che si interrompe non appena tutti i `k` nodi di partenza in
+   `starts[]` sono stati raggiunti. Il grafo deve essere simmetrico
+   (per ogni arco (u, v) deve esistere l'arco (v, u)), come quello
+   prodotto da `graph_create_from_matrix()`.
+
+   Al termine `d[v]` contiene il numero minimo di mosse per andare da
+   `v` a `dst` (-1 se `v` non è stato raggiunto) e `next[v]` il nodo
+   successivo a `v` lungo un cammino minimo verso `dst` (-1 per `dst`
+   e per i nodi non raggiunti). Gli array devono avere `n` elementi.
+   Restituisce il numero di robot che possono raggiungere la
+   stazione. */
+int multi_bfs(const Graph* g, int dst, const int* starts, int k, int* d, int* next);
+
+/* Inserisce in `path` i nodi del cammino da `s` fino alla stazione,
+   seguendo l'array `next` prodotto da `multi_bfs()`; se la stazione
+   non è raggiungibile da `s` la lista resta vuota. */
+void multi_get_path(int s, const int* d, const int* next, List* path);
+
+#endif
@@ -0,0 +1,197 @@
+/****************************************************************************
+ *
+ * perfcount.c -- Contatori hardware delle prestazioni
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+I contatori vengono aperti con `perf_event_open()`, uno per evento e
+non in gruppo: se il processore non fornisce un evento (per esempio
+i miss del TLB in molte macchine virtuali) gli altri restano
+utilizzabili. Ogni contatore conta il processo chiamante e, con
+`inherit`, i thread che crea in seguito, come quelli di `-j`; conta
+solo il codice utente, così basta `perf_event_paranoid` <= 2, il
+valore predefinito.
+
+I contatori non vengono mai fermati: le fasi si misurano leggendo i
+valori ai loro confini e facendo le differenze. Se gli eventi sono
+più dei contatori fisici il kernel li alterna, e ogni valore viene
+scalato del rapporto tra il tempo in cui il contatore era abilitato e
+quello in cui contava davvero.
+***/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "perfcount.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/* tipo e configurazione di un evento */
+typedef struct {
+    unsigned type;
+    unsigned long long config;
+} Event;
+
+/* eventi, nell'ordine di Perf_event */
+static const Event events[PERF_NEVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL
+                          | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                          | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB
+                          | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                          | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) }
+};
+
+/* eventi da usare quando quelli di `events` non sono disponibili: per
+   i miss dell'ultimo livello di cache il contatore generico dei miss,
+   che molti processori (e macchine virtuali) forniscono anche senza
+   l'evento specifico delle letture */
+static const Event fallbacks[PERF_NEVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_MAX },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_MAX },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_MAX },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_MAX }
+};
+
+/* apre il contatore dell'evento `ev` per il processo chiamante */
+static int open_event(const Event* ev)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = ev->type;
+    attr.config = ev->config;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void perf_open(PerfCounters* pc)
+{
+    int e;
+
+    pc->navailable = 0;
+    pc->err = 0;
+    for (e = 0; e < PERF_NEVENTS; e++) {
+        pc->fd[e] = open_event(&events[e]);
+        if (pc->fd[e] < 0 && errno != EACCES && errno != EPERM
+            && fallbacks[e].config != PERF_COUNT_HW_MAX)
+            pc->fd[e] = open_event(&fallbacks[e]);
+        if (pc->fd[e] >= 0)
+            pc->navailable++;
+        else if (pc->err == 0)
+            pc->err = errno;
+    }
+}
+
+void perf_close(PerfCounters* pc)
+{
+    int e;
+
+    for (e = 0; e < PERF_NEVENTS; e++) {
+        if (pc->fd[e] >= 0)
+            close(pc->fd[e]);
+        pc->fd[e] = -1;
+    }
+    pc->navailable = 0;
+}
+
+void perf_read(const PerfCounters* pc, PerfSample* s)
+{
+    int e;
+
+    for (e = 0; e < PERF_NEVENTS; e++) {
+        unsigned long long buf[3]; /* valore, tempo abilitato, tempo attivo */
+
+        s->v[e] = -1;
+        if (pc->fd[e] < 0 || read(pc->fd[e], buf, sizeof(buf)) != (ssize_t)sizeof(buf))
+            continue;
+        if (buf[2] == 0)
+            s->v[e] = 0;
+        else if (buf[2] < buf[1])
+            s->v[e] = (long long)((double)buf[0] * buf[1] / buf[2]);
+        else
+            s->v[e] = (long long)buf[0];
+    }
+}
+
+#else
+
+void perf_open(PerfCounters* pc)
+{
+    int e;
+
+    for (e = 0; e < PERF_NEVENTS; e++)
+        pc->fd[e] = -1;
+    pc->navailable = 0;
+    pc->err = ENOSYS;
+}
+
+void perf_close(PerfCounters* pc)
+{
+    (void)pc;
+}
+
+void perf_read(const PerfCounters* pc, PerfSample* s)
+{
+    int e;
+
+    (void)pc;
+    for (e = 0; e < PERF_NEVENTS; e++)
+        s->v[e] = -1;
+}
+
+#endif
+
+/* scrive su `f` la differenza tra due valori di un contatore, oppure
+   "n.d." se il contatore non è disponibile */
+static void print_delta(FILE* f, long long from, long long to, const char* what)
+{
+    if (from < 0 || to < 0)
+        fprintf(f, " n.d. %s", what);
+    else
+        fprintf(f, " %lld %s", to - from, what);
+}
+
+void perf_print(FILE* f, const char* label, const PerfSample* from, const PerfSample* to)
+{
+    const long long cycles = to->v[PERF_CYCLES] - from->v[PERF_CYCLES];
+    const long long instr = to->v[PERF_INSTRUCTIONS] - from->v[PERF_INSTRUCTIONS];
+
+    fprintf(f, "# %s:", label);
+    print_delta(f, from->v[PERF_CYCLES], to->v[PERF_CYCLES], "cicli,");
+    print_delta(f, from->v[PERF_INSTRUCTIONS], to->v[PERF_INSTRUCTIONS], "istruzioni");
+    if (from->v[PERF_CYCLES] >= 0 && from->v[PERF_INSTRUCTIONS] >= 0 && cycles > 0)
+        fprintf(f, " (IPC %.2f)", (double)instr / cycles);
+    fprintf(f, ",");
+    print_delta(f, from->v[PERF_LLC_MISSES], to->v[PERF_LLC_MISSES], "miss LLC,");
+    print_delta(f, from->v[PERF_BRANCH_MISSES], to->v[PERF_BRANCH_MISSES], "salti mal previsti,");
+    print_delta(f, from->v[PERF_DTLB_MISSES], to->v[PERF_DTLB_MISSES], "miss dTLB");
+    fprintf(f, "\n");
+}
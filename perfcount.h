@@ -0,0 +1,65 @@
+/****************************************************************************
+ *
+ * perfcount.h -- Contatori hardware delle prestazioni
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef PERFCOUNT_H
+#define PERFCOUNT_H
+
+#include <stdio.h>
+
+/* eventi contati */
+typedef enum {
+    PERF_CYCLES,        /* cicli di clock                               */
+    PERF_INSTRUCTIONS,  /* istruzioni eseguite                          */
+    PERF_LLC_MISSES,    /* letture mancate nella cache di ultimo livello */
+    PERF_BRANCH_MISSES, /* salti previsti in modo errato                */
+    PERF_DTLB_MISSES,   /* letture mancate nel TLB dei dati             */
+    PERF_NEVENTS
+} Perf_event;
+
+/* contatori del processo, inclusi i thread creati dopo l'apertura */
+typedef struct {
+    int fd[PERF_NEVENTS];   /* -1 per i contatori non disponibili       */
+    int navailable;         /* numero di contatori disponibili          */
+    int err;                /* errore del primo contatore non aperto    */
+} PerfCounters;
+
+/* valori dei contatori in un istante; -1 per quelli non disponibili */
+typedef struct {
+    long long v[PERF_NEVENTS];
+} PerfSample;
+
+/* Apre e avvia i contatori, contando solo il codice utente. I
+   contatori che il sistema non fornisce (hardware, macchina
+   virtuale, permessi, sistema diverso da Linux) restano non
+   disponibili senza che questo sia un errore. */
+void perf_open(PerfCounters* pc);
+
+/* Chiude i contatori */
+void perf_close(PerfCounters* pc);
+
+/* Legge i valori correnti dei contatori in `s`. Se il sistema deve
+   alternare i contatori perché sono più di quelli fisici, i valori
+   vengono scalati al tempo totale. */
+void perf_read(const PerfCounters* pc, PerfSample* s);
+
+/* Scrive su `f` una riga che riporta gli eventi contati tra i
+   campioni `from` e `to`, preceduta da `label` */
+void perf_print(FILE* f, const char* label, const PerfSample* from, const PerfSample* to);
+
+#endif
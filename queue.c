@@ -131,6 +131,7 @@ precedente. **Non usare la funzione `realloc()`**.
 #include <assert.h>
 #include <string.h>
 #include "queue.h"
+#include "memstat.h"
 
 
 #ifdef QUEUE_DEBUG
@@ -143,11 +144,11 @@ static void queue_debug( Queue *q )
 
 Queue *queue_create( void )
 {
-    Queue *q = (Queue*)malloc(sizeof(*q));
+    Queue *q = (Queue*)mem_alloc(MEM_QUEUE, sizeof(*q));
     assert(q != NULL);
 
     q->capacity = 2;
-    q->data = (QueueInfo*)malloc(q->capacity * sizeof(*(q->data)));
+    q->data = (QueueInfo*)mem_alloc(MEM_QUEUE, q->capacity * sizeof(*(q->data)));
     assert(q->data != NULL);
     q->head = q->tail = 0;
     return q;
@@ -157,11 +158,11 @@ void queue_destroy( Queue *q )
 {
     assert(q != NULL);
 
-    free(q->data);
+    mem_free(MEM_QUEUE, q->data);
     q->data = NULL;
     q->head = q->tail = -1;
     q->capacity = 0;
-    free(q);
+    mem_free(MEM_QUEUE, q);
 }
 
 /* Ritorna true (nonzero) se e solo se la coda è piena. */
@@ -192,7 +193,7 @@ static void queue_resize( Queue *q, int new_capacity )
     cur_size = queue_size(q);
     assert( new_capacity >= cur_size );
     cur_capacity = q->capacity;
-    new_data = (QueueInfo*)malloc(new_capacity * sizeof(QueueInfo));
+    new_data = (QueueInfo*)mem_alloc(MEM_QUEUE, new_capacity * sizeof(QueueInfo));
     assert(new_data != NULL);
     /* copiamo i dati dal vecchio al nuovo buffer */
     if (q->head <= q->tail) {
@@ -213,7 +214,7 @@ static void queue_resize( Queue *q, int new_capacity )
                q->data,
                q->tail * sizeof(QueueInfo));
     }
-    free(q->data);
+    mem_free(MEM_QUEUE, q->data);
     q->capacity = new_capacity;
     q->data = new_data;
     q->head = 0;
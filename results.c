@@ -0,0 +1,316 @@
+/****************************************************************************
+ *
+ * results.c -- Risultati di più richieste in formato binario
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+Il numero di richieste è noto all'inizio, quindi la posizione del
+blob è nota prima di scrivere il primo percorso: il blob viene
+scritto direttamente nella sua posizione definitiva, man mano che i
+percorsi vengono trovati, mentre i record (24 byte per richiesta)
+restano in memoria e vengono scritti al termine insieme
+all'intestazione. Solo se l'output non consente `fseek()` il blob
+passa da un file temporaneo.
+
+Un percorso ricavato dai predecessori ha le mosse in ordine inverso,
+ma la sua lunghezza è nota: le mosse vengono scritte nel buffer del
+percorso dall'ultima alla prima, ognuna nella sua posizione.
+
+Chi legge mappa il file in memoria e trova il record `i` in
+`records[i]` e la mossa `k` del record `r` nei bit `2 (k mod 4)` del
+byte `blob[r->offset + k / 4]`, senza alcuna decodifica.
+***/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "results.h"
+#include "memstat.h"
+
+static const char RESULTS_MAGIC[RESULTS_MAGIC_SIZE] = { 'R', 'O', 'B', 'O', 'R', 'E', 'S', '1' };
+
+#define BYTE_ORDER_MARK 0x01020304u
+
+struct ResultWriter {
+    FILE* f;            /* file di output                               */
+    FILE* blobFile;     /* file su cui viene scritto il blob: `f` oppure
+                           un file temporaneo                           */
+    ResultHeader header;
+    ResultRecord* records;
+    uint64_t nadded;    /* record aggiunti                              */
+    unsigned char* buf; /* mosse impacchettate del percorso corrente    */
+    size_t cap;
+    int ok;             /* zero dopo un errore di scrittura             */
+};
+
+/* codice di 2 bit della mossa `c` */
+static unsigned move_code(char c)
+{
+    switch (c) {
+    case 'N': return RESULT_MOVE_N;
+    case 'S': return RESULT_MOVE_S;
+    case 'E': return RESULT_MOVE_E;
+    default: return RESULT_MOVE_O;
+    }
+}
+
+ResultWriter* results_begin(FILE* f, uint64_t nrecords)
+{
+    ResultWriter* w = (ResultWriter*)mem_alloc(MEM_RESULTS, sizeof(*w));
+
+    assert(w != NULL);
+    assert(f != NULL);
+
+    memset(&w->header, 0, sizeof(w->header));
+    memcpy(w->header.magic, RESULTS_MAGIC, sizeof(RESULTS_MAGIC));
+    w->header.byteOrder = BYTE_ORDER_MARK;
+    w->header.recordSize = sizeof(ResultRecord);
+    w->header.nrecords = nrecords;
+    w->header.blobOffset = sizeof(ResultHeader) + nrecords * sizeof(ResultRecord);
+    w->records = (ResultRecord*)mem_calloc(MEM_RESULTS, nrecords > 0 ? nrecords : 1, sizeof(ResultRecord));
+    assert(w->records != NULL);
+    w->f = f;
+    w->nadded = 0;
+    w->cap = 1024;
+    w->buf = (unsigned char*)mem_alloc(MEM_RESULTS, w->cap);
+    assert(w->buf != NULL);
+    w->ok = 1;
+    if (fseek(f, (long)w->header.blobOffset, SEEK_SET) == 0)
+        w->blobFile = f;
+    else {
+        w->blobFile = tmpfile();
+        w->ok = (w->blobFile != NULL);
+    }
+    return w;
+}
+
+/* prepara il record della richiesta successiva e un buffer azzerato
+   per le sue `hops` mosse */
+static ResultRecord* next_record(ResultWriter* w, int hops)
+{
+    ResultRecord* r;
+    const size_t bytes = hops > 0 ? ((size_t)hops + 3) / 4 : 0;
+
+    assert(w->nadded < w->header.nrecords);
+    r = &w->records[w->nadded];
+    r->query = (uint32_t)w->nadded;
+    r->flags = hops >= 0 ? RESULT_REACHABLE : 0;
+    r->hops = hops;
+    r->nmoves = hops > 0 ? (uint32_t)hops : 0;
+    r->offset = w->header.blobSize;
+    if (bytes > w->cap) {
+        while (bytes > w->cap)
+            w->cap *= 2;
+        mem_free(MEM_RESULTS, w->buf);
+        w->buf = (unsigned char*)mem_alloc(MEM_RESULTS, w->cap);
+        assert(w->buf != NULL);
+    }
+    memset(w->buf, 0, bytes);
+    return r;
+}
+
+/* scrive nel blob le mosse del record `r` */
+static void flush_record(ResultWriter* w, const ResultRecord* r)
+{
+    const size_t bytes = ((size_t)r->nmoves + 3) / 4;
+
+    if (w->ok && bytes > 0)
+        w->ok = (fwrite(w->buf, 1, bytes, w->blobFile) == bytes);
+    w->header.blobSize += bytes;
+    w->nadded++;
+}
+
+void results_add_pred(ResultWriter* w, const Graph* g, const int* p, int src, int dst, int hops)
+{
+    ResultRecord* r = next_record(w, hops);
+    int v, k = hops;
+
+    if (hops > 0) {
+        for (v = dst; v != src; v = p[v]) {
+            const int u = p[v];
+            const int dr = graph_node_row(g, v) - graph_node_row(g, u);
+            const int dc = graph_node_col(g, v) - graph_node_col(g, u);
+            const unsigned code = dr > 0 ? RESULT_MOVE_S : dr < 0 ? RESULT_MOVE_N : dc < 0 ? RESULT_MOVE_O : RESULT_MOVE_E;
+            k--;
+            assert(k >= 0);
+            w->buf[k / 4] |= (unsigned char)(code << (2 * (k % 4)));
+        }
+        assert(k == 0);
+    }
+    flush_record(w, r);
+}
+
+void results_add_moves(ResultWriter* w, const char* moves, int hops)
+{
+    ResultRecord* r = next_record(w, hops);
+    int k;
+
+    for (k = 0; k < hops; k++)
+        w->buf[k / 4] |= (unsigned char)(move_code(moves[k]) << (2 * (k % 4)));
+    flush_record(w, r);
+}
+
+int results_end(ResultWriter* w)
+{
+    int ok = w->ok && w->nadded == w->header.nrecords;
+
+    if (ok && w->blobFile != w->f) {
+        /* il blob va copiato dopo i record */
+        ok = (fwrite(&w->header, sizeof(w->header), 1, w->f) == 1 &&
+              fwrite(w->records, sizeof(ResultRecord), (size_t)w->header.nrecords, w->f) == w->header.nrecords);
+        rewind(w->blobFile);
+        while (ok) {
+            const size_t got = fread(w->buf, 1, w->cap, w->blobFile);
+            if (got == 0)
+                break;
+            ok = (fwrite(w->buf, 1, got, w->f) == got);
+        }
+    }
+    else if (ok) {
+        ok = (fseek(w->f, 0, SEEK_SET) == 0 &&
+              fwrite(&w->header, sizeof(w->header), 1, w->f) == 1 &&
+              fwrite(w->records, sizeof(ResultRecord), (size_t)w->header.nrecords, w->f) == w->header.nrecords &&
+              fseek(w->f, 0, SEEK_END) == 0);
+    }
+    if (w->blobFile != NULL && w->blobFile != w->f)
+        fclose(w->blobFile);
+    mem_free(MEM_RESULTS, w->records);
+    mem_free(MEM_RESULTS, w->buf);
+    mem_free(MEM_RESULTS, w);
+    return ok ? 0 : -1;
+}
+
+/* 1 se il record `r` è coerente con un blob di `blobSize` byte: le
+   mosse stanno nel blob e corrispondono al numero di passi */
+static int record_valid(const ResultRecord* r, uint64_t blobSize)
+{
+    const uint64_t bytes = ((uint64_t)r->nmoves + 3) / 4;
+
+    if (r->flags == RESULT_REACHABLE) {
+        if (r->hops < 0 || r->nmoves != (uint32_t)r->hops)
+            return 0;
+    }
+    else if (r->flags != 0 || r->hops != -1 || r->nmoves != 0)
+        return 0;
+    return r->offset <= blobSize && bytes <= blobSize - r->offset;
+}
+
+int results_is_binary(const void* data, size_t size)
+{
+    return size >= sizeof(RESULTS_MAGIC) && memcmp(data, RESULTS_MAGIC, sizeof(RESULTS_MAGIC)) == 0;
+}
+
+int results_open(const char* path, ResultFile* rf)
+{
+    struct stat st;
+    const ResultHeader* h;
+    const ResultRecord* records;
+    char magic[sizeof(RESULTS_MAGIC)];
+    void* data;
+    uint64_t i;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return -1;
+    if (read(fd, magic, sizeof(magic)) != (ssize_t)sizeof(magic) ||
+        memcmp(magic, RESULTS_MAGIC, sizeof(magic)) != 0) {
+        close(fd);
+        return -1;
+    }
+    /* da qui in poi il file è un file di risultati, eventualmente
+       danneggiato */
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ResultHeader)) {
+        close(fd);
+        return -2;
+    }
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return -2;
+    h = (const ResultHeader*)data;
+    rf->size = (size_t)st.st_size;
+    /* il numero di record viene confrontato con la dimensione del
+       file prima di moltiplicarlo, per evitare il traboccamento */
+    if (h->byteOrder != BYTE_ORDER_MARK || h->recordSize != sizeof(ResultRecord) ||
+        h->nrecords > (rf->size - sizeof(ResultHeader)) / sizeof(ResultRecord) ||
+        h->blobOffset != sizeof(ResultHeader) + h->nrecords * sizeof(ResultRecord) ||
+        h->blobSize != rf->size - h->blobOffset) {
+        munmap(data, rf->size);
+        return -2;
+    }
+    records = (const ResultRecord*)(h + 1);
+    for (i = 0; i < h->nrecords; i++) {
+        if (records[i].query != i || !record_valid(&records[i], h->blobSize)) {
+            munmap(data, rf->size);
+            return -2;
+        }
+    }
+    rf->header = h;
+    rf->records = records;
+    rf->blob = (const unsigned char*)data + h->blobOffset;
+    return 0;
+}
+
+void results_close(ResultFile* rf)
+{
+    munmap((void*)rf->header, rf->size);
+    rf->header = NULL;
+    rf->records = NULL;
+    rf->blob = NULL;
+}
+
+char results_move(const ResultFile* rf, const ResultRecord* r, uint32_t k)
+{
+    static const char moves[4] = { 'N', 'S', 'E', 'O' };
+
+    assert(k < r->nmoves);
+    return moves[(rf->blob[r->offset + k / 4] >> (2 * (k % 4))) & 3];
+}
+
+long results_write_text(const ResultFile* rf, FILE* f)
+{
+    static const char moves[4] = { 'N', 'S', 'E', 'O' };
+    char buf[4096];
+    long total = 0;
+    uint64_t i;
+
+    for (i = 0; i < rf->header->nrecords; i++) {
+        const ResultRecord* r = &rf->records[i];
+        const unsigned char* b = rf->blob + r->offset;
+        uint32_t k, len = 0;
+
+        fprintf(f, "%d\n", r->hops);
+        for (k = 0; k < r->nmoves; k++) {
+            buf[len++] = moves[(b[k / 4] >> (2 * (k % 4))) & 3];
+            if (len == sizeof(buf)) {
+                fwrite(buf, 1, len, f);
+                len = 0;
+            }
+        }
+        fwrite(buf, 1, len, f);
+        fputc('\n', f);
+        total += r->nmoves;
+    }
+    return total;
+}
@@ -0,0 +1,113 @@
+/****************************************************************************
+ *
+ * results.h -- Risultati di più richieste in formato binario
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "graph.h"
+
+/* Il file inizia con un'intestazione, seguita da un record di
+   dimensione fissa per ogni richiesta, nell'ordine delle richieste, e
+   dal blob delle mosse. Nel blob ogni mossa occupa 2 bit (vedi
+   RESULT_MOVE_*), quattro per byte a partire dai bit meno
+   significativi, e ogni percorso inizia ad un nuovo byte. Gli interi
+   sono nell'ordine dei byte della macchina che ha scritto il file,
+   riconoscibile dal campo `byteOrder`. */
+
+#define RESULT_MOVE_N 0
+#define RESULT_MOVE_S 1
+#define RESULT_MOVE_E 2
+#define RESULT_MOVE_O 3
+
+#define RESULT_REACHABLE 1  /* flag: la destinazione è raggiungibile */
+
+#define RESULTS_MAGIC_SIZE 8 /* byte che identificano il file          */
+
+typedef struct {
+    char magic[RESULTS_MAGIC_SIZE]; /* "ROBORES1"                       */
+    uint32_t byteOrder;     /* 0x01020304                               */
+    uint32_t recordSize;    /* sizeof(ResultRecord)                     */
+    uint64_t nrecords;      /* numero di record                         */
+    uint64_t blobOffset;    /* posizione del blob dall'inizio del file  */
+    uint64_t blobSize;      /* byte del blob                            */
+} ResultHeader;
+
+typedef struct {
+    uint32_t query;         /* numero della richiesta, da 0             */
+    uint32_t flags;         /* RESULT_REACHABLE                         */
+    int32_t hops;           /* numero di mosse, -1 se non raggiungibile */
+    uint32_t nmoves;        /* mosse del percorso nel blob              */
+    uint64_t offset;        /* primo byte del percorso nel blob         */
+} ResultRecord;
+
+/* scrittura di un file di risultati */
+typedef struct ResultWriter ResultWriter;
+
+/* Inizia a scrivere sul file `f` i risultati di `nrecords` richieste.
+   Se `f` non consente di spostarsi (per esempio una pipe) il blob
+   viene scritto in un file temporaneo e copiato al termine. */
+ResultWriter* results_begin(FILE* f, uint64_t nrecords);
+
+/* Aggiunge il risultato della richiesta successiva: il percorso da
+   `src` a `dst` di `hops` mosse (-1 se non esiste) ricavato a ritroso
+   dall'array dei predecessori `p` del grafo `g` */
+void results_add_pred(ResultWriter* w, const Graph* g, const int* p, int src, int dst, int hops);
+
+/* Aggiunge il risultato della richiesta successiva, dato come stringa
+   di `hops` mosse N/S/E/O (NULL e -1 se non esiste) */
+void results_add_moves(ResultWriter* w, const char* moves, int hops);
+
+/* Completa il file (intestazione e record) e libera `w`. Restituisce
+   0 se la scrittura è riuscita, -1 altrimenti. */
+int results_end(ResultWriter* w);
+
+/* file di risultati mappato in memoria */
+typedef struct {
+    const ResultHeader* header;
+    const ResultRecord* records;
+    const unsigned char* blob;
+    size_t size;            /* byte del file                            */
+} ResultFile;
+
+/* Restituisce un valore diverso da zero se i primi `size` byte di un
+   file, in `data`, sono quelli di un file di risultati */
+int results_is_binary(const void* data, size_t size);
+
+/* Mappa in memoria il file di risultati `path` e ne controlla
+   l'intestazione, le dimensioni e tutti i record: le mosse di ogni
+   record devono stare nel blob e corrispondere al numero di passi e
+   ai flag. Restituisce 0 se il file è valido, -1 se non esiste o non
+   è un file di risultati, -2 se è un file di risultati danneggiato. */
+int results_open(const char* path, ResultFile* rf);
+
+/* Rilascia un file aperto con `results_open()` */
+void results_close(ResultFile* rf);
+
+/* Restituisce la mossa numero `k` (N/S/E/O) del record `r`, in tempo
+   costante */
+char results_move(const ResultFile* rf, const ResultRecord* r, uint32_t k);
+
+/* Scrive su `f` i risultati nel formato testuale della modalità a
+   richieste multiple (-q) e restituisce il numero di mosse scritte */
+long results_write_text(const ResultFile* rf, FILE* f);
+
+#endif
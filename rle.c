@@ -0,0 +1,243 @@
+/****************************************************************************
+ *
+ * rle.c -- Percorsi compressi con codifica run-length
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+I percorsi lunghi sulle mappe grandi sono fatti soprattutto di tratti
+rettilinei, quindi il numero di sequenze di mosse uguali è molto
+minore del numero di mosse. `rle_write_pred()` segue i predecessori
+dalla destinazione alla sorgente, cioè con le mosse in ordine inverso:
+le sequenze vengono raccolte in un array (una voce per sequenza, non
+per mossa) e poi scritte dall'ultima alla prima.
+
+Il decodificatore è un automa che legge un carattere alla volta:
+all'inizio di ogni riga decide, dal primo carattere, se la riga
+contiene mosse compresse oppure va copiata così com'è, quindi non
+tiene in memoria né le righe né le mosse.
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include "rle.h"
+#include "memstat.h"
+
+/* sequenza di mosse uguali */
+typedef struct {
+    char move;
+    int count;
+} Run;
+
+static int is_move(int c)
+{
+    return c == 'N' || c == 'S' || c == 'E' || c == 'O' || c == 'F';
+}
+
+static void put_run(FILE* f, char move, long count)
+{
+    fputc(move, f);
+    if (count > 1)
+        fprintf(f, "%ld", count);
+}
+
+void rle_writer_init(RleWriter* w, FILE* f)
+{
+    assert(w != NULL);
+    assert(f != NULL);
+
+    w->f = f;
+    w->move = '\0';
+    w->count = 0;
+}
+
+void rle_put(RleWriter* w, char move)
+{
+    if (move == w->move) {
+        w->count++;
+        return;
+    }
+    if (w->count > 0)
+        put_run(w->f, w->move, w->count);
+    w->move = move;
+    w->count = 1;
+}
+
+void rle_flush(RleWriter* w)
+{
+    if (w->count > 0)
+        put_run(w->f, w->move, w->count);
+    w->move = '\0';
+    w->count = 0;
+}
+
+void rle_write_moves(FILE* f, const char* moves)
+{
+    RleWriter w;
+
+    assert(moves != NULL);
+    rle_writer_init(&w, f);
+    for (; *moves != '\0'; moves++)
+        rle_put(&w, *moves);
+    rle_flush(&w);
+}
+
+/* mossa che porta dal nodo `u` al nodo adiacente `v` */
+static char move_between(const Graph* g, int u, int v)
+{
+    const int dr = graph_node_row(g, v) - graph_node_row(g, u);
+    const int dc = graph_node_col(g, v) - graph_node_col(g, u);
+
+    return dr > 0 ? 'S' : dr < 0 ? 'N' : dc < 0 ? 'O' : 'E';
+}
+
+void rle_write_pred(FILE* f, const Graph* g, const int* p, int src, int dst, int header)
+{
+    Run* runs;
+    int nruns = 0, cap = 64, v;
+
+    assert(f != NULL);
+    assert(p != NULL);
+
+    fprintf(f, "%d\n", header);
+    if (header < 0)
+        return;
+    runs = (Run*)mem_alloc(MEM_RESULTS, cap * sizeof(*runs));
+    assert(runs != NULL);
+    for (v = dst; v != src; v = p[v]) {
+        const char move = move_between(g, p[v], v);
+        assert(p[v] >= 0);
+        if (nruns > 0 && runs[nruns - 1].move == move) {
+            runs[nruns - 1].count++;
+            continue;
+        }
+        if (nruns == cap) {
+            cap *= 2;
+            runs = (Run*)mem_realloc(MEM_RESULTS, runs, cap * sizeof(*runs));
+            assert(runs != NULL);
+        }
+        runs[nruns].move = move;
+        runs[nruns].count = 1;
+        nruns++;
+    }
+    while (nruns > 0) {
+        nruns--;
+        put_run(f, runs[nruns].move, runs[nruns].count);
+    }
+    mem_free(MEM_RESULTS, runs);
+}
+
+void rle_write_path(FILE* f, const Graph* g, const List* path, int src, int header)
+{
+    const ListNode* node;
+    RleWriter w;
+    int prev = src;
+
+    assert(path != NULL);
+
+    if (list_is_empty(path)) {
+        fprintf(f, "%d\n", -1);
+        return;
+    }
+    fprintf(f, "%d\n", header);
+    rle_writer_init(&w, f);
+    for (node = list_first(path); node != list_end(path); node = list_succ(node)) {
+        if (node->val != prev)
+            rle_put(&w, move_between(g, prev, node->val));
+        prev = node->val;
+    }
+    rle_flush(&w);
+}
+
+/* scrive `count` volte la mossa `move` */
+static void expand_run(FILE* out, char move, long count)
+{
+    char buf[4096];
+
+    memset(buf, move, sizeof(buf));
+    while (count > 0) {
+        const size_t k = count < (long)sizeof(buf) ? (size_t)count : sizeof(buf);
+        fwrite(buf, 1, k, out);
+        count -= (long)k;
+    }
+}
+
+/* termina la sequenza della mossa `move` (se c'è) con `count`
+   ripetizioni scritte con `ndigits` cifre, e la espande su `out`;
+   restituisce le mosse espanse, -1 se il numero non è valido */
+static long end_run(FILE* out, char move, long count, int ndigits)
+{
+    if (move == '\0')
+        return 0;
+    if (ndigits == 0)
+        count = 1;
+    else if (count == 0)
+        return -1;
+    expand_run(out, move, count);
+    return count;
+}
+
+long rle_decode(const char* head, size_t nhead, FILE* in, FILE* out)
+{
+    long total = 0, count = 0, k;
+    int c, lineStart = 1, inMoves = 0, ndigits = 0;
+    size_t i = 0;
+    char move = '\0';
+
+    assert(head != NULL || nhead == 0);
+    assert(in != NULL);
+    assert(out != NULL);
+
+    while ((c = (i < nhead) ? (unsigned char)head[i++] : getc(in)) != EOF) {
+        if (lineStart) {
+            inMoves = is_move(c);
+            lineStart = 0;
+        }
+        if (!inMoves) {
+            fputc(c, out);
+            lineStart = (c == '\n');
+            continue;
+        }
+        if (c >= '0' && c <= '9') {
+            if (move == '\0' || count > (LONG_MAX - 9) / 10)
+                return -1;
+            count = count * 10 + (c - '0');
+            ndigits++;
+            continue;
+        }
+        if ((k = end_run(out, move, count, ndigits)) < 0)
+            return -1;
+        total += k;
+        move = '\0';
+        count = 0;
+        ndigits = 0;
+        if (is_move(c))
+            move = (char)c;
+        else if (c == '\n' || c == '\r') {
+            fputc(c, out);
+            lineStart = (c == '\n');
+            inMoves = 0;
+        }
+        else
+            return -1;
+    }
+    if ((k = end_run(out, move, count, ndigits)) < 0)
+        return -1;
+    return total + k;
+}
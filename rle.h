@@ -0,0 +1,73 @@
+/****************************************************************************
+ *
+ * rle.h -- Percorsi compressi con codifica run-length
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef RLE_H
+#define RLE_H
+
+#include <stdio.h>
+#include "graph.h"
+#include "list.h"
+
+/* Nel formato compresso ogni sequenza di mosse uguali diventa la
+   mossa seguita dal numero di ripetizioni, omesso se è 1: per esempio
+   SSSSEEN diventa S4E2N. Le righe delle mosse sono le sole che
+   iniziano con una lettera, quindi il resto del file di output
+   (lunghezze, righe vuote) resta invariato. */
+
+/* scrittura incrementale di mosse in formato compresso */
+typedef struct {
+    FILE* f;
+    char move;      /* mossa della sequenza in corso, '\0' se nessuna   */
+    long count;     /* ripetizioni della sequenza in corso              */
+} RleWriter;
+
+/* Inizia la scrittura di una riga di mosse sul file `f` */
+void rle_writer_init(RleWriter* w, FILE* f);
+
+/* Aggiunge la mossa `move` */
+void rle_put(RleWriter* w, char move);
+
+/* Scrive la sequenza in corso; va chiamata al termine delle mosse */
+void rle_flush(RleWriter* w);
+
+/* Scrive su `f` la stringa di mosse `moves` in formato compresso */
+void rle_write_moves(FILE* f, const char* moves);
+
+/* Scrive su `f` il percorso da `src` a `dst` ricavato a ritroso
+   dall'array dei predecessori `p` del grafo `g`, preceduto da una
+   riga con `header` (la lunghezza o il costo), nello stesso formato di
+   `path_write_to_file()` ma con le mosse compresse. Le sequenze vengono
+   ricavate direttamente dai predecessori, senza costruire né la lista
+   dei nodi né la stringa delle mosse. Se `header` è negativo la
+   destinazione non è raggiungibile e viene scritto solo -1. */
+void rle_write_pred(FILE* f, const Graph* g, const int* p, int src, int dst, int header);
+
+/* Come `path_cost_write_to_file()`, con le mosse compresse */
+void rle_write_path(FILE* f, const Graph* g, const List* path, int src, int header);
+
+/* Legge un output scritto in formato compresso, formato dai `nhead`
+   byte di `head` (gia' letti dal chiamante, per esempio per
+   riconoscere il formato) seguiti dal resto del file `in`, e lo
+   scrive su `out` con le mosse espanse, un carattere alla volta, con
+   memoria costante. Restituisce il numero di mosse espanse, oppure -1
+   se il testo non è nel formato compresso (un numero non preceduto da
+   una mossa, un numero di ripetizioni nullo o troppo grande). */
+long rle_decode(const char* head, size_t nhead, FILE* in, FILE* out);
+
+#endif
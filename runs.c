@@ -0,0 +1,368 @@
+/****************************************************************************
+ *
+ * runs.c -- Ricerca di cammini su intervalli di posizioni libere
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+Nelle mappe con grandi zone libere e pochi ostacoli, le posizioni
+ammesse per il centro del robot formano su ogni riga pochi intervalli
+(_run_) molto lunghi. Invece di un nodo per posizione, la mappa viene
+rappresentata con i soli estremi dei run; la ricerca espande un intero
+run alla volta, insieme ai run delle righe adiacenti che lo
+sovrappongono.
+
+La distanza dalla sorgente non è costante lungo un run, ma si può
+descrivere in modo compatto. Due posizioni adiacenti della griglia
+hanno distanze che differiscono esattamente di 1, quindi lungo un run
+la distanza è determinata dai suoi minimi locali (_perni_): se il run
+ha i perni $(x_k, a_k)$, la distanza della colonna $c$ è
+$\min_k (a_k + |c - x_k|)$. Un perno $(x, a)$ di un run $R$ induce sul
+run $Q$ della riga adiacente, che sovrappone $R$ nelle colonne
+$[l, h]$, il perno candidato $(x', a + |x - x'| + 1)$ con
+$x' = \min(\max(x, l), h)$: è la colonna di $Q$ più vicina ad $x$
+raggiungibile con una mossa verticale.
+
+La ricerca è quindi l'algoritmo di Dijkstra sui perni candidati, in
+ordine di distanza con una coda a bucket ([bucketq.c](bucketq.c)). Un
+candidato estratto viene scartato se la distanza del run nella sua
+colonna è già minore o uguale; altrimenti diventa un perno del run e
+genera un candidato per ogni run adiacente. Come in Dijkstra, ogni
+perno accettato ha la distanza esatta; la ricerca termina quando la
+distanza dei candidati in coda non è inferiore a quella della
+destinazione. Ogni perno ricorda quello che lo ha generato: il cammino
+si ricostruisce a ritroso alternando spostamenti orizzontali lungo un
+run e mosse verticali tra run adiacenti.
+
+Il numero di perni dipende da quante volte gli ostacoli spezzano i
+run, non dalla loro lunghezza: in una stanza vuota ogni run riceve un
+solo perno. Anche la costruzione dei run salta le zone libere,
+cercando con `memchr()` il prossimo ostacolo sulle tre righe coperte
+dall'impronta.
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "bucketq.h"
+#include "runs.h"
+#include "memstat.h"
+
+/* capacità iniziale degli array a dimensione variabile */
+#define RUNS_MIN_CAPACITY 64
+
+/* colonna del primo ostacolo della riga `row` (di `m` celle) a partire
+   dalla colonna `j`; m se non ce ne sono */
+static int next_obstacle(const char* row, int j, int m)
+{
+    const char* q = (const char*)memchr(row + j, '*', m - j);
+    return (q != NULL) ? (int)(q - row) : m;
+}
+
+/* aggiunge il run [lo, hi] alla riga r */
+static void add_run(RunMap* rm, int* capacity, int r, int lo, int hi)
+{
+    if (rm->nruns == *capacity) {
+        *capacity *= 2;
+        rm->row = (int*)mem_realloc(MEM_GRAPH, rm->row, *capacity * sizeof(*(rm->row)));
+        rm->lo = (int*)mem_realloc(MEM_GRAPH, rm->lo, *capacity * sizeof(*(rm->lo)));
+        rm->hi = (int*)mem_realloc(MEM_GRAPH, rm->hi, *capacity * sizeof(*(rm->hi)));
+        rm->first = (int*)mem_realloc(MEM_GRAPH, rm->first, *capacity * sizeof(*(rm->first)));
+        assert(rm->row != NULL && rm->lo != NULL && rm->hi != NULL && rm->first != NULL);
+    }
+    rm->row[rm->nruns] = r;
+    rm->lo[rm->nruns] = lo;
+    rm->hi[rm->nruns] = hi;
+    rm->first[rm->nruns] = rm->npositions;
+    rm->npositions += hi - lo + 1;
+    rm->nruns++;
+}
+
+RunMap* runs_create(char** matrix, int n, int m)
+{
+    RunMap* rm = (RunMap*)mem_alloc(MEM_GRAPH, sizeof(*rm));
+    int capacity = RUNS_MIN_CAPACITY;
+    int i, k;
+
+    assert(rm != NULL);
+    assert(matrix != NULL);
+
+    rm->rows = n;
+    rm->cols = m;
+    rm->nruns = 0;
+    rm->npositions = 0;
+    rm->rowStart = (int*)mem_alloc(MEM_GRAPH, (n + 1) * sizeof(*(rm->rowStart)));
+    rm->row = (int*)mem_alloc(MEM_GRAPH, capacity * sizeof(*(rm->row)));
+    rm->lo = (int*)mem_alloc(MEM_GRAPH, capacity * sizeof(*(rm->lo)));
+    rm->hi = (int*)mem_alloc(MEM_GRAPH, capacity * sizeof(*(rm->hi)));
+    rm->first = (int*)mem_alloc(MEM_GRAPH, capacity * sizeof(*(rm->first)));
+    assert(rm->rowStart != NULL && rm->row != NULL && rm->lo != NULL && rm->hi != NULL && rm->first != NULL);
+
+    for (i = 0; i < n; i++) {
+        rm->rowStart[i] = rm->nruns;
+        if (i == 0 || i == n - 1)
+            continue; /* il centro non può stare sul bordo */
+        {
+            /* obs[k]: prossimo ostacolo della riga i - 1 + k */
+            int obs[3] = { -1, -1, -1 };
+            int j = 1; /* prima colonna candidata per un centro */
+            while (j <= m - 2) {
+                int o = m;
+                for (k = 0; k < 3; k++) {
+                    if (obs[k] < j - 1)
+                        obs[k] = next_obstacle(matrix[i - 1 + k], j - 1, m);
+                    if (obs[k] < o)
+                        o = obs[k];
+                }
+                /* un ostacolo nella colonna o esclude i centri da o - 1
+                   a o + 1 */
+                if (o - 2 >= j)
+                    add_run(rm, &capacity, i, j, (o - 2 < m - 2) ? o - 2 : m - 2);
+                j = o + 2;
+            }
+        }
+    }
+    rm->rowStart[n] = rm->nruns;
+    return rm;
+}
+
+void runs_destroy(RunMap* rm)
+{
+    assert(rm != NULL);
+
+    mem_free(MEM_GRAPH, rm->rowStart);
+    mem_free(MEM_GRAPH, rm->row);
+    mem_free(MEM_GRAPH, rm->lo);
+    mem_free(MEM_GRAPH, rm->hi);
+    mem_free(MEM_GRAPH, rm->first);
+    mem_free(MEM_GRAPH, rm);
+}
+
+int runs_n_positions(const RunMap* rm)
+{
+    assert(rm != NULL);
+
+    return rm->npositions;
+}
+
+/* run che contiene la posizione numero `v` (numerazione per righe) */
+static int runs_locate(const RunMap* rm, int v)
+{
+    int a = 0, b = rm->nruns - 1;
+
+    assert((v >= 0) && (v < rm->npositions));
+
+    /* ultimo run con first <= v */
+    while (a < b) {
+        const int mid = (a + b + 1) / 2;
+        if (rm->first[mid] <= v)
+            a = mid;
+        else
+            b = mid - 1;
+    }
+    return a;
+}
+
+/* perno: posizione di un run raggiunta con distanza esatta */
+typedef struct {
+    int run, col, dist;
+    int parent;     /* perno che lo ha generato, -1 per la sorgente     */
+    int next;       /* perno successivo dello stesso run, -1 se ultimo  */
+} Pivot;
+
+/* perno candidato in attesa nella coda */
+typedef struct {
+    int run, col;
+    int parent;
+} Candidate;
+
+/* stato di una ricerca */
+typedef struct {
+    int* head;          /* head[k]: primo perno del run k, -1 se nessuno */
+    Pivot* pivots;
+    int npivots, pivotCap;
+    Candidate* cands;
+    int ncands, candCap;
+    BucketQueue* queue;
+} RunSearch;
+
+/* distanza della colonna `c` del run `k` secondo i perni trovati
+   finora; -1 se il run non ha perni */
+static int run_dist(const RunSearch* s, int k, int c)
+{
+    int best = -1, i;
+
+    for (i = s->head[k]; i >= 0; i = s->pivots[i].next) {
+        const Pivot* pv = &s->pivots[i];
+        const int dd = pv->dist + abs(c - pv->col);
+        if (best < 0 || dd < best)
+            best = dd;
+    }
+    return best;
+}
+
+/* inserisce nella coda il candidato (k, c) a distanza `dist`, a meno
+   che il run non abbia già una distanza minore o uguale in c */
+static void push_candidate(RunSearch* s, int k, int c, int dist, int parent)
+{
+    const int cur = run_dist(s, k, c);
+
+    if (cur >= 0 && cur <= dist)
+        return;
+    if (s->ncands == s->candCap) {
+        s->candCap *= 2;
+        s->cands = (Candidate*)mem_realloc(MEM_SEARCH, s->cands, s->candCap * sizeof(*(s->cands)));
+        assert(s->cands != NULL);
+    }
+    s->cands[s->ncands].run = k;
+    s->cands[s->ncands].col = c;
+    s->cands[s->ncands].parent = parent;
+    bucketq_insert(s->queue, s->ncands, dist);
+    s->ncands++;
+}
+
+/* aggiunge al run k il perno (c, dist) e restituisce il suo indice */
+static int add_pivot(RunSearch* s, int k, int c, int dist, int parent)
+{
+    Pivot* pv;
+
+    if (s->npivots == s->pivotCap) {
+        s->pivotCap *= 2;
+        s->pivots = (Pivot*)mem_realloc(MEM_SEARCH, s->pivots, s->pivotCap * sizeof(*(s->pivots)));
+        assert(s->pivots != NULL);
+    }
+    pv = &s->pivots[s->npivots];
+    pv->run = k;
+    pv->col = c;
+    pv->dist = dist;
+    pv->parent = parent;
+    pv->next = s->head[k];
+    s->head[k] = s->npivots;
+    return s->npivots++;
+}
+
+/* genera i candidati dei run della riga r che sovrappongono le colonne
+   [lo, hi] a partire dal perno `p`, nella colonna x a distanza `dist` */
+static void expand_row(const RunMap* rm, RunSearch* s, int r, int lo, int hi, int x, int dist, int p)
+{
+    int a, b;
+
+    if (r < 0 || r >= rm->rows)
+        return;
+    /* primo run della riga che termina in lo o dopo */
+    a = rm->rowStart[r];
+    b = rm->rowStart[r + 1];
+    while (a < b) {
+        const int mid = (a + b) / 2;
+        if (rm->hi[mid] < lo)
+            a = mid + 1;
+        else
+            b = mid;
+    }
+    for (; a < rm->rowStart[r + 1] && rm->lo[a] <= hi; a++) {
+        const int l = (rm->lo[a] > lo) ? rm->lo[a] : lo;
+        const int h = (rm->hi[a] < hi) ? rm->hi[a] : hi;
+        const int c = (x < l) ? l : ((x > h) ? h : x);
+        push_candidate(s, a, c, dist + abs(x - c) + 1, p);
+    }
+}
+
+void runs_search(const RunMap* rm, int src, int dst, RunPath* path)
+{
+    RunSearch s;
+    const int srcRun = runs_locate(rm, src);
+    const int dstRun = runs_locate(rm, dst);
+    const int dstCol = rm->lo[dstRun] + dst - rm->first[dstRun];
+    int best = -1, k, i;
+
+    assert(path != NULL);
+
+    s.head = (int*)mem_alloc(MEM_SEARCH, rm->nruns * sizeof(*(s.head)));
+    assert(s.head != NULL);
+    for (k = 0; k < rm->nruns; k++)
+        s.head[k] = -1;
+    s.pivotCap = s.candCap = RUNS_MIN_CAPACITY;
+    s.npivots = s.ncands = 0;
+    s.pivots = (Pivot*)mem_alloc(MEM_SEARCH, s.pivotCap * sizeof(*(s.pivots)));
+    s.cands = (Candidate*)mem_alloc(MEM_SEARCH, s.candCap * sizeof(*(s.cands)));
+    assert(s.pivots != NULL && s.cands != NULL);
+    /* un candidato dista al più m + 1 dal perno che lo genera */
+    s.queue = bucketq_create(rm->cols + 1);
+
+    path->nexpanded = 0;
+    push_candidate(&s, srcRun, rm->lo[srcRun] + src - rm->first[srcRun], 0, -1);
+    while (!bucketq_is_empty(s.queue)) {
+        int dist, p;
+        const int ci = bucketq_delete_min(s.queue, &dist);
+        const Candidate c = s.cands[ci];
+        const int cur = run_dist(&s, c.run, c.col);
+
+        if (best >= 0 && dist >= best)
+            break; /* nessun candidato può migliorare la destinazione */
+        if (cur >= 0 && cur <= dist)
+            continue;
+        p = add_pivot(&s, c.run, c.col, dist, c.parent);
+        path->nexpanded++;
+        if (c.run == dstRun)
+            best = run_dist(&s, dstRun, dstCol);
+        expand_row(rm, &s, rm->row[c.run] - 1, rm->lo[c.run], rm->hi[c.run], c.col, dist, p);
+        expand_row(rm, &s, rm->row[c.run] + 1, rm->lo[c.run], rm->hi[c.run], c.col, dist, p);
+    }
+
+    path->length = best;
+    path->moves = NULL;
+    if (best >= 0) {
+        /* perno del run di destinazione da cui proviene il cammino */
+        int p = -1, col = dstCol, pos = best;
+        for (i = s.head[dstRun]; i >= 0; i = s.pivots[i].next) {
+            if (s.pivots[i].dist + abs(dstCol - s.pivots[i].col) == best) {
+                p = i;
+                break;
+            }
+        }
+        assert(p >= 0);
+        path->moves = (char*)mem_alloc(MEM_SEARCH, best + 1);
+        assert(path->moves != NULL);
+        path->moves[best] = '\0';
+        /* a ritroso: spostamento orizzontale dal perno alla colonna
+           corrente, poi mossa verticale dal perno che lo ha generato */
+        while (p >= 0) {
+            const Pivot* pv = &s.pivots[p];
+            for (; col > pv->col; col--)
+                path->moves[--pos] = 'E';
+            for (; col < pv->col; col++)
+                path->moves[--pos] = 'O';
+            p = pv->parent;
+            if (p >= 0)
+                path->moves[--pos] = (rm->row[pv->run] > rm->row[s.pivots[p].run]) ? 'S' : 'N';
+        }
+        assert(pos == 0);
+    }
+
+    bucketq_destroy(s.queue);
+    mem_free(MEM_SEARCH, s.head);
+    mem_free(MEM_SEARCH, s.pivots);
+    mem_free(MEM_SEARCH, s.cands);
+}
+
+void runs_path_free(RunPath* path)
+{
+    assert(path != NULL);
+
+    mem_free(MEM_SEARCH, path->moves);
+    path->moves = NULL;
+}
@@ -0,0 +1,70 @@
+/****************************************************************************
+ *
+ * runs.h -- Ricerca di cammini su intervalli di posizioni libere
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef RUNS_H
+#define RUNS_H
+
+/* Spazio libero della mappa come insieme di intervalli (run): ogni run
+   è una sequenza massimale di posizioni ammesse per il centro
+   dell'impronta 3x3 sulla stessa riga. I run di ogni riga sono
+   ordinati per colonna, e le righe sono in ordine crescente. */
+typedef struct {
+    int rows, cols;     /* dimensioni della mappa                         */
+    int nruns;          /* numero di run                                  */
+    int npositions;     /* numero di posizioni ammesse                    */
+    int* rowStart;      /* run della riga r: da rowStart[r] a
+                           rowStart[r + 1] - 1                            */
+    int* row;           /* row[k]: riga del run k                         */
+    int* lo, * hi;      /* colonne estreme (incluse) del run k            */
+    int* first;         /* first[k]: numero per righe della posizione
+                           (row[k], lo[k]), come nei nodi del grafo       */
+} RunMap;
+
+/* cammino trovato da `runs_search()` */
+typedef struct {
+    int length;     /* numero di mosse, -1 se la destinazione non e'
+                       raggiungibile                                    */
+    char* moves;    /* `length` mosse N/S/E/O terminate da '\0', NULL
+                       se la destinazione non e' raggiungibile          */
+    int nexpanded;  /* numero di espansioni eseguite dalla ricerca      */
+} RunPath;
+
+/* Costruisce gli intervalli della mappa `matrix` di `n` righe ed `m`
+   colonne. La memoria richiesta è proporzionale al numero di run,
+   cioè ai bordi degli ostacoli, e non all'area della mappa. */
+RunMap* runs_create(char** matrix, int n, int m);
+
+/* Libera la memoria associata agli intervalli */
+void runs_destroy(RunMap* rm);
+
+/* Restituisce il numero di posizioni ammesse, cioè di nodi del grafo
+   corrispondente */
+int runs_n_positions(const RunMap* rm);
+
+/* Cerca un cammino minimo dalla posizione numero `src` alla posizione
+   numero `dst`, numerate per righe come i nodi del grafo (si veda
+   `graph_node_from_rank()`), e lo scrive in `path`. La distanza è la
+   stessa della visita in ampiezza del grafo; a parità di lunghezza il
+   cammino può essere diverso. */
+void runs_search(const RunMap* rm, int src, int dst, RunPath* path);
+
+/* Libera la memoria associata al cammino */
+void runs_path_free(RunPath* path);
+
+#endif
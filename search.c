@@ -0,0 +1,144 @@
+/****************************************************************************
+ *
+ * search.c -- Visita in ampiezza da un nodo sorgente ad un nodo destinazione
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+La visita è quella di `dobfs()` con DOBFS_TOP_DOWN, con due
+differenze. Si ferma non appena la destinazione riceve una distanza:
+da quel momento il suo predecessore non cambia più, quindi il cammino
+trovato coincide con quello della visita completa. Inoltre la coda è un array in cui ogni
+nodo raggiunto viene inserito una sola volta: al termine della visita
+l'array contiene esattamente i nodi toccati.
+
+Per non dover azzerare le distanze tra una ricerca e l'altra, ogni
+nodo porta il numero (_epoca_) dell'ultima ricerca che lo ha
+raggiunto: un nodo è stato raggiunto dalla ricerca corrente se e solo
+se la sua epoca coincide con quella corrente, e iniziare una nuova
+ricerca richiede solo di incrementare l'epoca corrente. Quando il
+contatore torna a zero, dopo 2^32 - 1 ricerche, le epoche di tutti i
+nodi vengono riportate a zero: il costo O(n) si presenta una volta
+ogni 2^32 - 1 ricerche.
+***/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "search.h"
+#include "memstat.h"
+
+Search* search_create(const Graph* g)
+{
+    Search* s = (Search*)mem_alloc(MEM_SEARCH, sizeof(*s));
+
+    assert(s != NULL);
+    assert(g != NULL);
+
+    s->n = graph_n_nodes(g);
+    s->epoch = (unsigned*)mem_calloc(MEM_SEARCH, s->n, sizeof(*(s->epoch)));
+    assert(s->epoch != NULL);
+    s->cur = 0;
+    s->d = (int*)mem_alloc(MEM_SEARCH, s->n * sizeof(*(s->d)));
+    assert(s->d != NULL);
+    s->p = (int*)mem_alloc(MEM_SEARCH, s->n * sizeof(*(s->p)));
+    assert(s->p != NULL);
+    s->touched = (int*)mem_alloc(MEM_SEARCH, s->n * sizeof(*(s->touched)));
+    assert(s->touched != NULL);
+    s->ntouched = 0;
+    return s;
+}
+
+void search_destroy(Search* s)
+{
+    assert(s != NULL);
+
+    mem_free(MEM_SEARCH, s->epoch);
+    mem_free(MEM_SEARCH, s->d);
+    mem_free(MEM_SEARCH, s->p);
+    mem_free(MEM_SEARCH, s->touched);
+    mem_free(MEM_SEARCH, s);
+}
+
+int search_bfs_to(Search* s, const Graph* g, int src, int dst)
+{
+    unsigned* const epoch = s->epoch;
+    int* const d = s->d;
+    int* const p = s->p;
+    int* const q = s->touched;
+    unsigned cur;
+    int head, tail;
+
+    assert(graph_n_nodes(g) == s->n);
+    assert((src >= 0) && (src < s->n));
+    assert((dst >= 0) && (dst < s->n));
+
+    /* nuova epoca: tutti i nodi risultano non raggiunti */
+    if (++s->cur == 0) {
+        memset(epoch, 0, s->n * sizeof(*epoch));
+        s->cur = 1;
+    }
+    cur = s->cur;
+
+    epoch[src] = cur;
+    d[src] = 0;
+    p[src] = -1;
+    q[0] = src;
+    head = 0;
+    tail = 1;
+    /* con le etichette delle componenti connesse una destinazione
+       irraggiungibile si riconosce senza visitare la componente della
+       sorgente */
+    if (g->comp != NULL && g->comp[src] != g->comp[dst])
+        head = tail;
+    while (head < tail && epoch[dst] != cur) {
+        const int u = q[head++];
+        const Edge* edge;
+        for (edge = graph_adj(g, u); edge != NULL; edge = edge->next) {
+            const int v = edge->d;
+            if (epoch[v] != cur && edge->weight > -1) {
+                epoch[v] = cur;
+                d[v] = d[u] + 1;
+                p[v] = u;
+                q[tail++] = v;
+                if (v == dst)
+                    break;
+            }
+        }
+    }
+    s->ntouched = tail;
+    return search_dist(s, dst);
+}
+
+int search_dist(const Search* s, int v)
+{
+    assert(s != NULL);
+    assert((v >= 0) && (v < s->n));
+
+    return (s->cur != 0 && s->epoch[v] == s->cur) ? s->d[v] : -1;
+}
+
+void search_get_path(const Search* s, int v, List* path)
+{
+    assert(s != NULL);
+    assert(path != NULL);
+    assert((v >= 0) && (v < s->n));
+
+    if (search_dist(s, v) < 0)
+        return;
+    for (; v >= 0; v = s->p[v])
+        list_add_first(path, v);
+}
@@ -0,0 +1,72 @@
+/****************************************************************************
+ *
+ * search.h -- Visita in ampiezza da un nodo sorgente ad un nodo destinazione
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "graph.h"
+#include "list.h"
+
+/* contesto riutilizzabile per più ricerche sullo stesso grafo. Un
+   nodo v e' stato raggiunto dall'ultima ricerca se e solo se
+   epoch[v] == cur; in caso contrario d[v] e p[v] non sono
+   significativi. */
+typedef struct {
+    int n;          /* numero di nodi del grafo                         */
+    unsigned* epoch; /* epoch[v] = ultima ricerca che ha raggiunto v   */
+    unsigned cur;   /* numero dell'ultima ricerca                       */
+    int* d;         /* d[v] = distanza di v dalla sorgente              */
+    int* p;         /* p[v] = predecessore di v, -1 per la sorgente     */
+    int* touched;   /* nodi raggiunti dall'ultima ricerca, nell'ordine
+                       in cui sono stati raggiunti; e' anche la coda
+                       della visita                                     */
+    int ntouched;   /* numero di nodi in `touched`                      */
+} Search;
+
+/* Crea un contesto di ricerca per il grafo `g`. Tutti i nodi
+   risultano non raggiunti; gli array non vengono inizializzati
+   (tranne `epoch`, allocato con `calloc()`), quindi la creazione non
+   scrive nulla per nodo. */
+Search* search_create(const Graph* g);
+
+/* Libera la memoria associata al contesto */
+void search_destroy(Search* s);
+
+/* Visita in ampiezza del grafo `g` a partire da `src`, che si
+   interrompe non appena viene raggiunto `dst`. Al termine `s->d` e
+   `s->p` sono validi per i nodi in `s->touched`: in particolare il
+   cammino da `src` a `dst` si ricava seguendo `s->p` a ritroso. I
+   risultati della ricerca precedente vengono scartati in tempo O(1),
+   incrementando `s->cur`, quindi il tempo richiesto è proporzionale
+   alla parte di grafo esplorata e non al numero di nodi; se `g` ha le
+   etichette delle componenti connesse (`g->comp`), una destinazione
+   in un'altra componente viene riconosciuta senza visita. Restituisce
+   la distanza di `dst` da `src`, -1 se `dst` non è raggiungibile. */
+int search_bfs_to(Search* s, const Graph* g, int src, int dst);
+
+/* Restituisce la distanza del nodo `v` trovata dall'ultima ricerca,
+   -1 se `v` non e' stato raggiunto */
+int search_dist(const Search* s, int v);
+
+/* Inserisce in `path` i nodi del cammino da `src` al nodo `v`
+   trovato dall'ultima ricerca; se `v` non e' stato raggiunto la lista
+   resta vuota. */
+void search_get_path(const Search* s, int v, List* path);
+
+#endif
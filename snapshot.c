@@ -0,0 +1,453 @@
+/****************************************************************************
+ *
+ * snapshot.c -- Istantanea binaria del grafo di una mappa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+L'istantanea contiene gli array del grafo esattamente come stanno in
+memoria, uno dopo l'altro, preceduti da un'intestazione: caricarla
+significa mappare il file e far puntare i campi di `Graph` dentro la
+mappatura, senza copiare nulla.
+
+Gli unici dati che dipendono dall'indirizzo sono i puntatori `edges[v]`
+e `Edge.next`. Nel grafo creato da una mappa gli archi di ogni nodo
+sono consecutivi nel blocco `pool`, quindi ogni puntatore corrisponde
+ad un indice nel blocco. Nel file i puntatori vengono scritti già
+risolti per l'indirizzo SNAPSHOT_BASE, lo stesso per tutte le
+istantanee, che viene chiesto a mmap() come indirizzo preferito:
+se quell'intervallo è libero (il caso normale, dato che il programma
+mappa una sola istantanea) il grafo è utilizzabile così com'è.
+Altrimenti i puntatori vengono spostati con una passata su `edges` e
+su `pool`, che costa quanto una lettura del file.
+
+Il caricamento controlla solo l'intestazione, in tempo costante:
+identificatore, hash della mappa, dimensioni di `Edge` e dei
+puntatori, tipo e numerazione del grafo, e che numero di nodi e di
+archi corrispondano alla dimensione del file e alle posizioni delle
+sezioni. Il contenuto viene invece controllato una volta sola, subito
+dopo il salvataggio, rileggendo il file appena scritto: ogni
+puntatore deve indicare l'arco successivo dello stesso nodo e ogni
+numero di nodo o di posizione deve essere nei limiti; il grafo deve
+essere quello di una mappa (`id` e `pos` sono l'uno l'inverso
+dell'altro, e gli archi di ogni nodo portano, nell'ordine in cui li
+crea `graph_create_from_matrix()`, alle posizioni ammesse adiacenti,
+con la stessa etichetta di componente); infine l'hash di tutte le
+sezioni deve coincidere con quello dell'intestazione. Se il controllo
+fallisce il file viene eliminato. Ripetere il controllo ad ogni
+caricamento costerebbe quasi quanto ricostruire il grafo (una
+passata su tutto il file, vedi il README), annullando il vantaggio
+dell'istantanea; il file è trattato quindi come una cache fidata, al
+pari dei file .dst e .alt scritti dal programma.
+
+Le etichette delle componenti connesse permettono di riconoscere in
+tempo O(1) le richieste senza soluzione (vedi `search_bfs_to()`):
+gli archi del grafo di una mappa sono simmetrici, quindi due nodi
+sono collegati se e solo se hanno la stessa etichetta.
+***/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "snapshot.h"
+#include "memstat.h"
+#include "cache.h"
+
+static const char SNAPSHOT_MAGIC[8] = { 'R', 'O', 'B', 'O', 'G', 'R', 'F', '2' };
+
+/* elementi scritti (e aggiunti all'hash) con una sola fwrite() */
+#define SNAPSHOT_CHUNK 1024
+
+/* indirizzo per cui sono risolti i puntatori del file */
+#define SNAPSHOT_BASE ((uintptr_t)(sizeof(void*) >= 8 ? 0x5a0000000000ull : 0x60000000ull))
+
+typedef struct {
+    char magic[8];          /* "ROBOGRF2"                               */
+    uint64_t mapHash;       /* hash del contenuto della mappa           */
+    uint64_t bodyHash;      /* hash delle sezioni, vedi `hash_array()`  */
+    uint64_t base;          /* SNAPSHOT_BASE                            */
+    uint64_t size;          /* byte del file                            */
+    uint32_t edgeSize;      /* sizeof(Edge): cambia con la macchina     */
+    uint32_t pointerSize;   /* sizeof(void*)                            */
+    int32_t n, m, t, layout, rows, cols;
+    int64_t nedges;         /* archi nel blocco `pool`                  */
+} SnapshotHeader;
+
+/* sezioni del file, nell'ordine */
+enum { SEC_EDGES, SEC_POOL, SEC_IN_DEG, SEC_OUT_DEG, SEC_POS, SEC_ID, SEC_COMP, SEC_END };
+
+static uint64_t align8(uint64_t x)
+{
+    return (x + 7) & ~(uint64_t)7;
+}
+
+/* calcola la posizione di ogni sezione; off[SEC_END] è la dimensione
+   del file */
+static void section_offsets(const SnapshotHeader* h, uint64_t off[SEC_END + 1])
+{
+    const uint64_t n = (uint64_t)h->n;
+
+    off[SEC_EDGES] = align8(sizeof(SnapshotHeader));
+    off[SEC_POOL] = align8(off[SEC_EDGES] + n * sizeof(Edge*));
+    off[SEC_IN_DEG] = align8(off[SEC_POOL] + (uint64_t)h->nedges * sizeof(Edge));
+    off[SEC_OUT_DEG] = align8(off[SEC_IN_DEG] + n * sizeof(int));
+    off[SEC_POS] = align8(off[SEC_OUT_DEG] + n * sizeof(int));
+    off[SEC_ID] = align8(off[SEC_POS] + n * sizeof(int));
+    off[SEC_COMP] = align8(off[SEC_ID] + (uint64_t)h->rows * h->cols * sizeof(int));
+    off[SEC_END] = align8(off[SEC_COMP] + n * sizeof(int));
+}
+
+/* scrive `size` byte di `data` alla posizione `offset`, riempiendo di
+   zeri lo spazio dalla posizione attuale */
+static int write_at(FILE* f, uint64_t* cur, uint64_t offset, const void* data, size_t size)
+{
+    static const char zeros[8] = { 0 };
+
+    assert(offset >= *cur && offset - *cur < sizeof(zeros));
+    if (fwrite(zeros, 1, offset - *cur, f) != offset - *cur ||
+        fwrite(data, 1, size, f) != size)
+        return 0;
+    *cur = offset + size;
+    return 1;
+}
+
+/* aggiunge all'hash `h` gli `n` elementi di `size` byte di `data`, a
+   blocchi di SNAPSHOT_CHUNK elementi come li scrive `snapshot_save()`;
+   lo spazio tra le sezioni non ne fa parte */
+static uint64_t hash_array(uint64_t h, const void* data, int64_t n, size_t size)
+{
+    int64_t i;
+
+    for (i = 0; i < n; i += SNAPSHOT_CHUNK) {
+        const int64_t k = n - i < SNAPSHOT_CHUNK ? n - i : SNAPSHOT_CHUNK;
+        h = cache_hash((const char*)data + i * size, (size_t)k * size, h);
+    }
+    return h;
+}
+
+/* indirizzo che avrà, nel file mappato a SNAPSHOT_BASE, l'arco `e`
+   del blocco di `g` */
+static Edge* based_edge(const Graph* g, const Edge* e, const uint64_t off[])
+{
+    if (e == NULL)
+        return NULL;
+    return (Edge*)(SNAPSHOT_BASE + (uintptr_t)off[SEC_POOL] + (uintptr_t)(e - g->pool) * sizeof(Edge));
+}
+
+/* etichetta con una visita in ampiezza ogni componente connessa */
+static void label_components(const Graph* g, int* comp)
+{
+    int* q = (int*)mem_alloc(MEM_GRAPH, g->n * sizeof(*q));
+    int s, v, head, tail, label = 0;
+    const Edge* e;
+
+    for (v = 0; v < g->n; v++)
+        comp[v] = -1;
+    for (s = 0; s < g->n; s++) {
+        if (comp[s] >= 0)
+            continue;
+        comp[s] = label;
+        q[0] = s;
+        head = 0;
+        tail = 1;
+        while (head < tail) {
+            for (e = g->edges[q[head++]]; e != NULL; e = e->next) {
+                if (comp[e->d] < 0) {
+                    comp[e->d] = label;
+                    q[tail++] = e->d;
+                }
+            }
+        }
+        label++;
+    }
+    mem_free(MEM_GRAPH, q);
+}
+
+/* sposta di `delta` i puntatori del grafo mappato ad un indirizzo
+   diverso da SNAPSHOT_BASE */
+static void relocate(Edge** edges, int n, Edge* pool, int64_t nedges, uintptr_t delta)
+{
+    int64_t i;
+    int v;
+
+    for (v = 0; v < n; v++) {
+        if (edges[v] != NULL)
+            edges[v] = (Edge*)((uintptr_t)edges[v] + delta);
+    }
+    for (i = 0; i < nedges; i++) {
+        if (pool[i].next != NULL)
+            pool[i].next = (Edge*)((uintptr_t)pool[i].next + delta);
+    }
+}
+
+/* controlla che il contenuto del file mappato in `data`, con i
+   puntatori ancora risolti per SNAPSHOT_BASE, sia quello scritto da
+   `snapshot_save()`: gli archi di ogni nodo occupano, nell'ordine dei
+   nodi, `out_deg[v]` elementi consecutivi del blocco, collegati uno
+   al successivo, e tutti i numeri di nodo e di posizione sono nei
+   limiti. Così un file scritto male non può far leggere la ricerca
+   fuori dagli array né farla girare su una lista circolare. Poi
+   controlla che il grafo sia quello della numerazione `id`, con gli
+   archi verso le posizioni ammesse adiacenti nell'ordine OVEST, EST,
+   NORD, SUD (vedi `band_edges()` in graph.c), e che l'hash delle
+   sezioni sia quello dell'intestazione. */
+static int snapshot_valid(const SnapshotHeader* h, const char* data, const uint64_t off[])
+{
+    static const int DR[4] = { 1, -1, 0, 0 };
+    static const int DC[4] = { 0, 0, 1, -1 };
+    const uintptr_t poolBase = SNAPSHOT_BASE + (uintptr_t)off[SEC_POOL];
+    Edge* const* edges = (Edge* const*)(data + off[SEC_EDGES]);
+    const Edge* pool = (const Edge*)(data + off[SEC_POOL]);
+    const int* in_deg = (const int*)(data + off[SEC_IN_DEG]);
+    const int* out_deg = (const int*)(data + off[SEC_OUT_DEG]);
+    const int* pos = (const int*)(data + off[SEC_POS]);
+    const int* id = (const int*)(data + off[SEC_ID]);
+    const int* comp = (const int*)(data + off[SEC_COMP]);
+    const int64_t npos = (int64_t)h->rows * h->cols;
+    int64_t i, k = 0, nids = 0;
+    uint64_t body = h->mapHash;
+    int v, j;
+
+    for (v = 0; v < h->n; v++) {
+        const int deg = out_deg[v];
+
+        if (deg < 0 || deg > h->nedges - k || in_deg[v] < 0 ||
+            pos[v] < 0 || pos[v] >= npos || comp[v] < 0 || comp[v] >= h->n)
+            return 0;
+        if ((uintptr_t)edges[v] != (deg > 0 ? poolBase + (uintptr_t)k * sizeof(Edge) : 0))
+            return 0;
+        for (j = 0; j < deg; j++, k++) {
+            const uintptr_t next = (j < deg - 1) ? poolBase + (uintptr_t)(k + 1) * sizeof(Edge) : 0;
+            if (pool[k].d < 0 || pool[k].d >= h->n || (uintptr_t)pool[k].next != next)
+                return 0;
+        }
+    }
+    if (k != h->nedges || h->m != (h->t == GRAPH_UNDIRECTED ? k / 2 : k))
+        return 0;
+    for (i = 0; i < npos; i++) {
+        if (id[i] < -1 || id[i] >= h->n)
+            return 0;
+        nids += (id[i] >= 0);
+    }
+    if (nids != h->n)
+        return 0;
+
+    /* ora tutti gli indici sono nei limiti */
+    for (v = 0, k = 0; v < h->n; v++) {
+        const int r = pos[v] / h->cols, c = pos[v] % h->cols;
+        int deg = 0, d;
+
+        if (id[pos[v]] != v)
+            return 0;
+        for (j = 3; j >= 0; j--) {
+            if (r + DR[j] < 0 || r + DR[j] >= h->rows || c + DC[j] < 0 || c + DC[j] >= h->cols)
+                continue;
+            d = id[pos[v] + DR[j] * h->cols + DC[j]];
+            if (d < 0)
+                continue;
+            if (deg == out_deg[v] || pool[k + deg].d != d || comp[d] != comp[v])
+                return 0;
+            deg++;
+        }
+        if (deg != out_deg[v] || in_deg[v] != deg)
+            return 0;
+        k += deg;
+    }
+
+    body = hash_array(body, edges, h->n, sizeof(Edge*));
+    body = hash_array(body, pool, h->nedges, sizeof(Edge));
+    body = hash_array(body, in_deg, h->n, sizeof(int));
+    body = hash_array(body, out_deg, h->n, sizeof(int));
+    body = hash_array(body, pos, h->n, sizeof(int));
+    body = hash_array(body, id, npos, sizeof(int));
+    body = hash_array(body, comp, h->n, sizeof(int));
+    return body == h->bodyHash;
+}
+
+/* mappa il file `path` dopo aver controllato in tempo costante che
+   l'intestazione, letta in `*h`, sia quella di un grafo della mappa
+   con hash `mapHash`, tipo `t` e numerazione `layout`, e che le
+   sezioni `off` coprano esattamente il file; restituisce NULL se il
+   file non è utilizzabile */
+static char* snapshot_map(const char* path, uint64_t mapHash, Graph_type t, Graph_layout layout,
+                          SnapshotHeader* h, uint64_t off[SEC_END + 1])
+{
+    struct stat st;
+    char* data;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) != 0 || read(fd, h, sizeof(*h)) != (ssize_t)sizeof(*h) ||
+        memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        h->mapHash != mapHash || h->base != SNAPSHOT_BASE ||
+        h->edgeSize != sizeof(Edge) || h->pointerSize != sizeof(void*) ||
+        h->t != (int32_t)t || h->layout != (int32_t)layout ||
+        h->n < 0 || h->m < 0 || h->rows <= 0 || h->cols <= 0 || h->nedges < 0 ||
+        (uint64_t)h->nedges > (uint64_t)st.st_size / sizeof(Edge) ||
+        (uint64_t)h->rows * h->cols > (uint64_t)st.st_size / sizeof(int)) {
+        close(fd);
+        return NULL;
+    }
+    section_offsets(h, off);
+    if (h->size != off[SEC_END] || (uint64_t)st.st_size != h->size) {
+        close(fd);
+        return NULL;
+    }
+    /* copia privata: le eventuali correzioni dei puntatori non
+       modificano il file */
+    data = (char*)mmap((void*)SNAPSHOT_BASE, (size_t)h->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return data == MAP_FAILED ? NULL : data;
+}
+
+/* rilegge il file `path` appena scritto da `snapshot_save()` e ne
+   controlla l'intero contenuto con `snapshot_valid()`; restituisce 1
+   se è valido */
+static int snapshot_verify(const char* path, uint64_t mapHash, Graph_type t, Graph_layout layout)
+{
+    SnapshotHeader h;
+    uint64_t off[SEC_END + 1];
+    char* data = snapshot_map(path, mapHash, t, layout, &h, off);
+    int valid;
+
+    if (data == NULL)
+        return 0;
+    valid = snapshot_valid(&h, data, off);
+    munmap(data, (size_t)h.size);
+    return valid;
+}
+
+int snapshot_save(const Graph* g, const char* path, uint64_t mapHash)
+{
+    SnapshotHeader h;
+    uint64_t off[SEC_END + 1], cur = 0;
+    Edge buf[SNAPSHOT_CHUNK];
+    Edge* ptrs[SNAPSHOT_CHUNK];
+    int64_t i, nedges = 0;
+    int* comp;
+    int v, j, k, ok;
+    FILE* f;
+
+    assert(g != NULL);
+
+    for (v = 0; v < g->n; v++)
+        nedges += g->out_deg[v];
+    /* solo i grafi creati da una mappa hanno gli archi in blocco */
+    if (g->pos == NULL || (nedges > 0 && g->pool == NULL))
+        return -1;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    h.mapHash = mapHash;
+    h.bodyHash = mapHash;
+    h.base = SNAPSHOT_BASE;
+    h.edgeSize = sizeof(Edge);
+    h.pointerSize = sizeof(void*);
+    h.n = g->n;
+    h.m = g->m;
+    h.t = (int32_t)g->t;
+    h.layout = (int32_t)g->layout;
+    h.rows = g->rows;
+    h.cols = g->cols;
+    h.nedges = nedges;
+    section_offsets(&h, off);
+    h.size = off[SEC_END];
+
+    /* l'intestazione viene riscritta al termine, con l'hash */
+    f = fopen(path, "wb");
+    if (f == NULL)
+        return -1;
+    ok = write_at(f, &cur, 0, &h, sizeof(h));
+    for (v = 0; ok && v < g->n; v += SNAPSHOT_CHUNK) {
+        k = g->n - v < SNAPSHOT_CHUNK ? g->n - v : SNAPSHOT_CHUNK;
+        for (j = 0; j < k; j++)
+            ptrs[j] = based_edge(g, g->edges[v + j], off);
+        h.bodyHash = cache_hash(ptrs, k * sizeof(Edge*), h.bodyHash);
+        ok = write_at(f, &cur, v == 0 ? off[SEC_EDGES] : cur, ptrs, k * sizeof(Edge*));
+    }
+    for (i = 0; ok && i < nedges; i += SNAPSHOT_CHUNK) {
+        k = nedges - i < SNAPSHOT_CHUNK ? (int)(nedges - i) : SNAPSHOT_CHUNK;
+        for (j = 0; j < k; j++) {
+            buf[j] = g->pool[i + j];
+            buf[j].next = based_edge(g, buf[j].next, off);
+        }
+        h.bodyHash = cache_hash(buf, k * sizeof(Edge), h.bodyHash);
+        ok = write_at(f, &cur, i == 0 ? off[SEC_POOL] : cur, buf, k * sizeof(Edge));
+    }
+    if (ok && nedges == 0)
+        ok = write_at(f, &cur, off[SEC_POOL], buf, 0);
+    ok = ok && write_at(f, &cur, off[SEC_IN_DEG], g->in_deg, g->n * sizeof(int)) &&
+         write_at(f, &cur, off[SEC_OUT_DEG], g->out_deg, g->n * sizeof(int)) &&
+         write_at(f, &cur, off[SEC_POS], g->pos, g->n * sizeof(int)) &&
+         write_at(f, &cur, off[SEC_ID], g->id, (size_t)g->rows * g->cols * sizeof(int));
+    if (ok) {
+        comp = (int*)mem_alloc(MEM_GRAPH, g->n * sizeof(*comp));
+        label_components(g, comp);
+        ok = write_at(f, &cur, off[SEC_COMP], comp, g->n * sizeof(int)) &&
+             write_at(f, &cur, off[SEC_END], comp, 0);
+        h.bodyHash = hash_array(h.bodyHash, g->in_deg, g->n, sizeof(int));
+        h.bodyHash = hash_array(h.bodyHash, g->out_deg, g->n, sizeof(int));
+        h.bodyHash = hash_array(h.bodyHash, g->pos, g->n, sizeof(int));
+        h.bodyHash = hash_array(h.bodyHash, g->id, (int64_t)g->rows * g->cols, sizeof(int));
+        h.bodyHash = hash_array(h.bodyHash, comp, g->n, sizeof(int));
+        mem_free(MEM_GRAPH, comp);
+    }
+    ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, f) == 1;
+    if (fclose(f) != 0 || !ok || !snapshot_verify(path, mapHash, g->t, g->layout)) {
+        remove(path);
+        return -1;
+    }
+    return 0;
+}
+
+Graph* snapshot_load(const char* path, uint64_t mapHash, Graph_type t, Graph_layout layout)
+{
+    SnapshotHeader h;
+    uint64_t off[SEC_END + 1];
+    Graph* g;
+    char* data = snapshot_map(path, mapHash, t, layout, &h, off);
+
+    if (data == NULL)
+        return NULL;
+    if ((uintptr_t)data != SNAPSHOT_BASE)
+        relocate((Edge**)(data + off[SEC_EDGES]), h.n, (Edge*)(data + off[SEC_POOL]), h.nedges,
+                 (uintptr_t)data - SNAPSHOT_BASE);
+
+    g = (Graph*)mem_alloc(MEM_GRAPH, sizeof(*g));
+    g->n = h.n;
+    g->m = h.m;
+    g->t = t;
+    g->edges = (Edge**)(data + off[SEC_EDGES]);
+    g->pool = h.nedges > 0 ? (Edge*)(data + off[SEC_POOL]) : NULL;
+    g->in_deg = (int*)(data + off[SEC_IN_DEG]);
+    g->out_deg = (int*)(data + off[SEC_OUT_DEG]);
+    g->rows = h.rows;
+    g->cols = h.cols;
+    g->pos = (int*)(data + off[SEC_POS]);
+    g->id = (int*)(data + off[SEC_ID]);
+    g->layout = layout;
+    g->comp = (int*)(data + off[SEC_COMP]);
+    g->mapping = data;
+    g->mappingSize = (size_t)h.size;
+    return g;
+}
@@ -0,0 +1,45 @@
+/****************************************************************************
+ *
+ * snapshot.h -- Istantanea binaria del grafo di una mappa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "graph.h"
+
+/* Salva nel file `path` il grafo `g`, creato da una mappa il cui
+   contenuto ha hash `mapHash`: numerazione dei nodi, liste di
+   adiacenza, gradi ed etichette delle componenti connesse (calcolate
+   qui). Il file scritto viene riletto e controllato per intero (archi
+   verso nodi esistenti e adiacenti, liste di adiacenza dentro il
+   blocco degli archi, posizioni nella mappa, hash delle sezioni).
+   Restituisce 0 se il salvataggio è riuscito, -1 altrimenti (in tal
+   caso il file non viene lasciato a metà). */
+int snapshot_save(const Graph* g, const char* path, uint64_t mapHash);
+
+/* Carica con una sola mmap() il grafo salvato nel file `path`, se è
+   stato ottenuto da una mappa con hash `mapHash` con tipo `t` e
+   numerazione `layout`; restituisce NULL altrimenti (file assente,
+   di un'altra mappa o di un'altra macchina). Il grafo va liberato con
+   `graph_destroy()` e ha `comp` valorizzato. Vengono controllate in
+   tempo costante solo l'intestazione e la dimensione del file: il
+   contenuto è stato controllato da `snapshot_save()`. */
+Graph* snapshot_load(const char* path, uint64_t mapHash, Graph_type t, Graph_layout layout);
+
+#endif
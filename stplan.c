@@ -0,0 +1,493 @@
+/****************************************************************************
+ *
+ * stplan.c -- Pianificazione prioritaria senza collisioni per più robot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+I robot vengono pianificati uno alla volta, in ordine di priorità. Le
+posizioni occupate dai robot già pianificati sono registrate in una
+_tabella delle prenotazioni_ ([sttable.c](sttable.c)) indicizzata
+dalla coppia (cella, istante). Due robot con impronta 3x3 centrati in
+$(r_1, c_1)$ e $(r_2, c_2)$ si sovrappongono se e solo se
+$|r_1 - r_2| \leq 2$ e $|c_1 - c_2| \leq 2$: per questo, quando un
+robot occupa una posizione, vengono prenotati tutti i 25 centri che
+entrerebbero in conflitto con esso, e verificare che una posizione
+sia libera all'istante $t$ richiede un solo accesso alla tabella.
+
+Ogni robot cerca il proprio cammino con A* nello spazio degli stati
+(cella, istante): da ogni stato si può avanzare in una delle quattro
+direzioni oppure restare fermi, sempre al costo di un istante. Il
+costo di uno stato coincide con il suo istante $t$, quindi ogni stato
+viene generato una sola volta. L'euristica $h$ è la distanza esatta
+dalla stazione ignorando gli altri robot. Invece di visitare tutta la
+mappa per ogni stazione, le distanze vengono calcolate su richiesta
+con un A* all'indietro (_Reverse Resumable A*_): la ricerca parte
+dalla stazione, è guidata dalla distanza di Manhattan verso la
+partenza del robot e, quando A* chiede la distanza di una cella non
+ancora chiusa, riprende finché la cella viene chiusa. Con
+un'euristica consistente la distanza di una cella chiusa è esatta,
+qualunque sia la partenza verso cui è guidata la ricerca: se il
+robot successivo ha la stessa stazione le distanze già calcolate
+restano valide e la frontiera viene solo riordinata.
+Quando più robot condividono la stazione, questa resta occupata in
+alcuni istanti, quindi il limite inferiore dell'istante di arrivo è
+il primo istante non inferiore a $t + h$ in cui la stazione è libera.
+
+In una stanza aperta quasi ogni cella sta su un cammino minimo, e A*
+con $f = t + h$ dovrebbe esaminare l'intera mappa per ogni istante di
+ritardo imposto dagli altri robot. Si usa quindi A* pesato, con
+priorità pari al limite inferiore dell'arrivo più $h$ (peso 2): la
+ricerca privilegia gli stati più vicini alla stazione e risolve i
+conflitti localmente, con un ritardo al più doppio rispetto
+all'ottimo. Le priorità sono interi e la frontiera è un array di
+bucket; a parità di priorità si estrae lo stato generato per ultimo
+(ogni bucket è una pila). Infine, oltre l'ultimo istante prenotato
+non possono più esserci conflitti: il primo stato estratto con $t$
+maggiore di tale istante viene completato seguendo direttamente
+l'euristica.
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "graph.h"
+#include "sttable.h"
+#include "stplan.h"
+#include "memstat.h"
+
+/* stato della ricerca nello spazio-tempo */
+typedef struct {
+    int cell;       /* riga * m + colonna   */
+    int t;          /* istante              */
+    int parent;     /* indice dello stato predecessore, -1 per la radice */
+} STNode;
+
+/* pila di interi a capacità variabile */
+typedef struct {
+    int* data;
+    int size, capacity;
+} IntStack;
+
+static void stack_push(IntStack* s, int v)
+{
+    if (s->size == s->capacity) {
+        s->capacity = s->capacity == 0 ? 64 : 2 * s->capacity;
+        s->data = (int*)mem_realloc(MEM_QUEUE, s->data, s->capacity * sizeof(*(s->data)));
+        assert(s->data != NULL);
+    }
+    s->data[s->size++] = v;
+}
+
+/* spostamenti di riga e colonna per le mosse N, S, E, O e attesa */
+static const int DR[5] = { -1, 1, 0, 0, 0 };
+static const int DC[5] = { 0, 0, 1, -1, 0 };
+static const char MOVES[5] = { 'N', 'S', 'E', 'O', MOVE_WAIT };
+
+/* distanze dalla stazione calcolate su richiesta (vedi sopra) */
+typedef struct {
+    const char* valid;
+    int m;
+    int goal;           /* stazione, -1 prima della prima ricerca        */
+    int start;          /* cella verso cui è diretta la ricerca          */
+    unsigned cur;       /* epoca della ricerca attuale                   */
+    unsigned* seen;     /* seen[c] == cur: g[c] è una stima valida       */
+    unsigned* done;     /* done[c] == cur: g[c] è la distanza esatta     */
+    int* g;             /* distanza dalla stazione                       */
+    IntStack* open;     /* open[f]: celle con priorità f                 */
+    int nbuckets, fmin, nopen;
+} Heuristic;
+
+static void h_init(Heuristic* H, const char* valid, int ncells, int m)
+{
+    H->valid = valid;
+    H->m = m;
+    H->goal = -1;
+    H->cur = 0;
+    H->seen = (unsigned*)mem_calloc(MEM_SEARCH, ncells, sizeof(*(H->seen)));
+    H->done = (unsigned*)mem_calloc(MEM_SEARCH, ncells, sizeof(*(H->done)));
+    H->g = (int*)mem_alloc(MEM_SEARCH, ncells * sizeof(*(H->g)));
+    assert(H->seen != NULL && H->done != NULL && H->g != NULL);
+    H->open = NULL;
+    H->nbuckets = H->fmin = H->nopen = 0;
+}
+
+static void h_destroy(Heuristic* H)
+{
+    int k;
+
+    for (k = 0; k < H->nbuckets; k++)
+        mem_free(MEM_QUEUE, H->open[k].data);
+    mem_free(MEM_QUEUE, H->open);
+    mem_free(MEM_SEARCH, H->seen);
+    mem_free(MEM_SEARCH, H->done);
+    mem_free(MEM_SEARCH, H->g);
+}
+
+/* distanza di Manhattan della cella `c` dalla partenza: limite
+   inferiore consistente della distanza sulla griglia */
+static int h_manhattan(const Heuristic* H, int c)
+{
+    const int dr = c / H->m - H->start / H->m, dc = c % H->m - H->start % H->m;
+    return (dr < 0 ? -dr : dr) + (dc < 0 ? -dc : dc);
+}
+
+/* assegna alla cella `c` la distanza provvisoria `g` e la inserisce
+   nella frontiera */
+static void h_push(Heuristic* H, int c, int g)
+{
+    const int f = g + h_manhattan(H, c);
+
+    if (f >= H->nbuckets) {
+        const int old = H->nbuckets;
+        if (H->nbuckets == 0)
+            H->nbuckets = 1024;
+        while (f >= H->nbuckets)
+            H->nbuckets *= 2;
+        H->open = (IntStack*)mem_realloc(MEM_QUEUE, H->open, H->nbuckets * sizeof(*(H->open)));
+        assert(H->open != NULL);
+        memset(H->open + old, 0, (H->nbuckets - old) * sizeof(*(H->open)));
+    }
+    H->seen[c] = H->cur;
+    H->g[c] = g;
+    stack_push(&H->open[f], c);
+    if (f < H->fmin)
+        H->fmin = f;
+    H->nopen++;
+}
+
+/* prepara il calcolo delle distanze dalla stazione `goal`, guidato
+   verso la cella `start`. Se la stazione è quella della ricerca
+   precedente le distanze già chiuse restano esatte: la frontiera viene
+   solo riordinata secondo la nuova partenza */
+static void h_reset(Heuristic* H, int goal, int start)
+{
+    IntStack frontier = { NULL, 0, 0 };
+    int k, i;
+
+    for (k = 0; k < H->nbuckets; k++) {
+        if (goal == H->goal) {
+            for (i = 0; i < H->open[k].size; i++) {
+                if (H->done[H->open[k].data[i]] != H->cur)
+                    stack_push(&frontier, H->open[k].data[i]);
+            }
+        }
+        H->open[k].size = 0;
+    }
+    H->nopen = 0;
+    H->fmin = H->nbuckets;
+    H->start = start;
+    if (goal == H->goal) {
+        /* una cella può comparire più volte: le copie vengono scartate
+           quando la cella è già chiusa */
+        for (i = 0; i < frontier.size; i++)
+            h_push(H, frontier.data[i], H->g[frontier.data[i]]);
+        mem_free(MEM_QUEUE, frontier.data);
+        return;
+    }
+    H->goal = goal;
+    H->cur++;
+    assert(H->cur != 0); /* al più MAX_ROBOTS ricerche */
+    if (H->valid[goal])
+        h_push(H, goal, 0);
+}
+
+/* restituisce la distanza della cella `c` dalla stazione se è già
+   nota, -1 altrimenti */
+static int h_known(const Heuristic* H, int c)
+{
+    return H->done[c] == H->cur ? H->g[c] : -1;
+}
+
+/* restituisce la distanza della cella valida `c` dalla stazione
+   ignorando gli altri robot, -1 se la stazione non è raggiungibile;
+   se non è ancora nota, riprende la ricerca finché `c` viene chiusa */
+static int h_get(Heuristic* H, int c)
+{
+    int k;
+
+    if (H->done[c] == H->cur)
+        return H->g[c];
+    while (H->nopen > 0) {
+        int u;
+        while (H->open[H->fmin].size == 0)
+            H->fmin++;
+        u = H->open[H->fmin].data[--H->open[H->fmin].size];
+        H->nopen--;
+        if (H->done[u] == H->cur)
+            continue; /* già chiusa con una priorità minore */
+        H->done[u] = H->cur;
+        for (k = 0; k < 4; k++) {
+            /* le celle valide non toccano mai il bordo della mappa,
+               quindi i vicini sono sempre all'interno */
+            const int v = u + DR[k] * H->m + DC[k];
+            if (H->valid[v] && H->done[v] != H->cur &&
+                (H->seen[v] != H->cur || H->g[u] + 1 < H->g[v]))
+                h_push(H, v, H->g[u] + 1);
+        }
+        if (u == c)
+            return H->g[u];
+    }
+    return -1;
+}
+
+/* prenota per il robot `robot` la posizione (r, c) all'istante t: nella
+   tabella vengono inseriti tutti i centri che, nello stesso istante,
+   porterebbero un altro robot a sovrapporsi, cioè quelli a distanza
+   al più 2 in entrambe le coordinate. In questo modo la verifica di
+   un conflitto richiede un solo accesso alla tabella. */
+static void st_reserve(STTable* res, int n, int m, int r, int c, int t, int robot)
+{
+    int rr, cc;
+
+    for (rr = r - 2; rr <= r + 2; rr++) {
+        if (rr < 0 || rr >= n)
+            continue;
+        for (cc = c - 2; cc <= c + 2; cc++) {
+            if (cc >= 0 && cc < m)
+                sttable_put(res, rr * m + cc, t, robot);
+        }
+    }
+}
+
+/* restituisce 1 se un robot centrato nella cella `cell` all'istante t
+   si sovrappone ad un robot già pianificato */
+static int st_conflict(const STTable* res, int cell, int t)
+{
+    return sttable_get(res, cell, t) >= 0;
+}
+
+/* aggiunge uno stato all'array `*nodes` e restituisce il suo indice */
+static int st_new_node(STNode** nodes, int* nnodes, int* capacity, int cell, int t, int parent)
+{
+    if (*nnodes == *capacity) {
+        *capacity = *capacity == 0 ? 1024 : 2 * *capacity;
+        *nodes = (STNode*)mem_realloc(MEM_SEARCH, *nodes, *capacity * sizeof(STNode));
+        assert(*nodes != NULL);
+    }
+    (*nodes)[*nnodes].cell = cell;
+    (*nodes)[*nnodes].t = t;
+    (*nodes)[*nnodes].parent = parent;
+    return (*nnodes)++;
+}
+
+/* restituisce la priorità dello stato (cella, t). L'istante di arrivo
+   non può precedere t + h(cella), né un istante in cui la stazione è
+   occupata (`goalNext[T]`, per T <= lastReserved + 1, è il primo
+   istante >= T in cui la stazione è libera); a questo limite inferiore
+   si somma ancora h(cella), cioè si usa A* pesato con peso 2. */
+static int st_f(int h, const int* goalNext, int lastReserved, int t)
+{
+    const int lb = t + h;
+    return (lb <= lastReserved + 1 ? goalNext[lb] : lb) + h;
+}
+
+/* A* nello spazio-tempo per il robot `rp`. `h` fornisce le distanze
+   dalla stazione, `closed` è una tabella di lavoro (viene svuotata),
+   `lastReserved` l'ultimo istante presente nella tabella `res`.
+   Restituisce 1 se il cammino è stato trovato, 0 altrimenti. */
+static int st_astar(const char* valid, Heuristic* h, int m,
+                    const STTable* res, int lastReserved,
+                    STTable* closed, RobotPlan* rp)
+{
+    const int start = rp->sr * m + rp->sc;
+    const int goal = rp->gr * m + rp->gc;
+    STNode* nodes = NULL;
+    int nnodes = 0, capacity = 0;
+    IntStack* open = NULL; /* open[f - f0]: stati con priorità f */
+    int nbuckets = 0, f0, fcur;
+    int* goalNext;
+    int nopen = 0, found = -1, k, t, cell;
+
+    sttable_clear(closed);
+    if (st_conflict(res, start, 0))
+        return 0;
+
+    goalNext = (int*)mem_alloc(MEM_SEARCH, (lastReserved + 2) * sizeof(*goalNext));
+    assert(goalNext != NULL);
+    goalNext[lastReserved + 1] = lastReserved + 1;
+    for (t = lastReserved; t >= 0; t--)
+        goalNext[t] = st_conflict(res, goal, t) ? goalNext[t + 1] : t;
+
+    /* nessuno stato può avere priorità inferiore a h(start) */
+    f0 = h_get(h, start);
+    fcur = st_f(f0, goalNext, lastReserved, 0);
+    sttable_put(closed, start, 0, 0);
+    k = st_new_node(&nodes, &nnodes, &capacity, start, 0, -1);
+    nbuckets = 16;
+    while (fcur - f0 >= nbuckets)
+        nbuckets *= 2;
+    open = (IntStack*)mem_calloc(MEM_QUEUE, nbuckets, sizeof(*open));
+    assert(open != NULL);
+    stack_push(&open[fcur - f0], k);
+    nopen++;
+
+    while (nopen > 0) {
+        int u;
+        while (open[fcur - f0].size == 0)
+            fcur++;
+        u = open[fcur - f0].data[--open[fcur - f0].size];
+        nopen--;
+
+        /* oltre l'ultimo istante prenotato il cammino può proseguire
+           liberamente seguendo l'euristica */
+        if (nodes[u].cell == goal || nodes[u].t > lastReserved) {
+            found = u;
+            break;
+        }
+        for (k = 0; k < 5; k++) {
+            const int v = nodes[u].cell + DR[k] * m + DC[k];
+            const int tv = nodes[u].t + 1;
+            int fv, hv;
+            if (!valid[v] || (hv = h_get(h, v)) < 0)
+                continue;
+            if (sttable_get(closed, v, tv) >= 0)
+                continue;
+            if (st_conflict(res, v, tv))
+                continue;
+            sttable_put(closed, v, tv, 0);
+            fv = st_f(hv, goalNext, lastReserved, tv);
+            if (fv - f0 >= nbuckets) {
+                const int old = nbuckets;
+                while (fv - f0 >= nbuckets)
+                    nbuckets *= 2;
+                open = (IntStack*)mem_realloc(MEM_QUEUE, open, nbuckets * sizeof(*open));
+                assert(open != NULL);
+                memset(open + old, 0, (nbuckets - old) * sizeof(*open));
+            }
+            stack_push(&open[fv - f0], st_new_node(&nodes, &nnodes, &capacity, v, tv, u));
+            if (fv < fcur)
+                fcur = fv;
+            nopen++;
+        }
+    }
+
+    if (found >= 0) {
+        /* l'istante di arrivo è quello dello stato trovato più la
+           distanza residua dalla stazione */
+        int u;
+        rp->arrival = nodes[found].t + h_get(h, nodes[found].cell);
+        rp->cells = (int*)mem_alloc(MEM_SEARCH, (rp->arrival + 1) * sizeof(*(rp->cells)));
+        assert(rp->cells != NULL);
+        rp->moves = (char*)mem_alloc(MEM_SEARCH, rp->arrival + 1);
+        assert(rp->moves != NULL);
+        for (u = found; u >= 0; u = nodes[u].parent)
+            rp->cells[nodes[u].t] = nodes[u].cell;
+        /* completamento lungo l'euristica: il predecessore di una
+           cella chiusa nella ricerca all'indietro è chiuso anch'esso */
+        cell = nodes[found].cell;
+        for (t = nodes[found].t + 1; t <= rp->arrival; t++) {
+            for (k = 0; k < 4; k++) {
+                const int v = cell + DR[k] * m + DC[k];
+                if (valid[v] && h_known(h, v) == h_known(h, cell) - 1)
+                    break;
+            }
+            assert(k < 4);
+            cell += DR[k] * m + DC[k];
+            rp->cells[t] = cell;
+        }
+        for (t = 0; t < rp->arrival; t++) {
+            const int diff = rp->cells[t + 1] - rp->cells[t];
+            for (k = 0; k < 5 && diff != DR[k] * m + DC[k]; k++)
+                ;
+            assert(k < 5);
+            rp->moves[t] = MOVES[k];
+        }
+        rp->moves[rp->arrival] = '\0';
+    }
+
+    for (k = 0; k < nbuckets; k++)
+        mem_free(MEM_QUEUE, open[k].data);
+    mem_free(MEM_QUEUE, open);
+    mem_free(MEM_SEARCH, goalNext);
+    mem_free(MEM_SEARCH, nodes);
+    return found >= 0;
+}
+
+int stplan_prioritized(char** matrix, int n, int m, RobotPlan* robots, int k)
+{
+    const int ncells = n * m;
+    signed char* weights;
+    char* valid;
+    Heuristic h;
+    STTable* res, * closed;
+    int lastReserved = -1, nplanned = 0;
+    int i, t;
+
+    assert(matrix != NULL);
+    assert(robots != NULL);
+    assert(k > 0);
+
+    /* stesse posizioni ammesse da create_nodes(): il centro non sta
+       sul bordo e l'impronta 3x3 non contiene ostacoli. I pesi sono
+       calcolati per righe come nella costruzione del grafo, invece di
+       rileggere le nove celle di ogni impronta. */
+    weights = (signed char*)mem_alloc(MEM_SEARCH, ncells);
+    assert(weights != NULL);
+    graph_footprint_weights(matrix, n, m, 0, n, weights);
+    valid = (char*)weights;
+    for (i = 0; i < ncells; i++)
+        valid[i] = (weights[i] > 0);
+
+    h_init(&h, valid, ncells, m);
+    res = sttable_create(1024);
+    closed = sttable_create(1024);
+
+    for (i = 0; i < k; i++) {
+        RobotPlan* rp = &robots[i];
+        const int inside = rp->sr > 0 && rp->sr < n - 1 && rp->sc > 0 && rp->sc < m - 1 &&
+                           rp->gr > 0 && rp->gr < n - 1 && rp->gc > 0 && rp->gc < m - 1;
+
+        rp->arrival = -1;
+        rp->cells = NULL;
+        rp->moves = NULL;
+        if (!inside || !valid[rp->sr * m + rp->sc] || !valid[rp->gr * m + rp->gc])
+            continue;
+
+        h_reset(&h, rp->gr * m + rp->gc, rp->sr * m + rp->sc);
+        if (h_get(&h, rp->sr * m + rp->sc) < 0)
+            continue;
+
+        if (st_astar(valid, &h, m, res, lastReserved, closed, rp)) {
+            for (t = 0; t <= rp->arrival; t++)
+                st_reserve(res, n, m, rp->cells[t] / m, rp->cells[t] % m, t, i);
+            if (rp->arrival > lastReserved)
+                lastReserved = rp->arrival;
+            nplanned++;
+        }
+    }
+
+    h_destroy(&h);
+    sttable_destroy(res);
+    sttable_destroy(closed);
+    mem_free(MEM_SEARCH, valid);
+    return nplanned;
+}
+
+void stplan_free(RobotPlan* robots, int k)
+{
+    int i;
+
+    assert(robots != NULL);
+
+    for (i = 0; i < k; i++) {
+        mem_free(MEM_SEARCH, robots[i].cells);
+        mem_free(MEM_SEARCH, robots[i].moves);
+        robots[i].cells = NULL;
+        robots[i].moves = NULL;
+    }
+}
@@ -0,0 +1,55 @@
+/****************************************************************************
+ *
+ * stplan.h -- Pianificazione prioritaria senza collisioni per più robot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef STPLAN_H
+#define STPLAN_H
+
+/* carattere usato nelle mosse per indicare che il robot resta fermo
+   per un istante */
+#define MOVE_WAIT 'F'
+
+/* piano di un singolo robot; le posizioni sono i centri dell'impronta
+   3x3 (riga, colonna) nella mappa */
+typedef struct {
+    int sr, sc;     /* posizione iniziale                            */
+    int gr, gc;     /* stazione di ricarica                          */
+    int arrival;    /* istante di arrivo alla stazione, -1 se il
+                       robot non e' stato pianificato                */
+    int* cells;     /* cells[t] = riga * m + colonna all'istante t,
+                       per t = 0, ..., arrival                       */
+    char* moves;    /* `arrival` mosse N/S/E/O/MOVE_WAIT, terminate
+                       da '\0'                                       */
+} RobotPlan;
+
+/* Pianifica i `k` robot in ordine di priorità (robots[0] ha priorità
+   massima) sulla mappa `matrix` di `n` righe e `m` colonne. Ogni robot
+   calcola un cammino nello spazio-tempo con A* evitando le posizioni
+   già prenotate dai robot precedenti, in modo che le impronte 3x3 di
+   due robot non si sovrappongano mai nello stesso istante. Un robot
+   occupa la propria posizione iniziale dall'istante 0 e, quando
+   raggiunge la stazione, si aggancia e lascia libero il pavimento
+   dall'istante successivo; più robot possono quindi condividere la
+   stessa stazione. Restituisce il numero di robot pianificati; per
+   gli altri `arrival` vale -1. */
+int stplan_prioritized(char** matrix, int n, int m, RobotPlan* robots, int k);
+
+/* Libera la memoria associata ai piani dei `k` robot */
+void stplan_free(RobotPlan* robots, int k);
+
+#endif
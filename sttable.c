@@ -0,0 +1,161 @@
+/****************************************************************************
+ *
+ * sttable.c -- Tabella hash indicizzata da (cella, istante di tempo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "sttable.h"
+#include "memstat.h"
+
+/* compatta la coppia (cella, istante) in una chiave non nulla */
+static uint64_t st_key(int cell, int t)
+{
+    assert(cell >= 0);
+    assert(t >= 0);
+    return (((uint64_t)t << 32) | (uint32_t)cell) + 1;
+}
+
+/* hash moltiplicativo di Fibonacci: usa i bit più significativi del
+   prodotto, che dipendono da tutti i bit della chiave */
+static size_t st_hash(const STTable *tab, uint64_t key)
+{
+    return (size_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> tab->shift);
+}
+
+static void st_alloc(STTable *tab, size_t capacity)
+{
+    int logcap = 0;
+
+    while (((size_t)1 << logcap) < capacity)
+        logcap++;
+    tab->capacity = (size_t)1 << logcap;
+    tab->shift = 64 - logcap;
+    tab->keys = (uint64_t*)mem_calloc(MEM_SEARCH, tab->capacity, sizeof(*(tab->keys)));
+    assert(tab->keys != NULL);
+    tab->vals = (int*)mem_alloc(MEM_SEARCH, tab->capacity * sizeof(*(tab->vals)));
+    assert(tab->vals != NULL);
+    tab->size = 0;
+}
+
+STTable *sttable_create(size_t hint)
+{
+    STTable *tab = (STTable*)mem_alloc(MEM_SEARCH, sizeof(*tab));
+    assert(tab != NULL);
+
+    /* manteniamo il fattore di carico al di sotto di 1/2 */
+    st_alloc(tab, hint < 8 ? 16 : 2 * hint);
+    return tab;
+}
+
+void sttable_destroy(STTable *tab)
+{
+    assert(tab != NULL);
+
+    mem_free(MEM_SEARCH, tab->keys);
+    mem_free(MEM_SEARCH, tab->vals);
+    tab->keys = NULL;
+    tab->vals = NULL;
+    tab->capacity = tab->size = 0;
+    mem_free(MEM_SEARCH, tab);
+}
+
+/* inserisce una chiave sapendo che non è presente e che c'è spazio */
+static void st_insert(STTable *tab, uint64_t key, int val)
+{
+    size_t i = st_hash(tab, key);
+
+    while (tab->keys[i] != 0)
+        i = (i + 1) & (tab->capacity - 1);
+    tab->keys[i] = key;
+    tab->vals[i] = val;
+    tab->size++;
+}
+
+/* raddoppia la capacità reinserendo tutte le chiavi */
+static void st_grow(STTable *tab)
+{
+    uint64_t *oldKeys = tab->keys;
+    int *oldVals = tab->vals;
+    const size_t oldCap = tab->capacity;
+    size_t i;
+
+    st_alloc(tab, 2 * oldCap);
+    for (i = 0; i < oldCap; i++) {
+        if (oldKeys[i] != 0)
+            st_insert(tab, oldKeys[i], oldVals[i]);
+    }
+    mem_free(MEM_SEARCH, oldKeys);
+    mem_free(MEM_SEARCH, oldVals);
+}
+
+void sttable_put(STTable *tab, int cell, int t, int val)
+{
+    const uint64_t key = st_key(cell, t);
+    size_t i;
+
+    assert(tab != NULL);
+    assert(val >= 0);
+
+    if (2 * (tab->size + 1) > tab->capacity)
+        st_grow(tab);
+
+    i = st_hash(tab, key);
+    while (tab->keys[i] != 0) {
+        if (tab->keys[i] == key) {
+            tab->vals[i] = val;
+            return;
+        }
+        i = (i + 1) & (tab->capacity - 1);
+    }
+    tab->keys[i] = key;
+    tab->vals[i] = val;
+    tab->size++;
+}
+
+int sttable_get(const STTable *tab, int cell, int t)
+{
+    const uint64_t key = st_key(cell, t);
+    size_t i;
+
+    assert(tab != NULL);
+
+    i = st_hash(tab, key);
+    while (tab->keys[i] != 0) {
+        if (tab->keys[i] == key)
+            return tab->vals[i];
+        i = (i + 1) & (tab->capacity - 1);
+    }
+    return -1;
+}
+
+void sttable_clear(STTable *tab)
+{
+    assert(tab != NULL);
+
+    memset(tab->keys, 0, tab->capacity * sizeof(*(tab->keys)));
+    tab->size = 0;
+}
+
+size_t sttable_size(const STTable *tab)
+{
+    assert(tab != NULL);
+
+    return tab->size;
+}
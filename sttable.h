@@ -0,0 +1,59 @@
+/****************************************************************************
+ *
+ * sttable.h -- Tabella hash indicizzata da (cella, istante di tempo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef STTABLE_H
+#define STTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tabella hash ad indirizzamento aperto (scansione lineare) che
+   associa un intero non negativo alla coppia (cella, istante). La
+   chiave viene compattata in una parola a 64 bit; il valore 0 indica
+   una posizione libera. */
+typedef struct {
+    uint64_t *keys;     /* chiavi (0 = posizione libera)           */
+    int *vals;          /* valori associati alle chiavi            */
+    size_t capacity;    /* numero di posizioni (potenza di 2)      */
+    size_t size;        /* numero di chiavi presenti               */
+    int shift;          /* 64 - log2(capacity), per la funzione hash */
+} STTable;
+
+/* Crea una tabella vuota in grado di contenere almeno `hint` chiavi
+   senza essere ridimensionata */
+STTable *sttable_create(size_t hint);
+
+/* Distrugge la tabella, liberando tutta la memoria */
+void sttable_destroy(STTable *tab);
+
+/* Associa il valore `val` (>= 0) alla coppia (`cell`, `t`),
+   sovrascrivendo l'eventuale valore precedente */
+void sttable_put(STTable *tab, int cell, int t, int val);
+
+/* Restituisce il valore associato a (`cell`, `t`), oppure -1 se la
+   coppia non è presente */
+int sttable_get(const STTable *tab, int cell, int t);
+
+/* Rimuove tutte le chiavi, mantenendo la memoria allocata */
+void sttable_clear(STTable *tab);
+
+/* Restituisce il numero di chiavi presenti */
+size_t sttable_size(const STTable *tab);
+
+#endif
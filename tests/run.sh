@@ -0,0 +1,269 @@
+#!/bin/sh
+#
+# run.sh -- Casi di regressione del programma bfs
+#
+# Uso: tests/run.sh [percorso_di_bfs]
+#
+# Le mappe vengono copiate in una cartella temporanea, in modo che i
+# file derivati (.out, .alt, .grf, .dst) non finiscano nei sorgenti.
+# Restituisce 0 se tutti i casi passano.
+
+BFS=$(cd "$(dirname "${1:-./bfs}")" && pwd)/$(basename "${1:-./bfs}")
+DIR=$(cd "$(dirname "$0")" && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cp "$DIR"/*.in "$DIR"/*.q "$WORK"/
+cd "$WORK" || exit 1
+failed=0
+
+ok() { echo "ok   $1"; }
+fail() { echo "FAIL $1"; failed=1; }
+
+# numero di mosse (righe dispari) di un file con un percorso per richiesta
+hops() { awk 'NR % 2 == 1' "$1"; }
+
+# confronta il file prodotto `$2` con il risultato atteso `$DIR/$3`
+same() { cmp -s "$2" "$DIR/$3" && ok "$1" || fail "$1"; }
+
+# simula i percorsi del file `$3` (righe alterne: numero di mosse e
+# mosse, -1 per un robot non pianificato) sulla mappa `$1`, partendo
+# dai nodi `$2` separati da virgole. Stampa una riga per ogni
+# posizione non ammessa; con `$4` = apart anche una riga per ogni
+# coppia di robot le cui impronte 3x3 si sovrappongono nello stesso
+# istante (un robot arrivato lascia il pavimento), con `$4` = cover
+# il numero di celle coperte dalle impronte
+walk() {
+    awk -v starts="$2" -v mode="$4" '
+    NR == FNR {
+        if (FNR == 1) { n = $1; m = $2 } else map[FNR - 2] = $0
+        next
+    }
+    FNR == 1 {
+        # numerazione per righe delle posizioni ammesse
+        k = 0
+        for (r = 1; r < n - 1; r++)
+            for (c = 1; c < m - 1; c++) {
+                free = 1
+                for (i = r - 1; i <= r + 1; i++)
+                    if (index(substr(map[i], c, 3), "*")) free = 0
+                if (free) { valid[r, c] = 1; row[k] = r; col[k] = c; k++ }
+            }
+        nr = split(starts, s, ",")
+    }
+    FNR % 2 == 1 { len = $1; next }
+    {
+        j = FNR / 2; r = row[s[j]]; c = col[s[j]]; T[j] = len
+        if (len < 0) next
+        if (length($0) != len) print "robot " j ": " length($0) " mosse invece di " len
+        R[j, 0] = r; C[j, 0] = c
+        for (t = 0; t <= len; t++) {
+            if (t > 0) {
+                d = substr($0, t, 1)
+                if (d == "N") r--; else if (d == "S") r++
+                else if (d == "E") c++; else if (d == "O") c--
+                if (!((r, c) in valid)) print "robot " j ": posizione non ammessa all istante " t
+                R[j, t] = r; C[j, t] = c
+            }
+            for (i = r - 1; i <= r + 1; i++)
+                for (dc = c - 1; dc <= c + 1; dc++)
+                    if (!((i, dc) in covered)) { covered[i, dc] = 1; ncovered++ }
+        }
+    }
+    END {
+        if (mode == "cover") print "coperte " ncovered
+        if (mode != "apart") exit
+        for (a = 1; a <= nr; a++)
+            for (b = a + 1; b <= nr; b++)
+                for (t = 0; t <= T[a] && t <= T[b]; t++) {
+                    dr = R[a, t] - R[b, t]; dc = C[a, t] - C[b, t]
+                    if (dr * dr <= 4 && dc * dc <= 4)
+                        print "robot " a " e " b ": impronte sovrapposte all istante " t
+                }
+    }' "$1" "$3"
+}
+
+# A* con landmark: distanze oltre 65535 sulla mappa a serpentina
+"$BFS" -q serpentine.q -o plain.out serpentine.in > /dev/null || fail "serpentina bfs"
+for k in 1 2 4; do
+    rm -f serpentine.alt
+    "$BFS" -a $k -q serpentine.q -o alt.out serpentine.in > /dev/null &&
+        hops plain.out > a && hops alt.out > b && cmp -s a b && ok "serpentina -a $k" || fail "serpentina -a $k"
+done
+
+# stanze con porte, pilastri e una stanza chiusa: percorsi di
+# riferimento della ricerca in ampiezza
+"$BFS" -q rooms.q -o rooms.out rooms.in > /dev/null
+same "stanze -q" rooms.out rooms.exp
+
+# ricerca sugli intervalli: stesse lunghezze, parità risolte a modo suo
+"$BFS" -i -q rooms.q -o i.out rooms.in > /dev/null
+same "stanze -i" i.out rooms-i.exp
+hops rooms.out > a && hops i.out > b && cmp -s a b && ok "stanze -i lunghezze" || fail "stanze -i lunghezze"
+
+# landmark letti da un file .alt con una distanza alterata (landmark 0
+# del nodo 500, byte 36 + 4 * 500 * 2): il file va scartato e le
+# distanze ricalcolate, altrimenti la coda a tre bucket perde nodi
+rm -f rooms.alt
+"$BFS" -a 2 -q rooms.q -o a.out rooms.in > /dev/null
+printf '\350\003\000\000' | dd of=rooms.alt bs=1 seek=4036 conv=notrunc 2> /dev/null
+"$BFS" -a 2 -q rooms.q -o a.out rooms.in | grep -q "landmark calcolati" &&
+    hops rooms.out > a && hops a.out > b && cmp -s a b && ok "stanze -a con .alt alterato" || fail "stanze -a con .alt alterato"
+
+# istantanea del grafo: il caricamento controlla solo l'intestazione,
+# quindi un file con il numero di nodi alterato (byte 48) o troncato
+# va scartato e il grafo ricostruito dalla mappa
+rm -f rooms.grf
+"$BFS" -g -q rooms.q -o g.out rooms.in > /dev/null
+same "stanze -g (salvato)" g.out rooms.exp
+printf '\005\000\000\000' | dd of=rooms.grf bs=1 seek=48 conv=notrunc 2> /dev/null
+"$BFS" -g -q rooms.q -o g.out rooms.in | grep -q "grafo salvato" &&
+    cmp -s g.out "$DIR/rooms.exp" && ok "stanze -g con .grf alterato" || fail "stanze -g con .grf alterato"
+head -c 9000 rooms.grf > short.grf && mv short.grf rooms.grf
+"$BFS" -g -q rooms.q -o g.out rooms.in | grep -q "grafo salvato" &&
+    cmp -s g.out "$DIR/rooms.exp" && ok "stanze -g con .grf troncato" || fail "stanze -g con .grf troncato"
+"$BFS" -g -q rooms.q -o g.out rooms.in | grep -q "grafo letto" &&
+    cmp -s g.out "$DIR/rooms.exp" && ok "stanze -g (letto)" || fail "stanze -g (letto)"
+
+# visita completa nelle tre direzioni: la versione ibrida sulla mappa
+# delle stanze passa dal basso in alto negli ultimi livelli
+"$BFS" -o single.out 0 1118 rooms.in > /dev/null
+for m in ibrida alto basso; do
+    "$BFS" -D $m -o D.out 0 1118 rooms.in > /dev/null
+    same "stanze -D $m" D.out rooms-D-$m.exp
+    head -n 1 D.out > a && head -n 1 single.out > b && cmp -s a b && ok "stanze -D $m lunghezza" || fail "stanze -D $m lunghezza"
+done
+
+# impronta 5x5: la seconda esecuzione legge la mappa delle distanze
+# dal file .dst; con -f 3 i percorsi sono quelli dell'impronta 3x3
+rm -f rooms.dst
+for run in calcolata letta; do
+    "$BFS" -f 5 -q rooms5.q -o f5.out rooms.in > /dev/null
+    same "stanze -f 5 ($run)" f5.out rooms-f5.exp
+done
+"$BFS" -f 3 -q rooms.q -o f3.out rooms.in > /dev/null
+same "stanze -f 3" f3.out rooms.exp
+
+# percorsi compressi: file atteso e decodifica con -u, che deve
+# restituire i percorsi non compressi (anche per una sola richiesta)
+"$BFS" -z -q rooms.q -o z.out rooms.in > /dev/null
+same "stanze -q -z" z.out rooms-z.exp
+"$BFS" -u z.out -o u.out 2> /dev/null
+same "stanze -q -z / -u" u.out rooms.exp
+"$BFS" -z -o z1.out 0 1118 rooms.in > /dev/null && "$BFS" -u z1.out -o u1.out 2> /dev/null &&
+    cmp -s u1.out single.out && ok "stanze -z / -u" || fail "stanze -z / -u"
+# la decodifica da una pipe non puo' rileggere i byte usati per
+# riconoscere il formato
+mkfifo pipe.z
+"$BFS" -z -q rooms.q -o pipe.z rooms.in > /dev/null &
+"$BFS" -u pipe.z -o up.out 2> /dev/null
+wait
+same "stanze -q -z / -u da una pipe" up.out rooms.exp
+
+# risultati binari: la decodifica con -u deve restituire i percorsi
+# non compressi; un file troncato o con un record che punta fuori dal
+# blob (campo `nmoves` del primo record, byte 52) va rifiutato con
+# un errore, senza leggere fuori dal file
+"$BFS" -b -q rooms.q -o b.out rooms.in > /dev/null
+"$BFS" -u b.out -o ub.out 2> /dev/null
+same "stanze -q -b / -u" ub.out rooms.exp
+head -c 100 b.out > short.out
+"$BFS" -u short.out -o x.out 2> /dev/null
+[ $? -eq 1 ] && ok "binario troncato" || fail "binario troncato"
+cp b.out bad.out
+printf '\377\377\377\377' | dd of=bad.out bs=1 seek=52 conv=notrunc 2> /dev/null
+"$BFS" -u bad.out -o x.out 2> /dev/null
+[ $? -eq 1 ] && ok "binario con mosse errate" || fail "binario con mosse errate"
+
+# manifesto su molte mappe, una richiesta ciascuna: con qualunque
+# numero di thread i risultati sono quelli di -q sulla stessa mappa
+i=0
+while read s d; do
+    i=$((i + 1))
+    cp rooms.in m$i.in
+    echo "m$i.in $s $d"
+done < rooms.q > many.m
+for j in 1 3 8; do
+    "$BFS" -m many.m -j $j -o m.out > /dev/null
+    same "manifesto su 16 mappe -j $j" m.out rooms.exp
+done
+
+# robot senza collisioni: sette robot percorrono in senso inverso i
+# percorsi dei primi sette (uno non trova spazio alla partenza); le
+# mosse restano su posizioni ammesse e in nessun istante due impronte
+# 3x3 si sovrappongono
+robots=1114:487,134:970,975:1107,308:813,960:26,310:474,798:1071
+"$BFS" -c $robots -o c.out 487 1114 rooms.in > /dev/null &&
+    walk rooms.in "487,$(echo $robots | sed 's/:[0-9]*//g')" c.out apart > c.err &&
+    [ ! -s c.err ] && ok "stanze -c senza sovrapposizioni" || fail "stanze -c senza sovrapposizioni"
+
+# copertura completa dal nodo 0: le impronte lungo il percorso
+# coprono, senza uscire dalle posizioni ammesse, le 1396 celle di
+# pavimento raggiungibili dichiarate
+"$BFS" -p -o p.out 0 0 rooms.in | grep -q "copertura: 1396 celle di pavimento su 1458" &&
+    walk rooms.in 0 p.out cover > p.err && echo "coperte 1396" | cmp -s - p.err &&
+    ok "stanze -p" || fail "stanze -p"
+
+# cache dei risultati: la seconda esecuzione legge il risultato dalla
+# cache e lo scrive identico, byte per byte, a quello calcolato
+for o in "" -z; do
+    rm -rf cache
+    "$BFS" $o -k cache -o k1.out 0 1118 rooms.in > /dev/null
+    "$BFS" $o -k cache -o k2.out 0 1118 rooms.in | grep -q "letto dalla cache" &&
+        cmp -s k1.out k2.out && ok "cache -k $o" || fail "cache -k $o"
+done
+cmp -s k1.out z1.out && ok "cache -k -z come -z" || fail "cache -k -z come -z"
+
+# limite di 1 MB con quattro elementi da 300000 byte usati in passato:
+# la prima scrittura legge la cartella (manca il totale) e lascia al
+# più 3/4 del limite eliminando i due elementi più vecchi; il totale è
+# la somma degli elementi rimasti, anche dopo una scrittura che lo
+# aggiorna senza leggere la cartella
+rm -rf cache && mkdir cache
+for i in 1 2 3 4; do
+    head -c 300000 /dev/zero > cache/000000000000000$i.res
+    touch -t 200${i}01010000 cache/000000000000000$i.res
+done
+total() { [ "$(cat cache/totale)" -eq "$(cat cache/*.res | wc -c)" ]; }
+"$BFS" -k cache -K 1 -o x.out 0 1118 rooms.in > /dev/null &&
+    [ ! -e cache/0000000000000001.res ] && [ ! -e cache/0000000000000002.res ] &&
+    [ -e cache/0000000000000003.res ] && [ -e cache/0000000000000004.res ] &&
+    [ $(ls cache/*.res | wc -l) -eq 3 ] && total && ok "cache -K 1 eliminazione" || fail "cache -K 1 eliminazione"
+"$BFS" -k cache -K 1 -o x.out 0 5 rooms.in > /dev/null &&
+    [ $(ls cache/*.res | wc -l) -eq 4 ] && total && ok "cache -K 1 totale" || fail "cache -K 1 totale"
+
+# conteggio della memoria: in ogni modalita' la ricerca (o la tabella
+# dei landmark con -a) compare nel rapporto di -M, e dopo la chiusura
+# non resta memoria allocata in nessun sottosistema
+rm -rf cache
+for o in "" -w "-t 2" "-r 5,26" "-c 970:134" -p -i "-a 4" "-D ibrida" -z -P -g -k -q -b -m; do
+    case $o in
+        -k) args="-k cache 0 1118 rooms.in" ;; # la seconda volta dalla cache
+        -q) args="-q rooms.q rooms.in" ;;
+        -b) args="-b -q rooms.q rooms.in" ;;
+        -m) args="-m many.m" ;;
+        *) args="$o 0 1118 rooms.in" ;;
+    esac
+    case $o in
+        -a*) used=landmark ;;
+        -k|-m) used=mappa ;;
+        *) used=ricerca ;;
+    esac
+    "$BFS" -M -o x.out $args > M.out && "$BFS" -M -o x.out $args >> M.out &&
+        ! grep -q "memoria non liberata" M.out && grep -q " $used [0-9]*/[1-9]" M.out &&
+        ok "memoria -M $o" || fail "memoria -M $o"
+done
+
+# mappa in cui il robot non entra da nessuna parte: il grafo non ha
+# nodi, quindi il nodo 0 va rifiutato in ogni modalita'
+printf '3 4\n....\n.*..\n....\n' > empty.in
+for o in "" -w -D -a -i -p -g; do
+    case $o in
+        -D) args="-D ibrida" ;;
+        -a) args="-a 2" ;;
+        *) args=$o ;;
+    esac
+    "$BFS" $args -o x.out 0 0 empty.in > /dev/null 2>&1
+    [ $? -eq 1 ] && ok "mappa senza posizioni $o" || fail "mappa senza posizioni $o"
+done
+
+exit $failed
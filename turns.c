@@ -0,0 +1,165 @@
+/****************************************************************************
+ *
+ * turns.c -- Cammini minimi che tengono conto delle rotazioni del robot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/***
+Il robot impiega molto più tempo a ruotare che ad avanzare. Per
+tenerne conto si considera lo spazio degli stati $(v, h)$, dove $v$ è
+la posizione (un nodo del grafo) e $h$ l'orientamento. Dallo stato
+$(u, h)$, per ogni arco $(u, v)$ con direzione $h'$ si raggiunge lo
+stato $(v, h')$ con costo $1 + T \cdot r(h, h')$, dove $T$ è la
+penalità di rotazione e $r(h, h')$ il numero di rotazioni di 90 gradi
+(0, 1 oppure 2).
+
+I costi sono interi limitati da $C = 1 + 2T$, quindi si usa la coda a
+bucket ([bucketq.c](bucketq.c)) e la visita costa $O(4(n + m) + C)$.
+Il grafo degli stati ha $4n$ nodi ma nessun arco aggiuntivo: gli archi
+uscenti da $(u, h)$ sono quelli di $u$ nel grafo originale.
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "graph.h"
+#include "list.h"
+#include "bucketq.h"
+#include "turns.h"
+
+/* restituisce la direzione della mossa dal nodo `u` al nodo `v` */
+static Heading edge_heading(const Graph* g, int u, int v)
+{
+    if (graph_node_row(g, v) > graph_node_row(g, u))
+        return HEADING_S;
+    if (graph_node_row(g, v) < graph_node_row(g, u))
+        return HEADING_N;
+    if (graph_node_col(g, v) > graph_node_col(g, u))
+        return HEADING_E;
+    return HEADING_O;
+}
+
+/* numero di rotazioni di 90 gradi per passare da `a` a `b` */
+static int n_rotations(Heading a, Heading b)
+{
+    if (a == b)
+        return 0;
+    /* N/S e E/O sono direzioni opposte */
+    if (a / 2 == b / 2)
+        return 2;
+    return 1;
+}
+
+int turn_search(const Graph* g, int s, int penalty, int weighted, int* d, int* p)
+{
+    const int n = graph_n_nodes(g);
+    const int nstates = N_HEADINGS * n;
+    BucketQueue* q;
+    int maxW = 1;
+    int nreached = 0;
+    int i, h;
+
+    assert((s >= 0) && (s < n));
+    assert(penalty >= 0);
+    assert(d != NULL);
+    assert(p != NULL);
+
+    for (i = 0; i < nstates; i++) {
+        d[i] = -1;
+        p[i] = -1;
+    }
+
+    if (weighted) {
+        for (i = 0; i < n; i++) {
+            const Edge* e;
+            for (e = graph_adj(g, i); e != NULL; e = e->next) {
+                if (e->weight > maxW)
+                    maxW = e->weight;
+            }
+        }
+    }
+
+    q = bucketq_create(maxW + 2 * penalty);
+    for (h = 0; h < N_HEADINGS; h++) {
+        d[TURN_STATE(s, h)] = 0;
+        bucketq_insert(q, TURN_STATE(s, h), 0);
+    }
+
+    while (!bucketq_is_empty(q)) {
+        int du;
+        const int st = bucketq_delete_min(q, &du);
+        const int u = TURN_NODE(st);
+        const Heading hu = TURN_HEADING(st);
+        const Edge* edge;
+
+        if (du > d[st])
+            continue;
+        nreached++;
+        for (edge = graph_adj(g, u); edge != NULL; edge = edge->next) {
+            const Heading hv = edge_heading(g, u, edge->d);
+            const int sv = TURN_STATE(edge->d, hv);
+            const int w = weighted ? edge->weight : 1;
+            int dv;
+
+            if (edge->weight < 0)
+                continue;
+            dv = du + w + penalty * n_rotations(hu, hv);
+            if (d[sv] < 0 || dv < d[sv]) {
+                d[sv] = dv;
+                p[sv] = st;
+                bucketq_insert(q, sv, dv);
+            }
+        }
+    }
+    bucketq_destroy(q);
+    return nreached;
+}
+
+int turn_best_state(int v, const int* d)
+{
+    int h, best = -1;
+
+    assert(d != NULL);
+
+    for (h = 0; h < N_HEADINGS; h++) {
+        const int st = TURN_STATE(v, h);
+        if (d[st] >= 0 && (best < 0 || d[st] < d[best]))
+            best = st;
+    }
+    return best;
+}
+
+int turn_get_path(int st, const int* p, List* path)
+{
+    int nrot = 0;
+
+    assert(p != NULL);
+    assert(path != NULL);
+
+    if (st < 0)
+        return 0;
+    /* risaliamo la catena dei predecessori; il cammino viene
+       costruito a ritroso inserendo in testa alla lista. L'orientamento
+       iniziale è libero, quindi la prima mossa non comporta rotazioni. */
+    while (p[st] >= 0) {
+        list_add_first(path, TURN_NODE(st));
+        if (p[p[st]] >= 0)
+            nrot += n_rotations(TURN_HEADING(p[st]), TURN_HEADING(st));
+        st = p[st];
+    }
+    list_add_first(path, TURN_NODE(st));
+    return nrot;
+}
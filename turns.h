@@ -0,0 +1,58 @@
+/****************************************************************************
+ *
+ * turns.h -- Cammini minimi che tengono conto delle rotazioni del robot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef TURNS_H
+#define TURNS_H
+
+#include "graph.h"
+#include "list.h"
+
+/* direzioni in cui può essere orientato il robot */
+typedef enum { HEADING_N, HEADING_S, HEADING_E, HEADING_O } Heading;
+
+#define N_HEADINGS 4
+
+/* Lo spazio degli stati è formato dalle coppie (nodo, direzione). Gli
+   stati non vengono materializzati come nodi di un nuovo grafo: lo
+   stato (v, h) ha indice `v * N_HEADINGS + h` e i suoi successori si
+   ricavano dalla lista di adiacenza di `v` nel grafo originale. */
+#define TURN_STATE(v, h) ((v) * N_HEADINGS + (h))
+#define TURN_NODE(st) ((st) / N_HEADINGS)
+#define TURN_HEADING(st) ((Heading)((st) % N_HEADINGS))
+
+/* Calcola i cammini di costo minimo dal nodo `s` nello spazio degli
+   stati (nodo, direzione). Ogni mossa costa 1 (oppure il peso
+   dell'arco, se `weighted` è diverso da zero) più `penalty` per ogni
+   rotazione di 90 gradi necessaria per allinearsi alla direzione
+   della mossa; il robot può partire con qualunque orientamento. Gli
+   array `d` e `p` devono avere `N_HEADINGS * n` elementi e vengono
+   riempiti come in `dobfs()`, ma sono indicizzati per stato.
+   Restituisce il numero di stati raggiunti. */
+int turn_search(const Graph* g, int s, int penalty, int weighted, int* d, int* p);
+
+/* Restituisce lo stato di costo minimo associato al nodo `v`, oppure
+   -1 se `v` non è raggiungibile */
+int turn_best_state(int v, const int* d);
+
+/* Inserisce in `path` i nodi del cammino che termina nello stato `st`,
+   dalla sorgente a TURN_NODE(st). Restituisce il numero di rotazioni
+   di 90 gradi effettuate lungo il cammino. */
+int turn_get_path(int st, const int* p, List* path);
+
+#endif